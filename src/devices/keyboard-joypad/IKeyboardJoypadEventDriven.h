@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_IKEYBOARDJOYPADEVENTDRIVEN_H
+#define YARP_DEV_IKEYBOARDJOYPADEVENTDRIVEN_H
+
+#include <yarp/dev/IJoypadController.h>
+
+namespace yarp {
+    namespace dev {
+        class IKeyboardJoypadEventDriven;
+    }
+}
+
+/**
+ * Same methods of yarp::dev::IJoypadEventDriven. That class cannot be used directly since it polls the
+ * getters from its own periodic thread. Here, instead, the events are pushed by the thread sampling the inputs,
+ * as soon as a change is detected, and only for the buttons, axes and sticks that changed.
+ */
+class yarp::dev::IKeyboardJoypadEventDriven
+{
+public:
+    virtual ~IKeyboardJoypadEventDriven() = default;
+
+    /**
+     * Enable or disable the events. When enabling, the event cannot be null.
+     * Once this method returns after disabling the events, the previous event is not called anymore.
+     * The event is called from the thread sampling the inputs, hence it should return quickly,
+     * and it must not call this method.
+     */
+    virtual bool eventDriven(bool enable, yarp::dev::IJoypadEvent* event = nullptr) = 0;
+
+    virtual bool isEventDriven() = 0;
+};
+
+#endif // YARP_DEV_IKEYBOARDJOYPADEVENTDRIVEN_H
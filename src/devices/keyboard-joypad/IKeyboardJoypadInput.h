@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_IKEYBOARDJOYPADINPUT_H
+#define YARP_DEV_IKEYBOARDJOYPADINPUT_H
+
+#include <string>
+
+namespace yarp {
+    namespace dev {
+        class IKeyboardJoypadInput;
+    }
+}
+
+/**
+ * Interface to feed inputs to the keyboardJoypad device from code, e.g. from another device in the same process.
+ * The inputs go through the same mapping used for the keyboard and the joypads. The methods are thread safe.
+ */
+class yarp::dev::IKeyboardJoypadInput
+{
+public:
+    virtual ~IKeyboardJoypadInput() = default;
+
+    /**
+     * Press or release a key. The name follows the syntax used in the "buttons" parameter, e.g. "A", "5", "SPACE" or "UP".
+     */
+    virtual bool setKey(const std::string& key, bool pressed) = 0;
+
+    /**
+     * Set the value, in the range [-1, 1], of an axis of the virtual joypad.
+     * Available only when using the "programmatic" input backend.
+     */
+    virtual bool setJoypadAxis(unsigned int axis_id, float value) = 0;
+
+    /**
+     * Press or release a button of the virtual joypad.
+     * Available only when using the "programmatic" input backend.
+     */
+    virtual bool setJoypadButton(unsigned int button_id, bool pressed) = 0;
+};
+
+#endif // YARP_DEV_IKEYBOARDJOYPADINPUT_H
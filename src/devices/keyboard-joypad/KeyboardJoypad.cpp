@@ -27,19 +27,36 @@
 
 #include <mutex>
 #include <atomic>
+#include <cstdint>
 #include <unordered_map>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <thread>
-#include <sstream>
-#include <iomanip>
+#include <cstdarg>
+#include <charconv>
+#include <string_view>
+#include <cstdio>
+#include <limits>
 
 #include <yarp/os/LogStream.h>
+#include <yarp/os/Stamp.h>
 
 #include <KeyboardJoypad.h>
+#include <KeyboardJoypadAxisPipeline.h>
+#include <KeyboardJoypadGuiRuntime.h>
+#include <KeyboardJoypadInputBackends.h>
+#include <KeyboardJoypadKeyNames.h>
 #include <KeyboardJoypadLogComponent.h>
+#include <KeyboardJoypadMapping.h>
+#include <KeyboardJoypadRecording.h>
+#include <KeyboardJoypadSharedStateWriter.h>
+#include <KeyboardJoypadStatePublisher.h>
+#include <KeyboardJoypadStatistics.h>
+#include <KeyboardJoypadTrace.h>
+#include <KeyboardJoypadWebPanel.h>
 
 struct ButtonValue
 {
@@ -47,130 +64,263 @@ struct ButtonValue
     size_t index = 0;
 };
 
-enum class ButtonType
+struct JoypadAxisInput
 {
-    REGULAR,
-    TOGGLE,
+    int sign = 1;
+    int index = -1; //Negative to disable the input
 };
 
-
+// Configuration of a button, compiled in the MappingTable when opening the device. In the GUI, it is a view of the table.
 struct ButtonState {
     std::string alias;
     ButtonType type{ ButtonType::REGULAR };
     std::vector<ImGuiKey> keys;
     std::vector<ButtonValue> values;
-    std::vector<ButtonValue> joypadAxisInputs;
+    std::vector<JoypadAxisInput> joypadAxisInputs;
     std::vector<int> joypadButtonIndices;
     int col{ 0 };
-    bool active{ false };
-    bool buttonPressed{ false };
+    uint32_t mappingIndex{ 0 }; //Index of the button in the mapping table
 
-    float deadzone(float input, float deadzone) const
+    void render(MappingTable& mapping, const ImVec4& button_active_color, const ImVec4& button_inactive_color, const ImVec2& buttonSize) const
     {
-        if (input > deadzone)
-            return (input - deadzone) / (1.0f - deadzone);
-        else return 0.0;
+        ImGuiStyle& style = ImGui::GetStyle();
+        const ImVec4& buttonColor = mapping.isHighlighted(mappingIndex) ? button_active_color : button_inactive_color;
+        style.Colors[ImGuiCol_Button] = buttonColor;
+        style.Colors[ImGuiCol_ButtonHovered] = buttonColor;
+        style.Colors[ImGuiCol_ButtonActive] = buttonColor;
+
+        // Create a button. The interaction is considered in the next input sample
+        if (ImGui::Button(alias.c_str(), buttonSize))
+        {
+            mapping.markGuiClicked(mappingIndex);
+        }
+        mapping.setGuiKeptPressed(mappingIndex, ImGui::IsItemActive());
+        if (ImGui::IsItemHovered(ImGuiHoveredFlags_ForTooltip))
+        {
+            ImGui::SetTooltip("Pressed %llu times", static_cast<unsigned long long>(mapping.presses(mappingIndex)));
+        }
     }
+};
 
-    void render(const ImVec4& button_active_color, const ImVec4& button_inactive_color,
-                const ImVec2& buttonSize, bool hold_active, double joypadDeadzone,
-                const std::vector<float>& joypadAxisValues, const std::vector<bool>& joypadButtonValues,
-                std::vector<double>& outputValues)
+// Converts the name of a key, as used in the "buttons" parameter, to the corresponding keys. The name is expected uppercase.
+static bool parseKeyName(std::string_view name, std::vector<ImGuiKey>& keys)
+{
+    const KeyName* key_name = keyNameTable.find(name);
+    if (!key_name)
+    {
+        return false;
+    }
+    for (ImGuiKey key : key_name->keys)
     {
-        bool regularButton = type == ButtonType::REGULAR;
-        bool toggleButton = type == ButtonType::TOGGLE;
-        bool anyKeyPressed = false;
-        bool anyKeyReleased = false;
-        for (ImGuiKey key : keys)
+        if (key != ImGuiKey_None)
         {
-            if (ImGui::IsKeyPressed(key))
-            {
-                anyKeyPressed = true;
-            }
-            if (ImGui::IsKeyReleased(key))
-            {
-                anyKeyReleased = true;
-            }
+            keys.push_back(key);
         }
+    }
+    return true;
+}
+
+/**
+ * Grid of buttons drawn directly in the draw list of the window, in place of an ImGui::Button per button.
+ * The layout of the cells and of the labels is cached, and computed again only when the size of the buttons,
+ * the font or the filter change. The whole grid is a single ImGui item, and the cell under the mouse is found
+ * from the cached layout. The quads and the labels share the font texture, hence they are drawn in a single batch.
+ */
+class ButtonGrid
+{
+    struct Cell
+    {
+        const ButtonState* button;
+        ImVec2 offset; //Of the top left corner, from the origin of the grid
+        ImVec2 label_offset; //From the top left corner of the cell
+    };
+
+    std::vector<Cell> m_cells; //Sorted by row
+    std::vector<size_t> m_rows_begin; //Index of the first cell of each row, followed by the number of cells
+    ImVec2 m_size;
+    float m_row_pitch{ 0.0f };
+    float m_column_pitch{ 0.0f };
+    float m_button_size{ -1.0f };
+    float m_font_size{ -1.0f };
+    bool m_filtering{ false };
+    std::string m_filter;
+    const ButtonState* m_pressed_button{ nullptr }; //Pressed with the mouse, while the grid is active
+    int64_t m_kept_pressed{ -1 }; //Mapping index of the button kept pressed in the last frame
+
+    bool filterChanged(const ImGuiTextFilter* filter) const
+    {
+        bool filtering = filter && filter->IsActive();
+        return filtering != m_filtering || (filtering && m_filter != filter->InputBuf);
+    }
 
-        for (int i : joypadButtonIndices)
+    void addCell(const ButtonState& button, size_t row, size_t column)
+    {
+        ImVec2 label_size = ImGui::CalcTextSize(button.alias.c_str(), nullptr, true);
+        const ImVec2& padding = ImGui::GetStyle().FramePadding;
+        ImVec2 label_offset(std::max(padding.x, 0.5f * (m_button_size - label_size.x)),
+                            std::max(padding.y, 0.5f * (m_button_size - label_size.y)));
+        while (m_rows_begin.size() <= row)
         {
-            if (i >= 0 && i < joypadButtonValues.size())
-            {
-                if (joypadButtonValues[static_cast<size_t>(i)])
-                {
-                    anyKeyPressed = true;
-                }
-                else
-                {
-                    anyKeyReleased = true;
-                }
-            }
-            else if (i >= 0 && joypadButtonValues.size() > 0)
-            {
-                yCErrorOnce(KEYBOARDJOYPAD) << "The joypad button index" << i << "is out of range.";
-            }
+            m_rows_begin.push_back(m_cells.size());
         }
+        m_cells.push_back({ &button, ImVec2(column * m_column_pitch, row * m_row_pitch), label_offset });
+    }
 
-        float valueFromJoypadAxes = 0.0;
-        for (auto& axis : joypadAxisInputs)
+    // The cell containing the position, relative to the origin of the grid, -1 if none
+    int64_t cellAt(float x, float y) const
+    {
+        if (x < 0.0f || y < 0.0f || m_row_pitch <= 0.0f)
         {
-            if (axis.index >= 0 && axis.index < joypadAxisValues.size())
-            {
-                valueFromJoypadAxes += deadzone(axis.sign * joypadAxisValues[static_cast<size_t>(axis.index)], static_cast<float>(joypadDeadzone));
-            }
-            else if (axis.index >= 0 && joypadAxisValues.size() > 0)
+            return -1;
+        }
+        size_t row = static_cast<size_t>(y / m_row_pitch);
+        if (row + 1 >= m_rows_begin.size())
+        {
+            return -1;
+        }
+        for (size_t i = m_rows_begin[row]; i < m_rows_begin[row + 1]; ++i)
+        {
+            const Cell& cell = m_cells[i];
+            if (x >= cell.offset.x && x < cell.offset.x + m_button_size && y < cell.offset.y + m_button_size)
             {
-                yCError(KEYBOARDJOYPAD) << "The joypad axis index" << axis.index << "is out of range.";
-                axis.index = -1;
+                return static_cast<int64_t>(i);
             }
         }
+        return -1;
+    }
 
-        if (anyKeyPressed)
+public:
+    // Computes the layout, if anything changed since the last call. The buttons passing the filter, if active, are laid out again in rows.
+    void layout(const std::vector<std::vector<ButtonState>>& rows, int columns, float button_size, const ImGuiTextFilter* filter)
+    {
+        float font_size = ImGui::GetFontSize();
+        if (button_size == m_button_size && font_size == m_font_size && !filterChanged(filter))
         {
-            buttonPressed = true;
-            if (toggleButton || (regularButton && !hold_active))
+            return;
+        }
+        m_button_size = button_size;
+        m_font_size = font_size;
+        m_filtering = filter && filter->IsActive();
+        m_filter = m_filtering ? filter->InputBuf : "";
+        const ImVec2& spacing = ImGui::GetStyle().ItemSpacing;
+        m_column_pitch = button_size + spacing.x;
+        m_row_pitch = button_size + spacing.y;
+
+        m_cells.clear();
+        m_rows_begin.clear();
+        size_t number_of_rows = 0;
+        if (m_filtering)
+        {
+            size_t index = 0;
+            for (auto& row : rows)
             {
-                active = true;
+                for (auto& button : row)
+                {
+                    if (filter->PassFilter(button.alias.c_str()))
+                    {
+                        this->addCell(button, index / columns, index % columns);
+                        index++;
+                    }
+                }
             }
-            else
+            number_of_rows = (index + columns - 1) / columns;
+        }
+        else
+        {
+            for (size_t i = 0; i < rows.size(); ++i)
             {
-                active = !active;
+                for (auto& button : rows[i])
+                {
+                    this->addCell(button, i, static_cast<size_t>(button.col));
+                }
             }
+            number_of_rows = rows.size(); //Including the empty rows
         }
-        else if (buttonPressed && anyKeyReleased)
+        while (m_rows_begin.size() <= number_of_rows)
         {
-            buttonPressed = false;
-            if (toggleButton || (regularButton && !hold_active))
-                active = false;
+            m_rows_begin.push_back(m_cells.size());
         }
+        m_size = ImVec2(columns * m_column_pitch - spacing.x, number_of_rows * m_row_pitch - spacing.y);
+        m_size.y = std::max(m_size.y, 0.0f);
+    }
 
-        ImGuiStyle& style = ImGui::GetStyle();
-        const ImVec4& buttonColor = active || valueFromJoypadAxes > 0 ? button_active_color : button_inactive_color;
-        style.Colors[ImGuiCol_Button] = buttonColor;
-        style.Colors[ImGuiCol_ButtonHovered] = buttonColor;
-        style.Colors[ImGuiCol_ButtonActive] = buttonColor;
+    const ImVec2& size() const
+    {
+        return m_size;
+    }
+
+    float rowPitch() const
+    {
+        return m_row_pitch;
+    }
 
-        // Create a button
-        bool buttonReleased = ImGui::Button(alias.c_str(), buttonSize);
-        bool buttonKeptPressed = ImGui::IsItemActive();
+    // Draws the visible rows at the cursor position, and handles the mouse
+    void render(const char* id, MappingTable& mapping, const ImVec4& button_active_color, const ImVec4& button_inactive_color)
+    {
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        ImGui::InvisibleButton(id, ImVec2(std::max(m_size.x, 1.0f), std::max(m_size.y, 1.0f)));
+
+        ImVec2 mouse = ImGui::GetMousePos();
+        int64_t hovered_cell = ImGui::IsItemHovered() ? this->cellAt(mouse.x - origin.x, mouse.y - origin.y) : -1;
+        const ButtonState* hovered_button = hovered_cell >= 0 ? m_cells[static_cast<size_t>(hovered_cell)].button : nullptr;
 
-        if (buttonReleased && (toggleButton || (regularButton && hold_active)))
+        // As with ImGui::Button, a click is a release over the same button that was pressed.
+        // The interaction is considered in the next input sample.
+        if (ImGui::IsItemActivated())
+        {
+            m_pressed_button = hovered_button;
+        }
+        if (ImGui::IsItemDeactivated() && m_pressed_button && m_pressed_button == hovered_button)
+        {
+            mapping.markGuiClicked(m_pressed_button->mappingIndex);
+        }
+        if (!ImGui::IsItemActive())
+        {
+            m_pressed_button = nullptr;
+        }
+        // Only the button kept pressed and the one released are updated, in place of all the buttons
+        int64_t kept_pressed = m_pressed_button ? static_cast<int64_t>(m_pressed_button->mappingIndex) : -1;
+        if (m_kept_pressed >= 0 && kept_pressed != m_kept_pressed)
         {
-            active = !active; //Toggle the button
+            mapping.setGuiKeptPressed(static_cast<uint32_t>(m_kept_pressed), false);
         }
-        else if (regularButton && buttonKeptPressed && !hold_active) //The button is clicked and is not a toggling button
+        if (kept_pressed >= 0)
         {
-            active = true;
+            mapping.setGuiKeptPressed(static_cast<uint32_t>(kept_pressed), true);
         }
-        else if (regularButton && !buttonPressed && !hold_active) //The button is not clicked and is not a toggling button
+        m_kept_pressed = kept_pressed;
+
+        if (hovered_button && ImGui::IsItemHovered(ImGuiHoveredFlags_ForTooltip))
         {
-            active = false;
+            ImGui::SetTooltip("Pressed %llu times", static_cast<unsigned long long>(mapping.presses(hovered_button->mappingIndex)));
         }
 
-        for (auto& value : values)
+        if (m_cells.empty())
         {
-            outputValues[value.index] += value.sign * (active + valueFromJoypadAxes);
+            return;
+        }
+
+        ImDrawList* draw_list = ImGui::GetWindowDrawList();
+        float visible_top = draw_list->GetClipRectMin().y - origin.y;
+        float visible_bottom = draw_list->GetClipRectMax().y - origin.y;
+        size_t number_of_rows = m_rows_begin.size() - 1;
+        size_t first_row = static_cast<size_t>(std::clamp(std::floor(visible_top / m_row_pitch), 0.0f, static_cast<float>(number_of_rows)));
+        size_t last_row = static_cast<size_t>(std::clamp(std::ceil(visible_bottom / m_row_pitch), 0.0f, static_cast<float>(number_of_rows)));
+
+        ImU32 active_color = ImGui::ColorConvertFloat4ToU32(button_active_color);
+        ImU32 inactive_color = ImGui::ColorConvertFloat4ToU32(button_inactive_color);
+        ImU32 text_color = ImGui::GetColorU32(ImGuiCol_Text);
+        float rounding = ImGui::GetStyle().FrameRounding;
+        ImFont* font = ImGui::GetFont();
+        for (size_t i = m_rows_begin[first_row]; i < m_rows_begin[last_row]; ++i)
+        {
+            const Cell& cell = m_cells[i];
+            ImVec2 min(origin.x + cell.offset.x, origin.y + cell.offset.y);
+            ImVec2 max(min.x + m_button_size, min.y + m_button_size);
+            draw_list->AddRectFilled(min, max, mapping.isHighlighted(cell.button->mappingIndex) ? active_color : inactive_color, rounding);
+            ImVec4 label_clip(min.x, min.y, max.x, max.y);
+            draw_list->AddText(font, m_font_size, ImVec2(min.x + cell.label_offset.x, min.y + cell.label_offset.y), text_color,
+                               cell.button->alias.c_str(), nullptr, 0.0f, &label_clip);
         }
     }
 };
@@ -180,6 +330,46 @@ struct ButtonsTable
     std::vector<std::vector<ButtonState>> rows;
     int numberOfColumns { 0 };
     std::string name;
+    ButtonGrid grid;
+};
+
+// Text formatted in a buffer that is reused across frames, so that no memory is allocated once it is large enough
+class TextBuffer
+{
+    std::vector<char> m_buffer = std::vector<char>(256, '\0');
+    size_t m_size{ 0 };
+
+public:
+    void clear()
+    {
+        m_size = 0;
+        m_buffer[0] = '\0';
+    }
+
+    void append(const char* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        va_list args_copy;
+        va_copy(args_copy, args);
+        int written = std::vsnprintf(m_buffer.data() + m_size, m_buffer.size() - m_size, format, args);
+        va_end(args);
+        if (written > 0 && m_size + static_cast<size_t>(written) >= m_buffer.size())
+        {
+            m_buffer.resize(2 * (m_size + static_cast<size_t>(written) + 1));
+            std::vsnprintf(m_buffer.data() + m_size, m_buffer.size() - m_size, format, args_copy);
+        }
+        va_end(args_copy);
+        if (written > 0)
+        {
+            m_size += static_cast<size_t>(written);
+        }
+    }
+
+    const char* c_str() const
+    {
+        return m_buffer.data();
+    }
 };
 
 static bool parseFloat(yarp::os::Searchable& cfg, const std::string& key, float min_value, float max_value, float& value)
@@ -230,6 +420,94 @@ static bool parseInt(yarp::os::Searchable& cfg, const std::string& key, int min_
     return true;
 }
 
+// Parses a single non negative integer, or a list of them. If the key is not present, the list is left empty.
+static bool parseIndexList(yarp::os::Searchable& cfg, const std::string& key, std::vector<uint32_t>& values)
+{
+    values.clear();
+    if (!cfg.check(key))
+    {
+        return true;
+    }
+
+    yarp::os::Value& value = cfg.find(key);
+    if (value.isInt64() || value.isInt32())
+    {
+        if (value.asInt64() < 0)
+        {
+            yCError(KEYBOARDJOYPAD) << "The value of" << key << "cannot be negative.";
+            return false;
+        }
+        values.push_back(static_cast<uint32_t>(value.asInt64()));
+        return true;
+    }
+
+    if (!value.isList())
+    {
+        yCError(KEYBOARDJOYPAD) << "The value of" << key << "should be either an integer or a list of integers.";
+        return false;
+    }
+
+    yarp::os::Bottle* list = value.asList();
+    for (size_t i = 0; i < list->size(); ++i)
+    {
+        if ((!list->get(i).isInt64() && !list->get(i).isInt32()) || list->get(i).asInt64() < 0)
+        {
+            yCError(KEYBOARDJOYPAD) << "The value at index" << i << "of" << key << "is not a non negative integer.";
+            return false;
+        }
+        values.push_back(static_cast<uint32_t>(list->get(i).asInt64()));
+    }
+    return true;
+}
+
+// Reads either a single number, used for all the values, or a list with one number for each value
+static bool parseFloatList(yarp::os::Searchable& cfg, const std::string& key, float min_value, float max_value, std::vector<float>& values)
+{
+    if (!cfg.check(key))
+    {
+        yCInfo(KEYBOARDJOYPAD) << "The key" << key << "is not present in the configuration file."
+                               << "Using the default value:" << (values.empty() ? 0.0f : values.front());
+        return true;
+    }
+
+    yarp::os::Value& value = cfg.find(key);
+    if (value.isFloat64() || value.isInt64() || value.isInt32())
+    {
+        float input = static_cast<float>(value.asFloat64());
+        if (input < min_value || input > max_value)
+        {
+            yCError(KEYBOARDJOYPAD) << "The value of " << key << " is out of range. It should be between" << min_value << "and" << max_value;
+            return false;
+        }
+        std::fill(values.begin(), values.end(), input);
+        return true;
+    }
+
+    if (!value.isList() || value.asList()->size() != values.size())
+    {
+        yCError(KEYBOARDJOYPAD) << "The value of " << key << " should be either a number, or a list of" << values.size() << "numbers";
+        return false;
+    }
+
+    yarp::os::Bottle* list = value.asList();
+    for (size_t i = 0; i < list->size(); ++i)
+    {
+        if (!list->get(i).isFloat64() && !list->get(i).isInt64() && !list->get(i).isInt32())
+        {
+            yCError(KEYBOARDJOYPAD) << "The value at index" << i << "of" << key << "is not a number.";
+            return false;
+        }
+        float input = static_cast<float>(list->get(i).asFloat64());
+        if (input < min_value || input > max_value)
+        {
+            yCError(KEYBOARDJOYPAD) << "The value at index" << i << "of" << key << "is out of range. It should be between" << min_value << "and" << max_value;
+            return false;
+        }
+        values[i] = input;
+    }
+    return true;
+}
+
 struct Settings {
     float button_size = 100;
     float min_button_size = 50;
@@ -238,14 +516,39 @@ struct Settings {
     float min_font_multiplier = 0.5;
     float max_font_multiplier = 4.0;
     float gui_period = 0.033f;
+    float input_period = 0.033f;
     float deadzone = 0.1f;
     float padding = 100;
     int window_width = 1280;
     int window_height = 720;
     int buttons_per_row = 3;
     bool allow_window_closing = false;
+    bool headless = false;
+    bool offscreen = false;
+    std::string offscreen_context_api = "egl";
+    std::string input_backend = "joystick";
+    int virtual_joypad_axes = 4;
+    int virtual_joypad_buttons = 16;
+    std::string record_file;
+    std::string replay_file;
+    float replay_speed = 1.0f;
+    std::string name = "/keyboardJoypad";
+    float stats_period = 0.0f;
+    bool state_port = false;
+    float state_keyframe_period = 1.0f;
+    bool state_quantize_int16 = false;
+    std::string shared_memory_name;
+    int shared_memory_frames = 256;
+    int web_panel_port = 0;
+    std::string web_panel_address = "127.0.0.1";
+    std::string trace_file;
+    float trace_file_size = 64.0f; //MB
+    int trace_files = 2;
     std::atomic<bool> single_threaded { false };
     std::vector<int> joypad_indices;
+    std::vector<uint32_t> passthrough_axes;
+    std::vector<uint32_t> passthrough_buttons;
+    std::vector<uint32_t> passthrough_hats;
 
     bool parseFromConfigFile(yarp::os::Searchable& cfg)
     {
@@ -284,6 +587,19 @@ struct Settings {
             return false;
         }
 
+        input_period = gui_period; //By default, the inputs are sampled at the same rate of the GUI
+        if (!parseFloat(cfg, "input_period", 1e-4f, 1e5f, input_period))
+        {
+            return false;
+        }
+
+        if (input_period > gui_period)
+        {
+            yCWarning(KEYBOARDJOYPAD) << "The \"input_period\" (" << input_period << ") is greater than the \"gui_period\" ("
+                                      << gui_period << "). Using the \"gui_period\" also for the inputs.";
+            input_period = gui_period;
+        }
+
         if (!parseFloat(cfg, "joypad_deadzone", 0.f, 1.f, deadzone))
         {
             return false;
@@ -319,103 +635,277 @@ struct Settings {
                                    << "Using the default value:" << allow_window_closing;
         }
 
-        //If macOs, the GUI thread must be the main thread. Hence use no GUI thread
-#ifdef __APPLE__
-        single_threaded = true;
-        yCWarning(KEYBOARDJOYPAD) << "In macOS the GUI thread should be the main thread. Hence, we are using true as default for \"no_gui_thread\"";
-
-#endif //__APPLE__
-
-
-        if (cfg.check("no_gui_thread"))
+        if (cfg.check("headless"))
         {
-            single_threaded = cfg.find("no_gui_thread").isNull() || cfg.find("no_gui_thread").asBool();
+            headless = cfg.find("headless").isNull() || cfg.find("headless").asBool();
         }
         else
         {
-            yCInfo(KEYBOARDJOYPAD) << "The key \"no_gui_thread\" is not present in the configuration file."
-                                   << "Using the default value:" << static_cast<bool>(single_threaded);
+            yCInfo(KEYBOARDJOYPAD) << "The key \"headless\" is not present in the configuration file."
+                                   << "Using the default value:" << headless;
         }
 
-        if (single_threaded && allow_window_closing)
+        if (headless && allow_window_closing)
         {
-            yCError(KEYBOARDJOYPAD) << "The configuration file is invalid. The keys \"no_gui_thread\" and \"allow_window_closing\" cannot be both true.";
+            yCWarning(KEYBOARDJOYPAD) << "\"allow_window_closing\" is ignored since the device is running in headless mode.";
+            allow_window_closing = false;
+        }
+
+        if (cfg.check("offscreen"))
+        {
+            offscreen = cfg.find("offscreen").isNull() || cfg.find("offscreen").asBool();
+        }
+
+        if (offscreen && headless)
+        {
+            yCError(KEYBOARDJOYPAD) << "\"offscreen\" and \"headless\" cannot be used together. In headless mode there is no GUI to render.";
             return false;
         }
 
-        if (cfg.check("joypad_indices"))
+        if (offscreen && allow_window_closing)
         {
-            yarp::os::Value joypadsValue = cfg.find("joypad_indices");
-            if (joypadsValue.isInt32() || joypadsValue.isInt64())
+            yCWarning(KEYBOARDJOYPAD) << "\"allow_window_closing\" is ignored since the device is rendering offscreen.";
+            allow_window_closing = false;
+        }
+
+        if (cfg.check("offscreen_context_api"))
+        {
+            offscreen_context_api = cfg.find("offscreen_context_api").asString();
+            if (offscreen_context_api != "egl" && offscreen_context_api != "osmesa")
             {
-                int joypad_index = static_cast<int>(joypadsValue.asInt64());
-                if (joypad_index > GLFW_JOYSTICK_LAST)
-                {
-                    yCError(KEYBOARDJOYPAD) << "The value of \"joypad_indices\" is out of range."
-                        << "It should be between" << GLFW_JOYSTICK_1 << "and" << GLFW_JOYSTICK_LAST;
-                    return false;
-                }
-                if (joypad_index >= GLFW_JOYSTICK_1)
-                {
-                    joypad_indices.push_back(joypad_index);
-                }
+                yCError(KEYBOARDJOYPAD) << "The value of \"offscreen_context_api\" (" << offscreen_context_api << ") is not valid."
+                                        << "Allowed values: \"egl\", \"osmesa\".";
+                return false;
             }
-            else if (!joypadsValue.isList())
+        }
+
+        if (cfg.check("input_backend"))
+        {
+            input_backend = cfg.find("input_backend").asString();
+            if (input_backend != "joystick" && input_backend != "programmatic" && input_backend != "replay")
             {
-                yCError(KEYBOARDJOYPAD) << "\"joypad_indices\" is found but it is neither an int nor a list.";
+                yCError(KEYBOARDJOYPAD) << "The value of \"input_backend\" (" << input_backend << ") is not valid."
+                                        << "Allowed values: \"joystick\", \"programmatic\", \"replay\".";
                 return false;
             }
-
-            yarp::os::Bottle* joypads_index_list = joypadsValue.asList();
-
-            for (size_t i = 0; i < joypads_index_list->size(); i++)
+            if (!headless)
             {
-                if (!joypads_index_list->get(i).isInt64() && !joypads_index_list->get(i).isInt32())
-                {
-                    yCError(KEYBOARDJOYPAD) << "The value at index" << i << "of the \"joypad_indices\" list is not an integer.";
-                    return false;
-                }
-
-                int joypad_index = static_cast<int>(joypads_index_list->get(i).asInt64());
-                if (joypad_index < GLFW_JOYSTICK_1 || joypad_index > GLFW_JOYSTICK_LAST)
-                {
-                    yCError(KEYBOARDJOYPAD) << "The value at index" << i << "of the joypads_index list is out of range."
-                        << "It should be between" << GLFW_JOYSTICK_1 << "and" << GLFW_JOYSTICK_LAST;
-                    return false;
-                }
-
-                joypad_indices.push_back(joypad_index);
+                yCWarning(KEYBOARDJOYPAD) << "\"input_backend\" is considered only in headless mode. The keyboard and the joypads are read from the window.";
             }
         }
-        else
+        else if (headless)
         {
-            yCInfo(KEYBOARDJOYPAD) << "The key \"joypads_index\" is not present in the configuration file."
-                                   << "Using only the joypad with index 0 (if present).";
-            joypad_indices.push_back(GLFW_JOYSTICK_1);
+            yCInfo(KEYBOARDJOYPAD) << "The key \"input_backend\" is not present in the configuration file."
+                                   << "Using the default value:" << input_backend;
         }
 
-        return true;
-    }
-};
-
-enum class Axis
-{
-    WS = 0,
-    AD = 1,
-    UP_DOWN = 2,
-    LEFT_RIGHT = 3
-};
+        if (!parseInt(cfg, "virtual_joypad_axes", 0, 1000, virtual_joypad_axes))
+        {
+            return false;
+        }
 
-struct AxisSettings
-{
-    int sign;
-    size_t index;
-};
+        if (!parseInt(cfg, "virtual_joypad_buttons", 0, 1000, virtual_joypad_buttons))
+        {
+            return false;
+        }
 
-struct AxesSettings
-{
-    std::unordered_map<Axis, std::vector<AxisSettings>> axes;
-    size_t number_of_axes = 0;
+        if (cfg.check("record_file"))
+        {
+            record_file = cfg.find("record_file").asString();
+        }
+
+        if (cfg.check("replay_file"))
+        {
+            replay_file = cfg.find("replay_file").asString();
+        }
+
+        if (headless && input_backend == "replay" && replay_file.empty())
+        {
+            yCError(KEYBOARDJOYPAD) << "The \"replay\" input backend requires \"replay_file\".";
+            return false;
+        }
+
+        if (!record_file.empty() && record_file == replay_file)
+        {
+            yCError(KEYBOARDJOYPAD) << "\"record_file\" and \"replay_file\" cannot be the same file.";
+            return false;
+        }
+
+        if (!parseFloat(cfg, "replay_speed", 0.0f, 1e6f, replay_speed))
+        {
+            return false;
+        }
+
+        if (cfg.check("name"))
+        {
+            name = cfg.find("name").asString();
+        }
+
+        if (!parseFloat(cfg, "stats_period", 0.0f, 1e4f, stats_period))
+        {
+            return false;
+        }
+
+        if (cfg.check("state_port"))
+        {
+            state_port = cfg.find("state_port").isNull() || cfg.find("state_port").asBool();
+        }
+
+        if (!parseFloat(cfg, "state_keyframe_period", 0.0f, 1e4f, state_keyframe_period))
+        {
+            return false;
+        }
+
+        if (cfg.check("state_quantize_int16"))
+        {
+            state_quantize_int16 = cfg.find("state_quantize_int16").isNull() || cfg.find("state_quantize_int16").asBool();
+        }
+
+        if (cfg.check("shared_memory_name"))
+        {
+            shared_memory_name = cfg.find("shared_memory_name").asString();
+            if (!shared_memory_name.empty()
+                && (shared_memory_name.front() != '/' || shared_memory_name.find('/', 1) != std::string::npos))
+            {
+                yCError(KEYBOARDJOYPAD) << "\"shared_memory_name\" must start with \"/\" and contain no other \"/\".";
+                return false;
+            }
+        }
+
+        if (!parseInt(cfg, "shared_memory_frames", 1, 65536, shared_memory_frames))
+        {
+            return false;
+        }
+
+        if (!parseInt(cfg, "web_panel_port", 0, 65535, web_panel_port))
+        {
+            return false;
+        }
+
+        if (cfg.check("web_panel_address"))
+        {
+            web_panel_address = cfg.find("web_panel_address").asString();
+        }
+
+        if (cfg.check("trace_file"))
+        {
+            trace_file = cfg.find("trace_file").asString();
+        }
+
+        if (!parseFloat(cfg, "trace_file_size", 0.001f, 1e6f, trace_file_size))
+        {
+            return false;
+        }
+
+        if (!parseInt(cfg, "trace_files", 1, 100, trace_files))
+        {
+            return false;
+        }
+
+        //If macOs, the GUI thread must be the main thread. Hence use no GUI thread
+#ifdef __APPLE__
+        single_threaded = true;
+        yCWarning(KEYBOARDJOYPAD) << "In macOS the GUI thread should be the main thread. Hence, we are using true as default for \"no_gui_thread\"";
+
+#endif //__APPLE__
+
+
+        if (cfg.check("no_gui_thread"))
+        {
+            single_threaded = cfg.find("no_gui_thread").isNull() || cfg.find("no_gui_thread").asBool();
+        }
+        else
+        {
+            yCInfo(KEYBOARDJOYPAD) << "The key \"no_gui_thread\" is not present in the configuration file."
+                                   << "Using the default value:" << static_cast<bool>(single_threaded);
+        }
+
+        if (single_threaded && allow_window_closing)
+        {
+            yCError(KEYBOARDJOYPAD) << "The configuration file is invalid. The keys \"no_gui_thread\" and \"allow_window_closing\" cannot be both true.";
+            return false;
+        }
+
+        if (cfg.check("joypad_indices"))
+        {
+            yarp::os::Value joypadsValue = cfg.find("joypad_indices");
+            if (joypadsValue.isInt32() || joypadsValue.isInt64())
+            {
+                int joypad_index = static_cast<int>(joypadsValue.asInt64());
+                if (joypad_index > GLFW_JOYSTICK_LAST)
+                {
+                    yCError(KEYBOARDJOYPAD) << "The value of \"joypad_indices\" is out of range."
+                        << "It should be between" << GLFW_JOYSTICK_1 << "and" << GLFW_JOYSTICK_LAST;
+                    return false;
+                }
+                if (joypad_index >= GLFW_JOYSTICK_1)
+                {
+                    joypad_indices.push_back(joypad_index);
+                }
+            }
+            else if (!joypadsValue.isList())
+            {
+                yCError(KEYBOARDJOYPAD) << "\"joypad_indices\" is found but it is neither an int nor a list.";
+                return false;
+            }
+
+            yarp::os::Bottle* joypads_index_list = joypadsValue.asList();
+
+            for (size_t i = 0; i < joypads_index_list->size(); i++)
+            {
+                if (!joypads_index_list->get(i).isInt64() && !joypads_index_list->get(i).isInt32())
+                {
+                    yCError(KEYBOARDJOYPAD) << "The value at index" << i << "of the \"joypad_indices\" list is not an integer.";
+                    return false;
+                }
+
+                int joypad_index = static_cast<int>(joypads_index_list->get(i).asInt64());
+                if (joypad_index < GLFW_JOYSTICK_1 || joypad_index > GLFW_JOYSTICK_LAST)
+                {
+                    yCError(KEYBOARDJOYPAD) << "The value at index" << i << "of the joypads_index list is out of range."
+                        << "It should be between" << GLFW_JOYSTICK_1 << "and" << GLFW_JOYSTICK_LAST;
+                    return false;
+                }
+
+                joypad_indices.push_back(joypad_index);
+            }
+        }
+        else
+        {
+            yCInfo(KEYBOARDJOYPAD) << "The key \"joypads_index\" is not present in the configuration file."
+                                   << "Using only the joypad with index 0 (if present).";
+            joypad_indices.push_back(GLFW_JOYSTICK_1);
+        }
+
+        if (!parseIndexList(cfg, "passthrough_joypad_axes", passthrough_axes)
+            || !parseIndexList(cfg, "passthrough_joypad_buttons", passthrough_buttons)
+            || !parseIndexList(cfg, "passthrough_joypad_hats", passthrough_hats))
+        {
+            return false;
+        }
+
+        return true;
+    }
+};
+
+enum class Axis
+{
+    WS = 0,
+    AD = 1,
+    UP_DOWN = 2,
+    LEFT_RIGHT = 3
+};
+
+struct AxisSettings
+{
+    int sign;
+    size_t index;
+};
+
+struct AxesSettings
+{
+    std::unordered_map<Axis, std::vector<AxisSettings>> axes;
+    size_t number_of_axes = 0;
 
     std::string wasd_label = "WASD";
     std::string arrows_label = "Arrows";
@@ -423,6 +913,12 @@ struct AxesSettings
     int ws_joypad_axis_index = 1;
     int left_right_joypad_axis_index = 2;
     int up_down_joypad_axis_index = 3;
+    bool radial_deadzone = false;
+    float centering_time = 0.0f;
+    float centering_window = 0.1f;
+    std::vector<float> expo;
+    std::vector<float> slew_rate;
+    std::vector<float> low_pass_cutoff;
 
     bool parseFromConfigFile(yarp::os::Searchable& cfg)
     {
@@ -525,92 +1021,387 @@ struct AxesSettings
             }
         }
 
-        return true;
-    }
-};
-
-struct JoypadInfo
-{
-    std::string name;
-    int index;
-    int axes;
-    int buttons;
-    size_t axes_offset;
-    size_t buttons_offset;
-    bool active;
-};
-
-class yarp::dev::KeyboardJoypad::Impl
-{
-public:
-    GLFWwindow* window = nullptr;
-
-    std::atomic_bool need_to_close{false}, closed{false}, initialized{false};
-
-    std::mutex mutex;
-
-    ImVec4 button_inactive_color;
-    ImVec4 button_active_color;
+        if (cfg.check("joypad_radial_deadzone"))
+        {
+            radial_deadzone = cfg.find("joypad_radial_deadzone").isNull() || cfg.find("joypad_radial_deadzone").asBool();
+        }
+        else
+        {
+            yCInfo(KEYBOARDJOYPAD) << "The key \"joypad_radial_deadzone\" is not present in the configuration file."
+                                   << "Using the default value:" << radial_deadzone;
+        }
 
-    Settings settings;
-    AxesSettings axes_settings;
+        if (!parseFloat(cfg, "joypad_centering_time", 0.0f, 1e4f, centering_time))
+        {
+            return false;
+        }
 
-    std::vector<ButtonsTable> sticks;
-    std::vector<std::vector<size_t>> sticks_to_axes;
-    ButtonsTable buttons;
-    ButtonState ctrl_button;
-    std::vector<double> ctrl_value;
-    std::vector<double> axes_values;
-    std::vector<std::vector<double>> sticks_values;
-    std::vector<double> buttons_values;
+        if (!parseFloat(cfg, "joypad_centering_window", 0.0f, 1.0f, centering_window))
+        {
+            return false;
+        }
 
-    std::vector<JoypadInfo> joypads;
-    std::vector<float> joypad_axis_values;
-    std::vector<bool> joypad_button_values;
-    bool using_joypad = false;
+        if (centering_time > 0 && centering_window == 0)
+        {
+            yCWarning(KEYBOARDJOYPAD) << "\"joypad_centering_time\" is set, but \"joypad_centering_window\" is 0,"
+                                      << "hence the rest position of the joypad axes is never updated.";
+        }
 
-    double last_gui_update_time = 0.0;
-    std::thread::id gui_thread_id;
+        expo.assign(number_of_axes, 0.0f);
+        if (!parseFloatList(cfg, "axes_expo", 0.0f, 1.0f, expo))
+        {
+            return false;
+        }
 
-    ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
+        slew_rate.assign(number_of_axes, 0.0f);
+        if (!parseFloatList(cfg, "axes_slew_rate", 0.0f, 1e6f, slew_rate))
+        {
+            return false;
+        }
 
+        low_pass_cutoff.assign(number_of_axes, 0.0f);
+        if (!parseFloatList(cfg, "axes_low_pass_cutoff", 0.0f, 1e6f, low_pass_cutoff))
+        {
+            return false;
+        }
 
-    static void GLMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei, const GLchar* message, const void*) {
-        yCError(KEYBOARDJOYPAD, "GL CALLBACK: %s source = 0x%x, type = 0x%x, id = 0x%x, severity = 0x%x, message = %s",
-            (type == GL_DEBUG_TYPE_ERROR ? "** GL ERROR **" : ""),
-            source, type, id, severity, message);
+        return true;
     }
+};
 
-    static void glfwErrorCallback(int error, const char* description) {
-        yCError(KEYBOARDJOYPAD, "GLFW error %d: %s", error, description);
+class OutputsSnapshot
+{
+    // Seqlock protected copy of the outputs. The writer makes the sequence odd while copying the values,
+    // and even once done. Readers never block: they retry when the sequence was odd or changed while reading.
+    std::atomic<uint64_t> sequence{ 0 };
+    std::unique_ptr<std::atomic<double>[]> axes;
+    std::unique_ptr<std::atomic<double>[]> buttons;
+    std::unique_ptr<std::atomic<unsigned char>[]> hats;
+    std::unique_ptr<std::atomic<double>[]> sticks;
+    std::vector<size_t> sticks_offsets; //The values of the stick i are in [sticks_offsets[i], sticks_offsets[i+1])
+    std::atomic<int> stamp_count{ -1 }; //Negative until the first publication, i.e. an invalid stamp
+    std::atomic<double> stamp_time{ 0.0 };
+    size_t number_of_axes{ 0 };
+    size_t number_of_buttons{ 0 };
+    size_t number_of_hats{ 0 };
+
+    static_assert(std::atomic<double>::is_always_lock_free, "The outputs snapshot requires lock-free atomic doubles");
+
+    template <typename ReadFunction>
+    void read(ReadFunction&& readFunction) const
+    {
+        uint64_t before, after;
+        do
+        {
+            before = this->sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                std::this_thread::yield(); //A publication is in progress
+                after = before + 1;
+                continue;
+            }
+            readFunction();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = this->sequence.load(std::memory_order_relaxed);
+        } while (before != after);
     }
 
-    bool parseButtonsSettings(yarp::os::Searchable& cfg)
+public:
+
+    // Not thread safe, to be called before any reader or writer is started.
+    void resize(size_t axes_size, size_t buttons_size, size_t hats_size, const std::vector<std::vector<double>>& sticks_values)
     {
-        buttons.name = "Buttons";
-        if (!cfg.check("buttons"))
+        this->number_of_axes = axes_size;
+        this->number_of_buttons = buttons_size;
+        this->number_of_hats = hats_size;
+        this->sticks_offsets.assign(1, 0);
+        for (auto& stick : sticks_values)
         {
-            yCInfo(KEYBOARDJOYPAD) << "The key \"buttons\" is not present in the configuration file. No buttons will be created.";
-            return true;
+            this->sticks_offsets.push_back(this->sticks_offsets.back() + stick.size());
         }
-
-        if (!cfg.find("buttons").isList())
+        this->axes = std::make_unique<std::atomic<double>[]>(axes_size);
+        this->buttons = std::make_unique<std::atomic<double>[]>(buttons_size);
+        this->hats = std::make_unique<std::atomic<unsigned char>[]>(hats_size);
+        this->sticks = std::make_unique<std::atomic<double>[]>(this->sticks_offsets.back());
+        this->stamp_count.store(-1, std::memory_order_relaxed);
+        this->stamp_time.store(0.0, std::memory_order_relaxed);
+        for (size_t i = 0; i < axes_size; ++i)
         {
-            yCError(KEYBOARDJOYPAD) << "The value of \"buttons\" is not a list";
-            return false;
+            this->axes[i].store(0.0, std::memory_order_relaxed);
         }
+        for (size_t i = 0; i < buttons_size; ++i)
+        {
+            this->buttons[i].store(0.0, std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < hats_size; ++i)
+        {
+            this->hats[i].store(0, std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < this->sticks_offsets.back(); ++i)
+        {
+            this->sticks[i].store(0.0, std::memory_order_relaxed);
+        }
+    }
 
-        yarp::os::Bottle* buttons_list = cfg.find("buttons").asList();
+    // Single writer only.
+    void publish(const yarp::os::Stamp& stamp, const std::vector<double>& axes_values, const std::vector<double>& buttons_values,
+                 const std::vector<unsigned char>& hat_values, const std::vector<std::vector<double>>& sticks_values)
+    {
+        uint64_t current = this->sequence.load(std::memory_order_relaxed);
+        this->sequence.store(current + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
 
-        std::unordered_map<std::string, std::pair<size_t, size_t>> buttons_map; //map existing buttons to their location
+        this->stamp_count.store(stamp.getCount(), std::memory_order_relaxed);
+        this->stamp_time.store(stamp.getTime(), std::memory_order_relaxed);
 
-        int col = 0;
-        for (size_t i = 0; i < buttons_list->size(); i++)
+        for (size_t i = 0; i < this->number_of_axes; ++i)
         {
-            std::string buttons_with_alias;
-            if (!buttons_list->get(i).isString())
-            {
-                if (buttons_list->get(i).isInt64() || buttons_list->get(i).isInt32())
+            this->axes[i].store(axes_values[i], std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < this->number_of_buttons; ++i)
+        {
+            this->buttons[i].store(buttons_values[i], std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < this->number_of_hats; ++i)
+        {
+            this->hats[i].store(hat_values[i], std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < sticks_values.size(); ++i)
+        {
+            for (size_t j = 0; j < sticks_values[i].size(); ++j)
+            {
+                this->sticks[this->sticks_offsets[i] + j].store(sticks_values[i][j], std::memory_order_relaxed);
+            }
+        }
+
+        this->sequence.store(current + 2, std::memory_order_release);
+    }
+
+    size_t numberOfAxes() const
+    {
+        return this->number_of_axes;
+    }
+
+    size_t numberOfButtons() const
+    {
+        return this->number_of_buttons;
+    }
+
+    size_t numberOfHats() const
+    {
+        return this->number_of_hats;
+    }
+
+    size_t numberOfSticks() const
+    {
+        return this->sticks_offsets.size() - 1;
+    }
+
+    size_t stickDoF(size_t stick_id) const
+    {
+        return this->sticks_offsets[stick_id + 1] - this->sticks_offsets[stick_id];
+    }
+
+    double axis(size_t axis_id) const
+    {
+        double value = 0.0;
+        this->read([&]() { value = this->axes[axis_id].load(std::memory_order_relaxed); });
+        return value;
+    }
+
+    double button(size_t button_id) const
+    {
+        double value = 0.0;
+        this->read([&]() { value = this->buttons[button_id].load(std::memory_order_relaxed); });
+        return value;
+    }
+
+    unsigned char hat(size_t hat_id) const
+    {
+        unsigned char value = 0;
+        this->read([&]() { value = this->hats[hat_id].load(std::memory_order_relaxed); });
+        return value;
+    }
+
+    // The stamp of the input sample from which the published outputs have been computed
+    yarp::os::Stamp stamp() const
+    {
+        int count = -1;
+        double time = 0.0;
+        this->read([&]()
+            {
+                count = this->stamp_count.load(std::memory_order_relaxed);
+                time = this->stamp_time.load(std::memory_order_relaxed);
+            });
+        return count < 0 ? yarp::os::Stamp() : yarp::os::Stamp(count, time);
+    }
+
+    void stick(size_t stick_id, yarp::sig::Vector& value) const
+    {
+        size_t offset = this->sticks_offsets[stick_id];
+        value.resize(this->stickDoF(stick_id));
+        this->read([&]()
+            {
+                for (size_t i = 0; i < value.size(); ++i)
+                {
+                    value[i] = this->sticks[offset + i].load(std::memory_order_relaxed);
+                }
+            });
+    }
+};
+
+class yarp::dev::KeyboardJoypad::Impl : public GuiRuntimeClient
+{
+public:
+    GLFWwindow* window = nullptr;
+    ImGuiContext* imgui_context = nullptr;
+
+    std::atomic_bool need_to_close{false}, closed{false}, initialized{false};
+
+    std::mutex mutex;
+
+    ImVec4 button_inactive_color;
+    ImVec4 button_active_color;
+
+    Settings settings;
+    AxesSettings axes_settings;
+
+    std::vector<ButtonsTable> sticks;
+    std::vector<std::vector<size_t>> sticks_to_axes;
+    ButtonsTable buttons;
+    ButtonState ctrl_button;
+    MappingTable mapping;
+    JoypadAxesConditioning joypad_conditioning;
+    std::vector<float> conditioned_joypad_axis_values;
+    AxisPipeline axis_pipeline;
+    JoypadPassthrough passthrough;
+    std::vector<double> axes_values;
+    std::vector<std::vector<double>> sticks_values;
+    std::vector<double> buttons_values;
+    std::vector<unsigned char> hat_values; //Only from the passthrough
+    OutputsSnapshot outputs_snapshot;
+    yarp::os::Stamp input_stamp; //Counts the input samples, with their acquisition time
+
+    // A joypad selected in joypad_indices, kept also while it is disconnected
+    struct JoypadBinding
+    {
+        int index{ -1 }; //Index in the backend, -1 if never connected
+        std::string guid;
+        std::string name;
+        int axes{ 0 };
+        int buttons{ 0 };
+        int hats{ 0 };
+    };
+
+    std::vector<JoypadInfo> joypads;
+    std::vector<JoypadBinding> joypad_bindings; //One per element of joypad_indices
+    std::vector<float> joypad_axis_values;
+    std::vector<bool> joypad_button_values;
+    std::vector<unsigned char> joypad_hat_values;
+    bool using_joypad = false;
+
+    std::mutex event_mutex;
+    yarp::dev::IJoypadEvent* event = nullptr;
+    std::atomic<bool> event_driven{ false };
+    std::vector<double> previous_axes_values;
+    std::vector<double> previous_buttons_values;
+    std::vector<unsigned char> previous_hat_values;
+    std::vector<std::vector<double>> previous_sticks_values;
+    std::vector<float> previous_joypad_axis_values;
+    std::vector<bool> previous_joypad_button_values;
+    std::vector<unsigned char> previous_joypad_hat_values;
+    bool measure_latency = false;
+    LatencyStatistics latency;
+    std::unique_ptr<LatencyStatisticsPublisher> latency_publisher;
+    std::unique_ptr<StatePublisher> state_publisher;
+    SharedStateWriter shared_state;
+    WebPanelServer web_panel;
+    TraceWriter trace;
+    std::vector<WebPanelEvent> web_panel_events; //Taken from the server, and deferred to the next samples
+    std::vector<uint8_t> web_panel_touched; //The button changed in the current sample
+    std::vector<uint8_t> web_panel_held; //The button is kept pressed in a web panel
+    std::vector<uint8_t> web_panel_highlighted;
+    std::vector<yarp::dev::IJoypadEvent::joyData<float>> changed_buttons;
+    std::vector<yarp::dev::IJoypadEvent::joyData<double>> changed_axes;
+    std::vector<yarp::dev::IJoypadEvent::joyData<unsigned char>> changed_hats;
+    std::vector<yarp::dev::IJoypadEvent::joyData<yarp::sig::Vector>> changed_sticks;
+    std::vector<yarp::sig::Vector> stick_event_buffers; //Swapped in and out of changed_sticks to avoid allocations
+    // Position of each id in the changed vectors, or noPendingChange. Each id is sent once per event, with its latest value,
+    // also when more samples are taken before dispatching the events, e.g. when replaying faster than real time.
+    std::vector<size_t> changed_buttons_positions;
+    std::vector<size_t> changed_axes_positions;
+    std::vector<size_t> changed_hats_positions;
+    std::vector<size_t> changed_sticks_positions;
+
+    std::unique_ptr<InputBackend> input_backend;
+    ProgrammaticInputBackend* programmatic_backend = nullptr;
+    ReplayInputBackend* replay_backend = nullptr;
+    bool replay_gui_events = false;
+    InputRecorder recorder;
+    KeyboardState keyboard;
+    bool gui_initialized = false;
+
+    double last_gui_update_time = 0.0;
+    GlfwInputBackend* glfw_backend = nullptr;
+    TextBuffer gui_text;
+    ImGuiTextFilter buttons_filter;
+    bool buttons_table_scrolls = false;
+    int frames_to_render = 0; //Frames still to be drawn after the last change
+    bool item_active = false; //Whether a widget was active in the last frame, e.g. a button kept pressed with the mouse
+    double last_presented_time = 0.0;
+    double render_cpu_time = 0.0; //Average CPU time needed to draw a frame
+    size_t rendered_frames = 0; //In the current savings measurement window
+    size_t skipped_frames = 0; //In the current savings measurement window
+    double savings_window_start = 0.0;
+    double skipped_frames_ratio = 0.0;
+    double cpu_savings = 0.0; //Fraction of a core saved by skipping the frames
+    double last_input_sample_time = 0.0;
+    double measured_input_period = 0.0;
+    std::atomic<std::thread::id> gui_thread_id; //Read without the mutex by the getters, set before initialized
+    GLuint offscreen_framebuffer = 0;
+    GLuint offscreen_renderbuffer = 0;
+    int offscreen_width = 0;
+    int offscreen_height = 0;
+    double frame_build_time = 0.0; //Of the last frame, from the new frame to the end of the widgets
+    double frame_imgui_render_time = 0.0; //Of the last frame, ImGui::Render
+    double frame_draw_time = 0.0; //Of the last frame, ImGui_ImplOpenGL3_RenderDrawData
+
+    ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
+
+
+    static void GLMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei, const GLchar* message, const void*) {
+        yCError(KEYBOARDJOYPAD, "GL CALLBACK: %s source = 0x%x, type = 0x%x, id = 0x%x, severity = 0x%x, message = %s",
+            (type == GL_DEBUG_TYPE_ERROR ? "** GL ERROR **" : ""),
+            source, type, id, severity, message);
+    }
+
+    bool parseButtonsSettings(yarp::os::Searchable& cfg)
+    {
+        buttons.name = "Buttons";
+        if (!cfg.check("buttons"))
+        {
+            yCInfo(KEYBOARDJOYPAD) << "The key \"buttons\" is not present in the configuration file. No buttons will be created.";
+            return true;
+        }
+
+        if (!cfg.find("buttons").isList())
+        {
+            yCError(KEYBOARDJOYPAD) << "The value of \"buttons\" is not a list";
+            return false;
+        }
+
+        yarp::os::Bottle* buttons_list = cfg.find("buttons").asList();
+
+        std::unordered_map<std::string, std::pair<size_t, size_t>> buttons_map; //map existing buttons to their location
+        buttons_map.reserve(buttons_list->size());
+
+        int col = 0;
+        for (size_t i = 0; i < buttons_list->size(); i++)
+        {
+            std::string buttons_with_alias;
+            if (!buttons_list->get(i).isString())
+            {
+                if (buttons_list->get(i).isInt64() || buttons_list->get(i).isInt32())
                 {
                     buttons_with_alias = std::to_string(buttons_list->get(i).asInt64());
                 }
@@ -648,57 +1439,25 @@ public:
 
             std::transform(buttons_keys.begin(), buttons_keys.end(), buttons_keys.begin(), ::toupper);
 
-            std::vector<std::string> buttons_key_list;
-            std::string delimiter = "-";
-            pos = buttons_keys.find(delimiter);
-            while (pos != std::string::npos)
-            {
-                buttons_key_list.push_back(buttons_keys.substr(0, pos));
-                buttons_keys.erase(0, pos + delimiter.length());
-                pos = buttons_keys.find(delimiter);
-            }
-            buttons_key_list.push_back(buttons_keys);
-
             ButtonState newButton;
             newButton.values.push_back({ .sign = 1, .index = i });
 
-            std::unordered_map<std::string, ImGuiKey> supportedButtons = {
-                {"SPACE", ImGuiKey_Space},
-                {"ENTER", ImGuiKey_Enter},
-                {"ESCAPE", ImGuiKey_Escape},
-                {"BACKSPACE", ImGuiKey_Backspace},
-                {"DELETE", ImGuiKey_Delete},
-                {"LEFT", ImGuiKey_LeftArrow},
-                {"RIGHT", ImGuiKey_RightArrow},
-                {"UP", ImGuiKey_UpArrow},
-                {"DOWN", ImGuiKey_DownArrow},
-                {"TAB", ImGuiKey_Tab}
-            };
-
+            // Single pass over the keys separated by "-"
             std::string parsedButtons;
-            for (auto& button : buttons_key_list)
+            std::string_view remaining_keys = buttons_keys;
+            while (true)
             {
+                size_t delimiter = remaining_keys.find('-');
+                std::string_view button = remaining_keys.substr(0, delimiter);
+
                 bool parsed = true;
-                if (button.size() == 1 && button[0] >= 'A' && button[0] <= 'Z')
+                int joypad_button = 0;
+                if (button.size() > 1 && button[0] == 'J'
+                    && std::from_chars(button.data() + 1, button.data() + button.size(), joypad_button).ptr == button.data() + button.size()) //J followed by a number
                 {
-                    newButton.keys.push_back(static_cast<ImGuiKey>(ImGuiKey_A + button[0] - 'A'));
-                }
-                else if (button.size() && button[0] >= '0' && button[0] <= '9')
-                {
-                    newButton.keys.push_back(static_cast<ImGuiKey>(ImGuiKey_0 + button[0] - '0'));
-                    newButton.keys.push_back(static_cast<ImGuiKey>(ImGuiKey_Keypad0 + button[0] - '0'));
-                }
-                else if (button.size() > 1 && button[0] == 'J' && std::find_if(button.begin() + 1,
-                    button.end(), [](unsigned char c) { return !std::isdigit(c); }) == button.end()) //J followed by a number
-                {
-                    int joypad_button = std::stoi(button.substr(1));
                     newButton.joypadButtonIndices.push_back(joypad_button);
                 }
-                else if (supportedButtons.find(button) != supportedButtons.end())
-                {
-                    newButton.keys.push_back(supportedButtons[button]);
-                }
-                else
+                else if (!parseKeyName(button, newButton.keys))
                 {
                     parsed = false;
                 }
@@ -707,13 +1466,16 @@ public:
                 {
                     if (!parsedButtons.empty())
                     {
-                        parsedButtons += ", " + button;
-                    }
-                    else
-                    {
-                        parsedButtons = button;
+                        parsedButtons += ", ";
                     }
+                    parsedButtons += button;
                 }
+
+                if (delimiter == std::string_view::npos)
+                {
+                    break;
+                }
+                remaining_keys.remove_prefix(delimiter + 1);
             }
 
             if (!parsedButtons.empty() && have_alias)
@@ -722,274 +1484,1081 @@ public:
             }
             else if (!parsedButtons.empty() && !have_alias)
             {
-                alias = parsedButtons;
+                alias = parsedButtons;
+            }
+
+            newButton.alias = alias;
+
+            auto existing_button = buttons_map.find(newButton.alias);
+            if (existing_button != buttons_map.end())
+            {
+                auto [button_row, button_col] = existing_button->second;
+                buttons.rows[button_row][button_col].values.push_back(newButton.values.front());
+            }
+            else
+            {
+                if (buttons.rows.empty() || buttons.rows.back().size() == settings.buttons_per_row)
+                {
+                    buttons.rows.emplace_back();
+                    col = 0;
+                }
+                newButton.col = col++;
+                buttons.rows.back().push_back(newButton);
+                buttons_map[newButton.alias] = std::make_pair(buttons.rows.size() - 1, buttons.rows.back().size() - 1);
+            }
+        }
+        buttons_values.resize(buttons_list->size(), 0.0);
+        if (!buttons.rows.empty())
+        {
+            ctrl_button = {.alias = "Hold (Ctrl)", .type = ButtonType::TOGGLE, .keys = {ImGuiKey_LeftCtrl, ImGuiKey_RightCtrl} };
+        }
+
+        return true;
+    }
+
+    void prepareWindow(const ImVec2& position, const std::string& name)
+    {
+        ImGui::SetNextWindowPos(position, ImGuiCond_FirstUseEver);
+        ImGui::Begin(name.c_str(), 0, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoSavedSettings);
+        ImGui::SetWindowFontScale(settings.font_multiplier);
+    }
+
+    // Only the visible rows are drawn, hence the cost does not depend on the number of buttons.
+    // The table scrolls when higher than max_height, if positive. The buttons passing the filter, if active, are
+    // laid out again in rows. Returns whether the table scrolls.
+    bool renderButtonsTable(ButtonsTable& buttons_table, float max_height = 0.0f, const ImGuiTextFilter* filter = nullptr)
+    {
+        ButtonGrid& grid = buttons_table.grid;
+        grid.layout(buttons_table.rows, buttons_table.numberOfColumns, settings.button_size, filter);
+
+        bool scrolls = max_height > 0.0f && grid.size().y > max_height;
+        if (scrolls)
+        {
+            // The width is explicit, since the window is resized to fit its content
+            ImVec2 child_size(grid.size().x + ImGui::GetStyle().ScrollbarSize, std::max(grid.rowPitch(), max_height));
+            ImGui::BeginChild(buttons_table.name.c_str(), child_size);
+            ImGui::SetWindowFontScale(settings.font_multiplier);
+        }
+
+        grid.render(buttons_table.name.c_str(), mapping, button_active_color, button_inactive_color);
+
+        if (scrolls)
+        {
+            ImGui::EndChild();
+        }
+        return scrolls;
+    }
+
+    bool initializeGui()
+    {
+        // GLFW is shared with the other devices in the process
+        if (!GuiRuntime::acquireGlfw(this->settings.offscreen)) {
+            return false;
+        }
+
+        if (this->settings.offscreen)
+        {
+            // The window is never shown. Its context, created through EGL or OSMesa, draws in an offscreen framebuffer.
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API,
+                           this->settings.offscreen_context_api == "osmesa" ? GLFW_OSMESA_CONTEXT_API : GLFW_EGL_CONTEXT_API);
+        }
+        this->window = glfwCreateWindow(this->settings.window_width, this->settings.window_height,
+            "YARP Keyboard as Joypad Device Window", nullptr, nullptr);
+        glfwDefaultWindowHints();
+        if (!this->window) {
+            yCError(KEYBOARDJOYPAD, "Could not create window");
+            GuiRuntime::releaseGlfw();
+            return false;
+        }
+
+        glfwMakeContextCurrent(this->window);
+        // When sampling the inputs faster than the GUI, the swap of the buffers should not wait for the vertical sync
+        glfwSwapInterval(this->settings.input_period < this->settings.gui_period ? 0 : 1);
+
+        // Initialize the GLEW OpenGL 3.x bindings
+        // GLEW must be initialized after creating the window
+        glewExperimental = GL_TRUE;
+        GLenum err = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+        // GLEW built for GLX looks for an X display after having loaded the OpenGL functions, and it is not there offscreen
+        if (err == GLEW_ERROR_NO_GLX_DISPLAY && this->settings.offscreen) {
+            err = GLEW_OK;
+        }
+#endif
+        if (err != GLEW_OK) {
+            yCError(KEYBOARDJOYPAD) << "glewInit failed, aborting.";
+            glfwDestroyWindow(this->window);
+            this->window = nullptr;
+            GuiRuntime::releaseGlfw();
+            return false;
+        }
+        yCInfo(KEYBOARDJOYPAD) << "Using GLEW" << (const char*)glewGetString(GLEW_VERSION);
+
+        glDebugMessageControl(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_OTHER, GL_DEBUG_SEVERITY_NOTIFICATION, 0, NULL, GL_FALSE); //This is to ignore message 0x20071 about the use of the VIDEO memory
+
+        glDebugMessageCallback(&KeyboardJoypad::Impl::GLMessageCallback, NULL);
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glEnable(GL_DEBUG_OUTPUT);
+
+        if (this->settings.offscreen)
+        {
+            int width, height;
+            glfwGetFramebufferSize(this->window, &width, &height);
+            if (!this->resizeOffscreenFramebuffer(width, height))
+            {
+                this->deleteOffscreenFramebuffer();
+                glfwDestroyWindow(this->window);
+                this->window = nullptr;
+                GuiRuntime::releaseGlfw();
+                return false;
+            }
+            yCInfo(KEYBOARDJOYPAD) << "Rendering offscreen with" << (const char*)glGetString(GL_RENDERER);
+        }
+
+        auto backend = std::make_unique<GlfwInputBackend>(this->window);
+        this->glfw_backend = backend.get();
+        this->input_backend = std::move(backend);
+
+        // Setup Dear ImGui context. Each device has its own, receiving the events of its window from the input backend.
+        IMGUI_CHECKVERSION();
+        this->imgui_context = ImGui::CreateContext();
+        ImGui::SetCurrentContext(this->imgui_context);
+        this->glfw_backend->setImGuiContext(this->imgui_context);
+        this->glfw_backend->setTrace(&this->trace);
+        ImGuiIO& io = ImGui::GetIO();
+        io.ConfigFlags |= ImGuiConfigFlags_NavNoCaptureKeyboard;
+
+        // Setup Dear ImGui style
+        ImGui::StyleColorsDark();
+
+        this->button_inactive_color = ImGui::GetStyle().Colors[ImGuiCol_Button];
+        this->button_active_color = ImVec4(0.7f, 0.5f, 0.3f, 1.0f);
+
+        this->gui_initialized = true;
+
+        return true;
+    }
+
+    // (Re)allocates the offscreen framebuffer if its size changed. The context of the window has to be current.
+    bool resizeOffscreenFramebuffer(int width, int height)
+    {
+        width = std::max(width, 1);
+        height = std::max(height, 1);
+        if (this->offscreen_framebuffer && width == this->offscreen_width && height == this->offscreen_height)
+        {
+            return true;
+        }
+
+        if (!this->offscreen_framebuffer)
+        {
+            glGenFramebuffers(1, &this->offscreen_framebuffer);
+            glGenRenderbuffers(1, &this->offscreen_renderbuffer);
+        }
+        glBindRenderbuffer(GL_RENDERBUFFER, this->offscreen_renderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->offscreen_framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->offscreen_renderbuffer);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            yCError(KEYBOARDJOYPAD) << "The offscreen framebuffer of size" << width << "x" << height << "is not complete.";
+            return false;
+        }
+        this->offscreen_width = width;
+        this->offscreen_height = height;
+        return true;
+    }
+
+    void deleteOffscreenFramebuffer()
+    {
+        if (this->offscreen_framebuffer)
+        {
+            glDeleteFramebuffers(1, &this->offscreen_framebuffer);
+            glDeleteRenderbuffers(1, &this->offscreen_renderbuffer);
+        }
+        this->offscreen_framebuffer = 0;
+        this->offscreen_renderbuffer = 0;
+        this->offscreen_width = 0;
+        this->offscreen_height = 0;
+    }
+
+    // Reads back the last frame drawn offscreen, as RGBA rows from the top. To be called from the GUI thread.
+    bool readOffscreenFrame(std::vector<unsigned char>& rgba, int& width, int& height)
+    {
+        if (!this->offscreen_framebuffer)
+        {
+            return false;
+        }
+        glfwMakeContextCurrent(this->window);
+        width = this->offscreen_width;
+        height = this->offscreen_height;
+        size_t row_size = static_cast<size_t>(width) * 4;
+        rgba.resize(row_size * static_cast<size_t>(height));
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, this->offscreen_framebuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+
+        // OpenGL returns the rows from the bottom
+        for (size_t top = 0, bottom = static_cast<size_t>(height) - 1; top < bottom; ++top, --bottom)
+        {
+            std::swap_ranges(rgba.begin() + top * row_size, rgba.begin() + (top + 1) * row_size, rgba.begin() + bottom * row_size);
+        }
+        return true;
+    }
+
+    void createHeadlessInputBackend()
+    {
+        if (this->settings.input_backend == "programmatic")
+        {
+            auto backend = std::make_unique<ProgrammaticInputBackend>(static_cast<size_t>(this->settings.virtual_joypad_axes),
+                                                                      static_cast<size_t>(this->settings.virtual_joypad_buttons));
+            this->programmatic_backend = backend.get();
+            this->input_backend = std::move(backend);
+        }
+        else if (this->settings.input_backend == "replay")
+        {
+            auto backend = std::make_unique<ReplayInputBackend>(this->settings.replay_file, this->settings.replay_speed);
+            this->replay_backend = backend.get();
+            this->input_backend = std::move(backend);
+        }
+        else
+        {
+#ifdef __linux__
+            // It does not need a display, differently from GLFW
+            this->input_backend = std::make_unique<LinuxJoystickInputBackend>();
+#else
+            this->input_backend = std::make_unique<GlfwInputBackend>();
+#endif
+        }
+    }
+
+    bool initializeRecording()
+    {
+        RecordingHeader header{};
+        header.joypad_axes = static_cast<uint32_t>(this->joypad_axis_values.size());
+        header.joypad_buttons = static_cast<uint32_t>(this->joypad_button_values.size());
+        header.axes = static_cast<uint32_t>(this->axes_values.size());
+        header.buttons = static_cast<uint32_t>(this->buttons_values.size());
+        for (const auto& stick : this->sticks_values)
+        {
+            header.sticks_values += static_cast<uint32_t>(stick.size());
+        }
+        header.gui_buttons = static_cast<uint32_t>(this->mapping.size());
+
+        if (this->replay_backend)
+        {
+            const RecordingHeader& recorded = this->replay_backend->header();
+            bool same_outputs = recorded.axes == header.axes && recorded.buttons == header.buttons
+                                && recorded.sticks_values == header.sticks_values;
+            if (!same_outputs)
+            {
+                yCWarning(KEYBOARDJOYPAD) << "The number of outputs is different from the one of the recording."
+                                          << "The outputs will not be compared with the recorded ones.";
+            }
+            this->replay_backend->setCompareOutputs(same_outputs);
+
+            this->replay_gui_events = recorded.gui_buttons == header.gui_buttons;
+            if (!this->replay_gui_events)
+            {
+                yCWarning(KEYBOARDJOYPAD) << "The buttons are different from the ones of the recording."
+                                          << "The clicks on the GUI will not be replayed.";
+            }
+        }
+
+        if (!this->settings.record_file.empty())
+        {
+            return this->recorder.open(this->settings.record_file, header);
+        }
+
+        return true;
+    }
+
+    bool initialize()
+    {
+        if (!this->settings.headless && !this->initializeGui())
+        {
+            return false;
+        }
+
+        if (!this->input_backend->initialize(this->joypads))
+        {
+            return false;
+        }
+
+        if (this->gui_initialized)
+        {
+            // Setup Platform/Renderer backends. The ImGui callbacks are not installed, since they would write the events
+            // in the current ImGui context, that might be the one of another device. The input backend forwards them.
+            ImGui_ImplGlfw_InitForOpenGL(this->window, false);
+            ImGui_ImplOpenGL3_Init();
+        }
+
+        if (!this->joypads.size()) {
+            yCInfo(KEYBOARDJOYPAD) << "No joypad found.";
+        }
+
+        size_t axes_offset = 0;
+        size_t buttons_offset = 0;
+        size_t hats_offset = 0;
+        this->joypad_bindings.assign(this->settings.joypad_indices.size(), JoypadBinding());
+        this->using_joypad = this->stackJoypads(this->joypads, axes_offset, buttons_offset, hats_offset);
+        this->joypad_axis_values.resize(axes_offset, 0.0);
+        this->joypad_button_values.resize(buttons_offset, false);
+        this->joypad_hat_values.resize(hats_offset, 0);
+        this->previous_joypad_axis_values = this->joypad_axis_values;
+        this->previous_joypad_button_values = this->joypad_button_values;
+        this->previous_joypad_hat_values = this->joypad_hat_values;
+        this->mapping.checkJoypadInputs(this->joypad_axis_values.size(), this->joypad_button_values.size());
+        this->passthrough.checkJoypadInputs(this->joypad_axis_values.size(), this->joypad_button_values.size(), this->joypad_hat_values.size());
+
+        if (!this->initializeRecording())
+        {
+            return false;
+        }
+
+        this->gui_thread_id = std::this_thread::get_id();
+        this->initialized = true;
+        this->trace.nameThread("GUI thread");
+
+        return true;
+    }
+
+    // Sets the offsets of the joypads selected in the configuration, stacking their values in the order provided.
+    // Each entry of joypad_indices is bound to the joypad at that position the first time it is available, and then
+    // follows that joypad, identified by its index in the backend and its GUID. While it is disconnected its values
+    // keep their place and stay zero, so that the other joypads are not shifted, and another joypad is never used
+    // in its place. Returns whether any joypad is used.
+    bool stackJoypads(std::vector<JoypadInfo>& available_joypads, size_t& number_of_axes, size_t& number_of_buttons,
+                      size_t& number_of_hats)
+    {
+        std::vector<JoypadInfo*> selected(this->joypad_bindings.size(), nullptr);
+
+        // The joypads still connected with the same index
+        for (size_t i = 0; i < this->joypad_bindings.size(); ++i)
+        {
+            const JoypadBinding& binding = this->joypad_bindings[i];
+            for (auto& joypad : available_joypads)
+            {
+                if (binding.index >= 0 && !joypad.active && joypad.index == binding.index && joypad.guid == binding.guid)
+                {
+                    joypad.active = true;
+                    selected[i] = &joypad;
+                    break;
+                }
+            }
+        }
+
+        // The same model reconnected with another index. Without a GUID, the joypad cannot be recognized.
+        for (size_t i = 0; i < this->joypad_bindings.size(); ++i)
+        {
+            const JoypadBinding& binding = this->joypad_bindings[i];
+            if (selected[i] || binding.index < 0 || binding.guid.empty())
+            {
+                continue;
+            }
+            for (auto& joypad : available_joypads)
+            {
+                if (!joypad.active && joypad.guid == binding.guid)
+                {
+                    joypad.active = true;
+                    selected[i] = &joypad;
+                    break;
+                }
+            }
+        }
+
+        // The joypads never bound take the one at their position, if not used by another entry
+        for (size_t i = 0; i < this->joypad_bindings.size(); ++i)
+        {
+            size_t position = static_cast<size_t>(this->settings.joypad_indices[i]);
+            if (selected[i] || this->joypad_bindings[i].index >= 0 || position >= available_joypads.size()
+                || available_joypads[position].active)
+            {
+                continue;
+            }
+            available_joypads[position].active = true;
+            selected[i] = &available_joypads[position];
+        }
+
+        bool any_joypad = false;
+        number_of_axes = 0;
+        number_of_buttons = 0;
+        number_of_hats = 0;
+        for (size_t i = 0; i < this->joypad_bindings.size(); ++i)
+        {
+            JoypadBinding& binding = this->joypad_bindings[i];
+            JoypadInfo* joypad = selected[i];
+            if (!joypad)
+            {
+                if (binding.index < 0)
+                {
+                    yCWarning(KEYBOARDJOYPAD) << "The joypad with index" << this->settings.joypad_indices[i] << "is not available. It will be skipped";
+                }
+                else
+                {
+                    yCWarning(KEYBOARDJOYPAD) << "The joypad" << binding.name << "is not connected. Its values are zero until it is reconnected.";
+                }
+                number_of_axes += static_cast<size_t>(binding.axes);
+                number_of_buttons += static_cast<size_t>(binding.buttons);
+                number_of_hats += static_cast<size_t>(binding.hats);
+                continue;
+            }
+            binding.index = joypad->index;
+            binding.guid = joypad->guid;
+            binding.name = joypad->name;
+            binding.axes = joypad->axes;
+            binding.buttons = joypad->buttons;
+            binding.hats = joypad->hats;
+            joypad->axes_offset = number_of_axes;
+            joypad->buttons_offset = number_of_buttons;
+            joypad->hats_offset = number_of_hats;
+            number_of_axes += static_cast<size_t>(joypad->axes);
+            number_of_buttons += static_cast<size_t>(joypad->buttons);
+            number_of_hats += static_cast<size_t>(joypad->hats);
+            any_joypad = true;
+        }
+        return any_joypad;
+    }
+
+    // Applies the connections and disconnections of the joypads. The new joypads list and values are built only
+    // when something changed, and then swapped with the ones used by the input sampling.
+    void refreshJoypads()
+    {
+        std::vector<JoypadInfo> available_joypads;
+        if (!this->input_backend->consumeJoypadChanges(available_joypads))
+        {
+            return;
+        }
+
+        size_t number_of_axes = 0;
+        size_t number_of_buttons = 0;
+        size_t number_of_hats = 0;
+        bool any_joypad = this->stackJoypads(available_joypads, number_of_axes, number_of_buttons, number_of_hats);
+        std::vector<float> joypad_axis_values(number_of_axes, 0.0f);
+        std::vector<bool> joypad_button_values(number_of_buttons, false);
+        std::vector<unsigned char> joypad_hat_values(number_of_hats, 0);
+        std::vector<float> previous_joypad_axis_values(number_of_axes, 0.0f);
+        std::vector<bool> previous_joypad_button_values(number_of_buttons, false);
+        std::vector<unsigned char> previous_joypad_hat_values(number_of_hats, 0);
+
+        if (number_of_axes != this->joypad_axis_values.size() || number_of_buttons != this->joypad_button_values.size()
+            || number_of_hats != this->joypad_hat_values.size())
+        {
+            yCInfo(KEYBOARDJOYPAD) << "The joypads now provide" << number_of_axes << "axes," << number_of_buttons << "buttons and"
+                                   << number_of_hats << "hats.";
+            this->mapping.checkJoypadInputs(number_of_axes, number_of_buttons);
+            this->passthrough.checkJoypadInputs(number_of_axes, number_of_buttons, number_of_hats);
+        }
+
+        this->joypads.swap(available_joypads);
+        this->joypad_axis_values.swap(joypad_axis_values);
+        this->joypad_button_values.swap(joypad_button_values);
+        this->joypad_hat_values.swap(joypad_hat_values);
+        this->previous_joypad_axis_values.swap(previous_joypad_axis_values);
+        this->previous_joypad_button_values.swap(previous_joypad_button_values);
+        this->previous_joypad_hat_values.swap(previous_joypad_hat_values);
+        this->using_joypad = any_joypad;
+        this->requestRedraw();
+    }
+
+    // Compiles the buttons in the mapping table. The order defines the ids of the buttons in the recordings.
+    void compileMapping()
+    {
+        // Only the buttons in the buttons table can be kept active with the hold button
+        auto addButton = [this](ButtonState& button, MappingOutput output, bool holdable)
+        {
+            button.mappingIndex = this->mapping.addButton(button.type, holdable);
+            for (ImGuiKey key : button.keys)
+            {
+                this->mapping.addKey(button.mappingIndex, key);
+            }
+            for (int joypad_button : button.joypadButtonIndices)
+            {
+                this->mapping.addJoypadButton(button.mappingIndex, joypad_button);
+            }
+            for (const auto& axis : button.joypadAxisInputs)
+            {
+                this->mapping.addJoypadAxis(button.mappingIndex, axis.index, axis.sign);
+            }
+            for (const auto& value : button.values)
+            {
+                this->mapping.addOutput(button.mappingIndex, output, value.index, value.sign);
+            }
+        };
+
+        for (auto& stick : this->sticks)
+        {
+            for (auto& row : stick.rows)
+            {
+                for (auto& button : row)
+                {
+                    addButton(button, MappingOutput::AXES, false);
+                }
+            }
+        }
+        addButton(this->ctrl_button, MappingOutput::BUTTONS, false); //It has no outputs
+        this->mapping.setHoldButton(this->ctrl_button.mappingIndex);
+        for (auto& row : this->buttons.rows)
+        {
+            for (auto& button : row)
+            {
+                addButton(button, MappingOutput::BUTTONS, true);
+            }
+        }
+    }
+
+    void applyReplayedGuiEvents(const RecordingReader::Frame& frame)
+    {
+        this->mapping.clearGuiEvents();
+        for (size_t i = 0; i < frame.number_of_gui_events; ++i)
+        {
+            uint8_t flags = 0;
+            uint32_t button_id = frame.guiEvent(i, flags);
+            if (button_id >= this->mapping.size())
+            {
+                continue;
+            }
+            if (flags & RecordedGuiClicked)
+            {
+                this->mapping.markGuiClicked(button_id);
+            }
+            this->mapping.setGuiKeptPressed(button_id, flags & RecordedGuiKeptPressed);
+        }
+    }
+
+    // Whether the values of the joypads changed since the last sample
+    bool detectJoypadChanges()
+    {
+        bool joypad_changed = false;
+        for (size_t i = 0; i < this->joypad_axis_values.size(); ++i)
+        {
+            if (this->joypad_axis_values[i] != this->previous_joypad_axis_values[i])
+            {
+                joypad_changed = true;
+                this->previous_joypad_axis_values[i] = this->joypad_axis_values[i];
+            }
+        }
+        for (size_t i = 0; i < this->joypad_button_values.size(); ++i)
+        {
+            if (this->joypad_button_values[i] != this->previous_joypad_button_values[i])
+            {
+                joypad_changed = true;
+                this->previous_joypad_button_values[i] = this->joypad_button_values[i];
+            }
+        }
+        for (size_t i = 0; i < this->joypad_hat_values.size(); ++i)
+        {
+            if (this->joypad_hat_values[i] != this->previous_joypad_hat_values[i])
+            {
+                joypad_changed = true;
+                this->previous_joypad_hat_values[i] = this->joypad_hat_values[i];
+            }
+        }
+        return joypad_changed;
+    }
+
+    // Arrival time of the first input since the last sample, 0 if nothing changed.
+    // The joypads are polled, hence their changes are considered to arrive at the time of the sample.
+    int64_t inputArrivalTime(int64_t sample_time, bool joypad_changed)
+    {
+        int64_t input_time = this->keyboard.first_edge_time;
+        if (joypad_changed && (input_time == 0 || sample_time < input_time))
+        {
+            input_time = sample_time;
+        }
+        return input_time;
+    }
+
+    // Locks the mutex, measuring the time spent waiting for it
+    std::unique_lock<std::mutex> lockMutex()
+    {
+        if (!this->measure_latency && !this->trace.enabled())
+        {
+            return std::unique_lock<std::mutex>(this->mutex);
+        }
+        int64_t start = LatencyStatistics::now();
+        std::unique_lock<std::mutex> lock(this->mutex);
+        int64_t end = LatencyStatistics::now();
+        if (this->measure_latency)
+        {
+            this->latency.record(LatencyStage::MutexWait, end - start);
+        }
+        this->trace.record("mutex wait", start, end);
+        return lock;
+    }
+
+    // Opens the optional outputs selected in the configuration. On failure, closeOutputs has to be called.
+    bool openOutputs()
+    {
+        if (this->settings.stats_period > 0)
+        {
+            this->measure_latency = true;
+            this->latency_publisher = std::make_unique<LatencyStatisticsPublisher>(this->latency, this->settings.stats_period);
+            if (!this->latency_publisher->open(this->settings.name + "/stats:o"))
+            {
+                return false;
             }
+        }
 
-            newButton.alias = alias;
+        if (!this->settings.shared_memory_name.empty()
+            && !this->shared_state.open(this->settings.shared_memory_name, this->settings.shared_memory_frames,
+                                        this->axes_values.size(), this->buttons_values.size(), this->sticks_values))
+        {
+            return false;
+        }
 
-            if (buttons_map.find(newButton.alias) != buttons_map.end())
-            {
-                size_t button_row = buttons_map[newButton.alias].first;
-                size_t button_col = buttons_map[newButton.alias].second;
-                buttons.rows[button_row][button_col].values.push_back(newButton.values.front());
-            }
-            else
+        if (this->settings.state_port)
+        {
+            this->state_publisher = std::make_unique<StatePublisher>(this->settings.state_keyframe_period,
+                                                                     this->settings.state_quantize_int16);
+            if (!this->state_publisher->open(this->settings.name + "/state:o",
+                                             this->axes_values.size(), this->buttons_values.size()))
             {
-                if (buttons.rows.empty() || buttons.rows.back().size() == settings.buttons_per_row)
-                {
-                    buttons.rows.emplace_back();
-                    col = 0;
-                }
-                newButton.col = col++;
-                buttons.rows.back().push_back(newButton);
-                buttons_map[newButton.alias] = std::make_pair(buttons.rows.size() - 1, buttons.rows.back().size() - 1);
+                return false;
             }
         }
-        buttons_values.resize(buttons_list->size(), 0.0);
-        if (!buttons.rows.empty())
+
+        if (this->settings.web_panel_port > 0 && !this->openWebPanel())
         {
-            ctrl_button = {.alias = "Hold (Ctrl)", .type = ButtonType::TOGGLE, .keys = {ImGuiKey_LeftCtrl, ImGuiKey_RightCtrl}, .values = {{.sign = 1, .index = 0}} };
-            ctrl_value.resize(1, 0.0);
+            return false;
+        }
+
+        if (!this->settings.trace_file.empty()
+            && !this->trace.open(this->settings.trace_file,
+                                 static_cast<size_t>(this->settings.trace_file_size * 1024.0 * 1024.0),
+                                 this->settings.trace_files))
+        {
+            return false;
         }
 
         return true;
     }
 
-    void prepareWindow(const ImVec2& position, const std::string& name)
+    // Closes the outputs opened by openOutputs. It can be called more than once, also if they were not opened.
+    void closeOutputs()
     {
-        ImGui::SetNextWindowPos(position, ImGuiCond_FirstUseEver);
-        ImGui::Begin(name.c_str(), 0, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoSavedSettings);
-        ImGui::SetWindowFontScale(settings.font_multiplier);
+        if (this->latency_publisher)
+        {
+            this->latency_publisher->close();
+            this->latency_publisher.reset();
+        }
+        if (this->state_publisher)
+        {
+            this->state_publisher->close();
+            this->state_publisher.reset();
+        }
+        this->shared_state.close();
+        this->web_panel.close();
+        this->trace.close();
     }
 
-    void renderButtonsTable(ButtonsTable& buttons_table, bool hold_active, double joypadDeadzone,
-                            const std::vector<float>& joypadAxisValues, const std::vector<bool>& joypadButtonValues,
-                            std::vector<double>& values) const
+    bool openWebPanel()
     {
-        //Define the size of the buttons
-        ImVec2 buttonSize(settings.button_size, settings.button_size);
-        const int& n_cols = buttons_table.numberOfColumns;
+        // The same tables of the GUI, with the hold button above the buttons
+        std::vector<WebPanelTable> tables;
+        auto addTable = [&tables](const ButtonsTable& table, int first_row) -> WebPanelTable&
+        {
+            WebPanelTable& web_table = tables.emplace_back();
+            web_table.name = table.name;
+            web_table.columns = table.numberOfColumns;
+            web_table.rows.resize(static_cast<size_t>(first_row));
+            for (const auto& row : table.rows)
+            {
+                auto& web_row = web_table.rows.emplace_back();
+                for (const ButtonState& button : row)
+                {
+                    web_row.push_back({ button.alias, button.mappingIndex, button.col });
+                }
+            }
+            return web_table;
+        };
+        for (const auto& stick : this->sticks)
+        {
+            addTable(stick, 0);
+        }
+        if (!this->buttons.rows.empty())
+        {
+            WebPanelTable& buttons_table = addTable(this->buttons, 1);
+            buttons_table.rows.front().push_back({ this->ctrl_button.alias, this->ctrl_button.mappingIndex, 0 });
+        }
 
-        ImGui::BeginTable(buttons_table.name.c_str(), n_cols, ImGuiTableFlags_NoSavedSettings | ImGuiTableFlags_SizingMask_);
+        this->web_panel_touched.assign(this->mapping.size(), 0);
+        this->web_panel_held.assign(this->mapping.size(), 0);
+        this->web_panel_highlighted.assign(this->mapping.size(), 0);
+        return this->web_panel.open(this->settings.web_panel_address, this->settings.web_panel_port, tables, this->mapping.size());
+    }
 
-        for (auto& row : buttons_table.rows)
+    // The keys go to the keyboard queue. The buttons act as clicked in the GUI, changing at most once per sample
+    // as the keys, so that a tap shorter than the sampling period is not lost. The other events wait for the next samples.
+    void applyWebPanelEvents()
+    {
+        if (!this->web_panel.isOpen())
         {
-            ImGui::TableNextRow();
+            return;
+        }
+        this->web_panel.takeEvents(this->web_panel_events);
+        std::fill(this->web_panel_touched.begin(), this->web_panel_touched.end(), uint8_t{ 0 });
 
-            for (auto& button : row)
+        size_t deferred = 0;
+        for (const WebPanelEvent& event : this->web_panel_events)
+        {
+            if (event.type == WebPanelEventType::KEY)
             {
-                ImGui::TableSetColumnIndex(button.col);
-
-                button.render(button_active_color, button_inactive_color, buttonSize, hold_active, joypadDeadzone, joypadAxisValues, joypadButtonValues, values);
+                this->keyboard.setKeyDown(static_cast<ImGuiKey>(event.index), event.down);
+                continue;
+            }
+            if (this->web_panel_touched[event.index])
+            {
+                this->web_panel_events[deferred++] = event;
+                continue;
+            }
+            this->web_panel_touched[event.index] = 1;
+            if (!event.down && this->web_panel_held[event.index])
+            {
+                this->mapping.markGuiClicked(event.index);
+                this->mapping.setGuiKeptPressed(event.index, false);
             }
-            if (row.empty())
+            this->web_panel_held[event.index] = event.down;
+        }
+        this->web_panel_events.resize(deferred);
+
+        // Set at every sample, since the GUI rewrites them when rendering
+        for (uint32_t id = 0; id < this->web_panel_held.size(); ++id)
+        {
+            if (this->web_panel_held[id])
             {
-                ImGui::TableSetColumnIndex(0);
-                ImGui::Dummy(buttonSize);
+                this->mapping.setGuiKeptPressed(id, true);
             }
         }
-        ImGui::EndTable();
     }
 
-    bool initialize()
+    // Samples the inputs and evaluates the outputs once. Returns false if no new input was available.
+    bool sampleOnce()
     {
-        glfwSetErrorCallback(&KeyboardJoypad::Impl::glfwErrorCallback);
-        if (!glfwInit()) {
-            yCError(KEYBOARDJOYPAD, "Unable to initialize GLFW");
-            return false;
+        for (auto& value : this->joypad_axis_values)
+        {
+            value = 0;
         }
 
-        this->window = glfwCreateWindow(this->settings.window_width, this->settings.window_height,
-            "YARP Keyboard as Joypad Device Window", nullptr, nullptr);
-        if (!this->window) {
-            yCError(KEYBOARDJOYPAD, "Could not create window");
-            return false;
+        for (size_t i = 0; i < this->joypad_button_values.size(); ++i) //The for(auto& v : ..) does not work with bool arrays
+        {
+            this->joypad_button_values[i] = false;
         }
 
-        glfwMakeContextCurrent(this->window);
-        glfwSwapInterval(1);
-
-        // Initialize the GLEW OpenGL 3.x bindings
-        // GLEW must be initialized after creating the window
-        glewExperimental = GL_TRUE;
-        GLenum err = glewInit();
-        if (err != GLEW_OK) {
-            yCError(KEYBOARDJOYPAD) << "glewInit failed, aborting.";
-            return false;
+        for (auto& value : this->joypad_hat_values)
+        {
+            value = 0;
         }
-        yCInfo(KEYBOARDJOYPAD) << "Using GLEW" << (const char*)glewGetString(GLEW_VERSION);
 
-        glDebugMessageControl(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_OTHER, GL_DEBUG_SEVERITY_NOTIFICATION, 0, NULL, GL_FALSE); //This is to ignore message 0x20071 about the use of the VIDEO memory
+        this->refreshJoypads();
 
-        glDebugMessageCallback(&KeyboardJoypad::Impl::GLMessageCallback, NULL);
-        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-        glEnable(GL_DEBUG_OUTPUT);
+        int64_t sample_time = this->measure_latency ? LatencyStatistics::now() : 0;
+
+        {
+            TraceScope trace_scope(&this->trace, "read inputs");
+            if (!this->input_backend->sample(this->keyboard, this->joypads, this->joypad_axis_values, this->joypad_button_values))
+            {
+                return false;
+            }
+            this->input_backend->sampleHats(this->joypads, this->joypad_hat_values);
+        }
+        double timestamp = yarp::os::Time::now(); //Acquisition time of the sample
 
+        this->applyWebPanelEvents();
 
-        // Setup Dear ImGui context
-        IMGUI_CHECKVERSION();
-        ImGui::CreateContext();
-        ImGuiIO& io = ImGui::GetIO();
-        io.ConfigFlags |= ImGuiConfigFlags_NavNoCaptureKeyboard;
+        // The keys from the window, the ones set through IKeyboardJoypadInput and the ones from the web panel are queued
+        this->keyboard.applyQueuedEvents();
 
-        // Setup Dear ImGui style
-        ImGui::StyleColorsDark();
+        bool joypad_changed = this->detectJoypadChanges();
+        int64_t input_time = this->measure_latency ? this->inputArrivalTime(sample_time, joypad_changed) : 0;
 
-        // Setup Platform/Renderer backends
-        ImGui_ImplGlfw_InitForOpenGL(this->window, true);
-        ImGui_ImplOpenGL3_Init();
+        float deadzone = this->settings.deadzone;
+        if (this->replay_backend)
+        {
+            const RecordingReader::Frame& frame = this->replay_backend->currentFrame();
+            deadzone = frame.deadzone;
+            timestamp = frame.timestamp;
+            if (this->replay_gui_events)
+            {
+                this->applyReplayedGuiEvents(frame);
+            }
+        }
 
-        for (int i = GLFW_JOYSTICK_1; i <= GLFW_JOYSTICK_LAST; ++i) {
-            if (glfwJoystickPresent(i)) {
-                int axes_count, button_count;
-                glfwGetJoystickAxes(i, &axes_count);
-                glfwGetJoystickButtons(i, &button_count);
-                std::string name {glfwGetJoystickName(i)};
-                this->joypads.push_back({ .name = name, .index = i, .axes = axes_count, .buttons = button_count });
-                yCInfo(KEYBOARDJOYPAD) << "Joypad" << name << "is available (index" << i
-                                       << "axes =" << axes_count << "buttons = " << button_count << ").";
+        if (this->recorder.isOpen())
+        {
+            this->recorder.beginFrame(timestamp, deadzone);
+            this->recorder.addKeyEdges(this->keyboard);
+            for (uint32_t id = 0; id < this->mapping.size(); ++id)
+            {
+                if (this->mapping.isGuiClicked(id) || this->mapping.isGuiKeptPressed(id))
+                {
+                    this->recorder.addGuiEvent(id, this->mapping.isGuiClicked(id), this->mapping.isGuiKeptPressed(id));
+                }
             }
         }
 
-        if (!this->joypads.size()) {
-            yCInfo(KEYBOARDJOYPAD) << "No joypad found.";
+        int64_t evaluation_start = this->trace.enabled() ? LatencyStatistics::now() : 0;
+
+        if (this->joypad_conditioning.enabled())
+        {
+            // The conditioning includes the deadzone
+            this->joypad_conditioning.apply(this->joypad_axis_values, deadzone, timestamp, this->conditioned_joypad_axis_values);
+            this->mapping.evaluate(this->keyboard, 0.0f, this->conditioned_joypad_axis_values, this->joypad_button_values,
+                                   this->axes_values, this->buttons_values);
+        }
+        else
+        {
+            this->mapping.evaluate(this->keyboard, deadzone, this->joypad_axis_values, this->joypad_button_values,
+                                   this->axes_values, this->buttons_values);
         }
 
-        size_t axes_offset = 0;
-        size_t buttons_offset = 0;
+        if (this->axis_pipeline.enabled())
+        {
+            this->axis_pipeline.apply(this->axes_values, timestamp);
+        }
 
-        for (int& joypad_index : this->settings.joypad_indices)
+        this->passthrough.apply(this->joypad_axis_values, this->joypad_button_values, this->joypad_hat_values,
+                                this->axes_values, this->buttons_values, this->hat_values);
+
+        //Update sticks values from axes values
+        for (size_t i = 0; i < this->sticks_to_axes.size(); ++i)
         {
-            if (joypad_index >= this->joypads.size())
+            for (size_t j = 0; j < this->sticks_to_axes[i].size(); j++)
             {
-                yCWarning(KEYBOARDJOYPAD) << "The joypad with index" << joypad_index << "is not available. It will be skipped";
-                continue;
+                this->sticks_values[i][j] = this->axes_values[this->sticks_to_axes[i][j]];
             }
-            this->joypads[static_cast<size_t>(joypad_index)].axes_offset = axes_offset;
-            this->joypads[static_cast<size_t>(joypad_index)].buttons_offset = buttons_offset;
-            this->joypads[static_cast<size_t>(joypad_index)].active = true;
-            axes_offset += this->joypads[static_cast<size_t>(joypad_index)].axes;
-            buttons_offset += this->joypads[static_cast<size_t>(joypad_index)].buttons;
-            this->using_joypad = true;
         }
-        this->joypad_axis_values.resize(axes_offset, 0.0);
-        this->joypad_button_values.resize(buttons_offset, false);
 
-        this->button_inactive_color = ImGui::GetStyle().Colors[ImGuiCol_Button];
-        this->button_active_color = ImVec4(0.7f, 0.5f, 0.3f, 1.0f);
+        int64_t publish_start = this->trace.enabled() ? LatencyStatistics::now() : 0;
+        this->trace.record("mapping evaluation", evaluation_start, publish_start);
 
-        this->gui_thread_id = std::this_thread::get_id();
-        this->initialized = true;
+        if (this->recorder.isOpen())
+        {
+            this->recorder.endFrame(this->joypad_axis_values, this->joypad_button_values,
+                                    this->axes_values, this->buttons_values, this->sticks_values);
+        }
 
-        return true;
-    }
+        if (this->replay_backend)
+        {
+            this->replay_backend->compareOutputs(this->axes_values, this->buttons_values, this->sticks_values);
+        }
 
-    void prepareFrame()
-    {
-        glfwPollEvents();
+        this->keyboard.clearEdges();
 
-        // Start the Dear ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+        int64_t mapping_time = input_time ? LatencyStatistics::now() : 0;
+
+        //Make the new outputs available to the getters
+        this->input_stamp.update(timestamp);
+        this->outputs_snapshot.publish(this->input_stamp, this->axes_values, this->buttons_values, this->hat_values, this->sticks_values);
+        this->shared_state.write(timestamp, this->axes_values, this->buttons_values, this->sticks_values);
 
-        for (double& value : this->axes_values)
+        if (input_time)
         {
-            value = 0;
+            int64_t publish_time = LatencyStatistics::now();
+            this->latency.record(LatencyStage::InputToMapping, mapping_time - input_time);
+            this->latency.record(LatencyStage::MappingToPublish, publish_time - mapping_time);
+            this->latency.outputsPublished(input_time, publish_time);
         }
 
-        for (double& value : this->buttons_values)
+        //The joypad values are shown in the GUI, hence their changes require a redraw as well
+        if (this->detectChanges() || joypad_changed)
         {
-            value = 0;
+            this->requestRedraw();
         }
 
-        for (auto& value : this->ctrl_value)
+        if (this->state_publisher)
         {
-            value = 0;
+            this->state_publisher->publish(timestamp, this->axes_values, this->buttons_values);
         }
 
-        for (auto& value : this->joypad_axis_values)
+        if (this->web_panel.hasClients())
         {
-            value = 0;
+            for (uint32_t id = 0; id < this->mapping.size(); ++id)
+            {
+                this->web_panel_highlighted[id] = this->mapping.isHighlighted(id);
+            }
+            this->web_panel.publishHighlighted(this->web_panel_highlighted);
         }
 
-        for (size_t i = 0; i < this->joypad_button_values.size(); ++i) //The for(auto& v : ..) does not work with bool arrays
+        if (publish_start)
         {
-            this->joypad_button_values[i] = false;
+            this->trace.record("publish", publish_start, LatencyStatistics::now());
         }
+
+        return true;
     }
 
-    void update()
+    void sampleInputs()
+    {
+        TraceScope trace_scope(&this->trace, "sampleInputs");
+        // More than one sample might be available, e.g. when replaying a recording faster than real time
+        bool sampled = this->sampleOnce();
+        while (sampled && this->input_backend->samplePending())
+        {
+            sampled = this->sampleOnce();
+        }
+
+        double now = yarp::os::Time::now();
+        if (this->last_input_sample_time > 0)
+        {
+            //Exponential moving average of the sampling period, only for visualization
+            this->measured_input_period = 0.99 * this->measured_input_period + 0.01 * (now - this->last_input_sample_time);
+        }
+        this->last_input_sample_time = now;
+    }
+
+    // Position of an id without a pending change
+    static constexpr size_t noPendingChange = std::numeric_limits<size_t>::max();
+
+    // Returns the pending change of the id, adding it if not present yet
+    template <typename T>
+    static yarp::dev::IJoypadEvent::joyData<T>& pendingChange(std::vector<yarp::dev::IJoypadEvent::joyData<T>>& changes,
+                                                              std::vector<size_t>& positions, size_t id)
     {
+        if (positions[id] == noPendingChange)
+        {
+            positions[id] = changes.size();
+            changes.emplace_back(static_cast<unsigned int>(id), T());
+        }
+        return changes[positions[id]];
+    }
 
-        if (!this->initialized || this->gui_thread_id != std::this_thread::get_id())
+    template <typename T>
+    static void clearPendingChanges(std::vector<yarp::dev::IJoypadEvent::joyData<T>>& changes, std::vector<size_t>& positions)
+    {
+        for (const auto& change : changes)
         {
-            return;
+            positions[change.m_id] = noPendingChange;
         }
+        changes.clear();
+    }
 
-        this->prepareFrame();
+    // Returns whether any output changed since the last sample
+    bool detectChanges()
+    {
+        bool collect = this->event_driven;
+        bool changed = false;
 
-        if (this->using_joypad)
+        for (size_t i = 0; i < this->axes_values.size(); ++i)
         {
-            for (auto& joypad : this->joypads)
+            if (this->axes_values[i] != this->previous_axes_values[i])
             {
-                if (!glfwJoystickPresent(joypad.index) || !joypad.active)
+                changed = true;
+                if (collect)
                 {
-                    continue;
+                    pendingChange(this->changed_axes, this->changed_axes_positions, i).m_datum = this->axes_values[i];
                 }
+                this->previous_axes_values[i] = this->axes_values[i];
+            }
+        }
 
-                int new_axes, new_buttons;
-                const float* axes = glfwGetJoystickAxes(joypad.index, &new_axes);
-                const unsigned char* buttons = glfwGetJoystickButtons(joypad.index, &new_buttons);
+        for (size_t i = 0; i < this->buttons_values.size(); ++i)
+        {
+            if (this->buttons_values[i] != this->previous_buttons_values[i])
+            {
+                changed = true;
+                if (collect)
+                {
+                    pendingChange(this->changed_buttons, this->changed_buttons_positions, i).m_datum = static_cast<float>(this->buttons_values[i]);
+                }
+                this->previous_buttons_values[i] = this->buttons_values[i];
+            }
+        }
 
-                for (size_t i = 0; i < std::min(joypad.axes, new_axes); ++i)
+        for (size_t i = 0; i < this->hat_values.size(); ++i)
+        {
+            if (this->hat_values[i] != this->previous_hat_values[i])
+            {
+                changed = true;
+                if (collect)
                 {
-                    this->joypad_axis_values[joypad.axes_offset + i] = axes[i];
+                    pendingChange(this->changed_hats, this->changed_hats_positions, i).m_datum = this->hat_values[i];
                 }
+                this->previous_hat_values[i] = this->hat_values[i];
+            }
+        }
 
-                for (size_t i = 0; i < std::min(joypad.buttons, new_buttons); ++i)
+        for (size_t i = 0; i < this->sticks_values.size(); ++i)
+        {
+            if (this->sticks_values[i] != this->previous_sticks_values[i])
+            {
+                changed = true;
+                if (collect)
                 {
-                    this->joypad_button_values[joypad.buttons_offset + i] = buttons[i] == GLFW_PRESS;
+                    bool added = this->changed_sticks_positions[i] == noPendingChange;
+                    yarp::sig::Vector& stick = pendingChange(this->changed_sticks, this->changed_sticks_positions, i).m_datum;
+                    if (added)
+                    {
+                        std::swap(stick, this->stick_event_buffers[i]);
+                    }
+                    if (stick.size() != this->sticks_values[i].size())
+                    {
+                        stick.resize(this->sticks_values[i].size());
+                    }
+                    for (size_t j = 0; j < stick.size(); ++j)
+                    {
+                        stick[j] = this->sticks_values[i][j];
+                    }
                 }
+                this->previous_sticks_values[i] = this->sticks_values[i];
+            }
+        }
+
+        return changed;
+    }
+
+    // To be called after update(), without holding the mutex
+    void dispatchEvents()
+    {
+        if (this->gui_thread_id != std::this_thread::get_id())
+        {
+            return;
+        }
+
+        if (this->changed_axes.empty() && this->changed_buttons.empty() && this->changed_hats.empty() && this->changed_sticks.empty())
+        {
+            return;
+        }
+
+        TraceScope trace_scope(&this->trace, "dispatch events");
+
+        {
+            std::lock_guard<std::mutex> lock(this->event_mutex);
+            if (this->event)
+            {
+                this->event->action(this->changed_buttons, this->changed_axes, this->changed_hats, {}, this->changed_sticks, {});
             }
         }
 
+        clearPendingChanges(this->changed_axes, this->changed_axes_positions);
+        clearPendingChanges(this->changed_buttons, this->changed_buttons_positions);
+        clearPendingChanges(this->changed_hats, this->changed_hats_positions);
+        for (auto& stick : this->changed_sticks)
+        {
+            std::swap(stick.m_datum, this->stick_event_buffers[stick.m_id]);
+        }
+        clearPendingChanges(this->changed_sticks, this->changed_sticks_positions);
+    }
+
+    // Builds the ImGui frame, without drawing it. It does not depend on the platform and renderer backends.
+    void buildFrame()
+    {
+        int64_t frame_start = this->trace.enabled() ? LatencyStatistics::now() : 0;
+        ImGui::NewFrame();
+
         ImVec2 position(this->settings.padding, this->settings.padding);
         float button_table_height = position.y;
         for (auto& stick : this->sticks)
         {
             position.y = this->settings.padding; //Keep the sticks on the save level
             this->prepareWindow(position, stick.name);
-            this->renderButtonsTable(stick, false, this->settings.deadzone,
-                       this->joypad_axis_values, this->joypad_button_values,this->axes_values);
+            this->renderButtonsTable(stick);
             ImGui::End();
             position.x += stick.numberOfColumns * this->settings.button_size + this->settings.padding; // Move the next table to the right (n columns + 1 space)
             position.y += stick.rows.size() * this->settings.button_size + this->settings.padding; // Move the next table down (n rows + 1 space)
             button_table_height = std::max(button_table_height, position.y);
         }
 
-        //Clamp axes values to the range -1, 1
-        for (auto& axis_value : this->axes_values)
-        {
-            if (axis_value > 1)
-            {
-                axis_value = 1;
-            }
-            else if (axis_value < -1)
-            {
-                axis_value = -1;
-            }
-        }
-
-        //Update sticks values from axes values
-        for (size_t i = 0; i < this->sticks_to_axes.size(); ++i)
-        {
-            for (size_t j = 0; j < this->sticks_to_axes[i].size(); j++)
-            {
-                this->sticks_values[i][j] = this->axes_values[this->sticks_to_axes[i][j]];
-            }
-        }
-
         if (!this->buttons.rows.empty())
         {
             position.y = this->settings.padding; //Keep the buttons on the save level of the sticks
@@ -997,128 +2566,258 @@ public:
             ImGui::BeginTable("Buttons_layout", 1, ImGuiTableFlags_NoSavedSettings | ImGuiTableFlags_SizingMask_ | ImGuiTableFlags_BordersInner);
             ImGui::TableNextRow();
             ImGui::TableSetColumnIndex(0);
-            this->ctrl_button.render(this->button_active_color, this->button_inactive_color, ImVec2(this->settings.button_size, this->settings.button_size), false, this->settings.deadzone,
-                       this->joypad_axis_values, this->joypad_button_values, this->ctrl_value);
+            this->ctrl_button.render(this->mapping, this->button_active_color, this->button_inactive_color, ImVec2(this->settings.button_size, this->settings.button_size));
             ImGui::TableNextRow();
             ImGui::TableSetColumnIndex(0);
-            bool hold_active = this->ctrl_value.front() > 0;
-            this->renderButtonsTable(this->buttons, hold_active, this->settings.deadzone,
-                       this->joypad_axis_values, this->joypad_button_values, this->buttons_values);
-            ImGui::EndTable();
-            ImGui::End();
-        }
-
-        //Apply clamping to buttons values in the range 0, 1 and round them to 0 or 1
-        for (auto& button_value : this->buttons_values)
-        {
-            if (button_value > 0)
-            {
-                button_value = 1;
-            }
-            else
+            // The filter is shown only when the buttons do not fit in the window
+            if (this->buttons_table_scrolls || this->buttons_filter.IsActive())
             {
-                button_value = 0;
+                this->buttons_filter.Draw("Filter", this->buttons.numberOfColumns * this->settings.button_size);
             }
+            const ImGuiStyle& style = ImGui::GetStyle();
+            float max_height = ImGui::GetIO().DisplaySize.y - ImGui::GetCursorScreenPos().y - style.WindowPadding.y - 2.0f * style.CellPadding.y;
+            this->buttons_table_scrolls = this->renderButtonsTable(this->buttons, max_height, &this->buttons_filter);
+            ImGui::EndTable();
+            ImGui::End();
         }
 
         position.x = this->settings.padding; //Reset the x position
         position.y = button_table_height; //Move the next table down
 
+        int64_t settings_start = this->trace.enabled() ? LatencyStatistics::now() : 0;
+        this->trace.record("sticks and buttons tables", frame_start, settings_start);
         this->prepareWindow(position, "Settings");
         ImGuiIO& io = ImGui::GetIO();
         ImGui::Text("Application average %.1f ms/frame (%.1f FPS)", io.DeltaTime * 1000.0f, io.Framerate);
+        ImGui::Text("Input sampling period %.2f ms", this->measured_input_period * 1000.0);
+        ImGui::Text("Skipped frames %.0f%% (CPU saved: %.1f%% of a core)", this->skipped_frames_ratio * 100.0, this->cpu_savings * 100.0);
+        ImGui::Text("Last frame: build %.2f ms, ImGui::Render %.2f ms, draw %.2f ms", this->frame_build_time * 1000.0,
+                    this->frame_imgui_render_time * 1000.0, this->frame_draw_time * 1000.0);
+        uint64_t dropped_key_events = this->keyboard.events.droppedEvents();
+        if (dropped_key_events > 0)
+        {
+            ImGui::Text("Dropped key events %llu", static_cast<unsigned long long>(dropped_key_events));
+        }
 
-        int width, height;
-        glfwGetWindowSize(this->window, &width, &height);
-
-        ImGui::Text("Window size: %d x %d", width, height);
+        ImGui::Text("Window size: %d x %d", static_cast<int>(io.DisplaySize.x), static_cast<int>(io.DisplaySize.y));
         ImGui::SliderFloat("Button size", &this->settings.button_size, this->settings.min_button_size, this->settings.max_button_size);
         ImGui::SliderFloat("Font multiplier", &this->settings.font_multiplier, this->settings.min_font_multiplier, this->settings.max_font_multiplier);
         if (this->using_joypad)
         {
             ImGui::SliderFloat("Joypad deadzone", &this->settings.deadzone, 0.0, 1.0);
             // Display the joypad values
-            std::string connectedJoypads = "Connected joypads: ";
+            this->gui_text.clear();
+            this->gui_text.append("Connected joypads: ");
             for (size_t i = 0; i < this->joypads.size(); ++i)
             {
-                connectedJoypads += this->joypads[i].name;
-                if (i != this->joypads.size() - 1)
-                {
-                    connectedJoypads += ", ";
-                }
+                this->gui_text.append(i == 0 ? "%s" : ", %s", this->joypads[i].name.c_str());
             }
             ImGui::Separator();
-            ImGui::Text(connectedJoypads.c_str());
-            std::string axes_values = "Joypad axes values: ";
+            ImGui::TextUnformatted(this->gui_text.c_str());
+
+            this->gui_text.clear();
+            this->gui_text.append("Joypad axes values: ");
             for (size_t i = 0; i < this->joypad_axis_values.size(); ++i)
             {
-                // Print the values of the axes in the format "axis_index: value" with a 1 decimal precision
-                std::stringstream stream;
-                stream << std::fixed << std::setprecision(2) << this->joypad_axis_values[i];
-                std::string sign = this->joypad_axis_values[i] >= 0 ? "+" : "";
-                axes_values += "<" + std::to_string(i) + "> " + sign + stream.str();
-                if (i != this->joypad_axis_values.size() - 1)
-                {
-                    axes_values += ", ";
-                }
+                // Print the values of the axes in the format "<axis_index> value" with a 2 decimal precision
+                this->gui_text.append(i == 0 ? "<%zu> %+.2f" : ", <%zu> %+.2f", i, this->joypad_axis_values[i]);
             }
-            ImGui::Text(axes_values.c_str());
-            std::string buttons_values = "Joypad buttons values: ";
+            ImGui::TextUnformatted(this->gui_text.c_str());
+
+            this->gui_text.clear();
+            this->gui_text.append("Joypad buttons values: ");
             for (size_t i = 0; i < this->joypad_button_values.size(); ++i)
             {
-                buttons_values += "<" + std::to_string(i) + "> " + (this->joypad_button_values[i] ? "1" : "0");
-                if (i != this->joypad_button_values.size() - 1)
+                this->gui_text.append(i == 0 ? "<%zu> %d" : ", <%zu> %d", i, this->joypad_button_values[i] ? 1 : 0);
+            }
+            ImGui::TextUnformatted(this->gui_text.c_str());
+
+            if (!this->joypad_hat_values.empty())
+            {
+                this->gui_text.clear();
+                this->gui_text.append("Joypad hats values: ");
+                for (size_t i = 0; i < this->joypad_hat_values.size(); ++i)
                 {
-                    buttons_values += ", ";
+                    this->gui_text.append(i == 0 ? "<%zu> %d" : ", <%zu> %d", i, this->joypad_hat_values[i]);
                 }
+                ImGui::TextUnformatted(this->gui_text.c_str());
             }
-            ImGui::Text(buttons_values.c_str());
         }
         ImGui::Separator();
-        std::string output_axes_values = "Output axes values: ";
+        this->gui_text.clear();
+        this->gui_text.append("Output axes values: ");
         for (size_t i = 0; i < this->axes_values.size(); ++i)
         {
-            // Print the values of the axes in the format "axis_index: value" with a 1 decimal precision
-            std::stringstream stream;
-            stream << std::fixed << std::setprecision(2) << this->axes_values[i];
-            std::string sign = this->axes_values[i] >= 0 ? "+" : "";
-            output_axes_values += "<" + std::to_string(i) + "> " + sign + stream.str();
-            if (i != this->axes_values.size() - 1)
-            {
-                output_axes_values += ", ";
-            }
+            this->gui_text.append(i == 0 ? "<%zu> %+.2f" : ", <%zu> %+.2f", i, this->axes_values[i]);
         }
-        ImGui::Text(output_axes_values.c_str());
-        std::string output_buttons_values = "Output buttons values: ";
+        ImGui::TextUnformatted(this->gui_text.c_str());
+
+        this->gui_text.clear();
+        this->gui_text.append("Output buttons values: ");
         if (this->buttons_values.empty())
         {
-            output_buttons_values += "None";
+            this->gui_text.append("None");
         }
         for (size_t i = 0; i < this->buttons_values.size(); ++i)
         {
-            std::stringstream stream;
-            stream << std::fixed << std::setprecision(1) << this->buttons_values[i];
-            output_buttons_values += "<" + std::to_string(i) + "> " + stream.str();
-            if (i != this->buttons_values.size() - 1)
+            this->gui_text.append(i == 0 ? "<%zu> %.1f" : ", <%zu> %.1f", i, this->buttons_values[i]);
+        }
+        ImGui::TextUnformatted(this->gui_text.c_str());
+
+        if (!this->hat_values.empty())
+        {
+            this->gui_text.clear();
+            this->gui_text.append("Output hats values: ");
+            for (size_t i = 0; i < this->hat_values.size(); ++i)
             {
-                output_buttons_values += ", ";
+                this->gui_text.append(i == 0 ? "<%zu> %d" : ", <%zu> %d", i, this->hat_values[i]);
             }
+            ImGui::TextUnformatted(this->gui_text.c_str());
         }
-        ImGui::Text(output_buttons_values.c_str());
         ImGui::End();
 
-        // Rendering
+        int64_t render_start = LatencyStatistics::now();
+        this->trace.record("Settings window", settings_start, render_start);
         ImGui::Render();
+        int64_t render_end = LatencyStatistics::now();
+        this->frame_imgui_render_time = (render_end - render_start) * 1e-9;
+        this->item_active = ImGui::IsAnyItemActive();
+        this->trace.record("ImGui::Render", render_start, render_end);
+    }
+
+    void render()
+    {
+        // The GUI thread can be shared with other devices, each with its own OpenGL and ImGui contexts
+        glfwMakeContextCurrent(this->window);
+        ImGui::SetCurrentContext(this->imgui_context);
+
+        // Start the Dear ImGui frame
+        int64_t build_start = LatencyStatistics::now();
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        this->trace.record("backends new frame", build_start, LatencyStatistics::now());
+        this->buildFrame();
+        int64_t draw_start = LatencyStatistics::now();
+
+        // Rendering
         int display_w, display_h;
         glfwGetFramebufferSize(this->window, &display_w, &display_h);
+        if (this->settings.offscreen)
+        {
+            this->resizeOffscreenFramebuffer(display_w, display_h);
+            glBindFramebuffer(GL_FRAMEBUFFER, this->offscreen_framebuffer);
+        }
         glViewport(0, 0, display_w, display_h);
         glClearColor(this->clear_color.x * this->clear_color.w, this->clear_color.y * this->clear_color.w, this->clear_color.z * this->clear_color.w, this->clear_color.w);
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
-        glfwSwapBuffers(this->window);
+        if (this->settings.offscreen)
+        {
+            // Nothing is presented. Waiting for the rasterizer includes its cost in the draw time.
+            glFinish();
+        }
+        int64_t draw_end = LatencyStatistics::now();
+        this->frame_build_time = (draw_start - build_start) * 1e-9 - this->frame_imgui_render_time;
+        this->frame_draw_time = (draw_end - draw_start) * 1e-9;
+        this->trace.record("GL draw", draw_start, draw_end);
+
+        if (!this->settings.offscreen)
+        {
+            TraceScope trace_scope(&this->trace, "glfwSwapBuffers");
+            glfwSwapBuffers(this->window);
+        }
+    }
+
+    // After a change, a few frames are drawn to let ImGui update the hovered and active widgets
+    static constexpr int framesAfterChange = 3;
+
+    // Even when nothing changes, the window is redrawn with this period, e.g. to update the FPS counter
+    static constexpr double idleRedrawPeriod = 1.0;
+
+    void requestRedraw()
+    {
+        this->frames_to_render = framesAfterChange;
+    }
+
+    // Whether the frame has to be drawn, or if it can be skipped since it would be the same as the last presented one
+    bool needRender(double now)
+    {
+        if (this->glfw_backend)
+        {
+            if (this->glfw_backend->consumeWindowEvents())
+            {
+                this->requestRedraw();
+            }
+            if (this->glfw_backend->isIconified())
+            {
+                return false;
+            }
+        }
+        // The current ImGui context might be the one of another device, or none, hence the state of the last frame is used
+        return this->frames_to_render > 0 || this->item_active || now - this->last_presented_time > idleRedrawPeriod;
+    }
+
+    void updateRenderSavings(double now)
+    {
+        if (this->savings_window_start == 0.0)
+        {
+            this->savings_window_start = now;
+        }
+        double window = now - this->savings_window_start;
+        if (window < 1.0)
+        {
+            return;
+        }
+        size_t frames = this->rendered_frames + this->skipped_frames;
+        this->skipped_frames_ratio = frames > 0 ? static_cast<double>(this->skipped_frames) / static_cast<double>(frames) : 0.0;
+        this->cpu_savings = static_cast<double>(this->skipped_frames) * this->render_cpu_time / window;
+        this->rendered_frames = 0;
+        this->skipped_frames = 0;
+        this->savings_window_start = now;
+    }
+
+    // Whether the calling thread owns the window, hence it can sample the inputs and draw the GUI
+    bool onGuiThread() const
+    {
+        return this->initialized && this->gui_thread_id == std::this_thread::get_id();
+    }
+
+    // Samples the inputs and draws the GUI when due
+    void update()
+    {
+        if (!this->onGuiThread())
+        {
+            return;
+        }
+
+        TraceScope trace_scope(&this->trace, "update");
+        this->sampleInputs();
+        this->renderIfDue();
+    }
 
-        this->last_gui_update_time = yarp::os::Time::now();
+    void renderIfDue()
+    {
+        if (this->renderDue())
+        {
+            double now = yarp::os::Time::now();
+            this->last_gui_update_time = now;
+            if (this->needRender(now))
+            {
+                double cpu_time = threadCpuTime();
+                this->render();
+                cpu_time = threadCpuTime() - cpu_time;
+                this->render_cpu_time = this->rendered_frames == 0 && this->render_cpu_time == 0.0 ? cpu_time : 0.9 * this->render_cpu_time + 0.1 * cpu_time;
+                this->rendered_frames++;
+                this->last_presented_time = now;
+                this->frames_to_render = std::max(0, this->frames_to_render - 1);
+            }
+            else
+            {
+                this->skipped_frames++;
+            }
+            this->updateRenderSavings(now);
+        }
     }
 
     bool needUpdate() const
@@ -1127,42 +2826,155 @@ public:
         {
             return false;
         }
-        return yarp::os::Time::now() - this->last_gui_update_time > this->settings.gui_period;
+        return yarp::os::Time::now() - this->last_input_sample_time > this->settings.input_period;
+    }
+
+    bool renderDue() const
+    {
+        if (this->closed || !this->gui_initialized)
+        {
+            return false;
+        }
+        //Half input period of tolerance, to avoid skipping a frame because of the jitter of the input sampling
+        return yarp::os::Time::now() - this->last_gui_update_time > this->settings.gui_period - 0.5 * this->settings.input_period;
+    }
+
+    bool updateIfSingleThreaded()
+    {
+        // In multi threaded mode the getters only read the outputs snapshot, without waiting for the GUI
+        if (!this->settings.single_threaded)
+        {
+            if (this->measure_latency)
+            {
+                this->latency.outputsRead();
+            }
+            return true;
+        }
+
+        if (!this->initialized)
+        {
+            auto lock = this->lockMutex();
+            if (!this->initialized && !this->initialize())
+            {
+                return false;
+            }
+        }
+
+        // Off the GUI thread, e.g. in the thread of the wrapper while updateService draws a frame, the getters only
+        // read the outputs snapshot. On the GUI thread, only the inputs are sampled, so that a getter never waits
+        // for a frame to be drawn and swapped. The GUI is drawn only by updateService.
+        if (this->onGuiThread() && this->needUpdate())
+        {
+            auto lock = this->lockMutex();
+            this->sampleInputs();
+        }
+        if (this->measure_latency)
+        {
+            this->latency.outputsRead();
+        }
+        this->dispatchEvents();
+        return true;
     }
 
     void close()
     {
         if (this->closed || !this->initialized)
+        {
+            // The outputs are opened before the initialization, e.g. before the first updateService
+            this->closeOutputs();
             return;
+        }
+
+        if (this->gui_initialized)
+        {
+            glfwMakeContextCurrent(this->window);
+            ImGui::SetCurrentContext(this->imgui_context);
+            this->glfw_backend->setImGuiContext(nullptr);
+            this->deleteOffscreenFramebuffer();
+            ImGui_ImplOpenGL3_Shutdown();
+            ImGui_ImplGlfw_Shutdown();
+            ImGui::DestroyContext(this->imgui_context);
+            this->imgui_context = nullptr;
+            this->gui_initialized = false;
+        }
+
+        if (this->input_backend)
+        {
+            this->input_backend->close();
+        }
 
-        ImGui_ImplOpenGL3_Shutdown();
-        ImGui_ImplGlfw_Shutdown();
-        ImGui::DestroyContext();
+        this->recorder.close();
+
+        // Closed here, since they are written by the thread sampling the inputs
+        this->closeOutputs();
 
         if (this->window)
         {
             glfwDestroyWindow(this->window);
-            glfwTerminate();
+            GuiRuntime::releaseGlfw();
             this->window = nullptr;
         }
 
         this->closed = true;
     }
 
+    bool guiThreadInit() override
+    {
+        if (this->closed)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        return this->initialize();
+    }
+
+    bool guiThreadRun() override
+    {
+        if (this->closed)
+        {
+            return false;
+        }
+
+        {
+            auto lock = this->lockMutex();
+            if (this->settings.allow_window_closing && this->window)
+            {
+                this->need_to_close = glfwWindowShouldClose(this->window);
+            }
+            if (!this->need_to_close)
+            {
+                this->update();
+            }
+        }
+
+        this->dispatchEvents();
+
+        // When the window is closed, the device is released by the GUI runtime
+        return !this->need_to_close;
+    }
+
+    void guiThreadRelease() override
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+
+        this->close();
+    }
+
 };
 
 
 
 yarp::dev::KeyboardJoypad::KeyboardJoypad()
-    : yarp::dev::DeviceDriver(),
-    yarp::os::PeriodicThread(0.033, yarp::os::ShouldUseSystemClock::Yes)
+    : yarp::dev::DeviceDriver()
 {
     m_pimpl = std::make_unique<Impl>();
 }
 
 yarp::dev::KeyboardJoypad::~KeyboardJoypad()
 {
-    this->stop();
+    GuiRuntime::removeClient(m_pimpl.get());
     m_pimpl->close();
 }
 
@@ -1208,7 +3020,7 @@ bool yarp::dev::KeyboardJoypad::open(yarp::os::Searchable& cfg)
                 values.push_back({ .sign = -ws_settings.sign, .index = ws_settings.index });
             }
             wasd.rows.push_back({ {.alias = "W", .type = ButtonType::TOGGLE, .keys = {ImGuiKey_W}, .values = values,
-                                   .joypadAxisInputs = {{.sign = -1, .index = static_cast<size_t>(m_pimpl->axes_settings.ws_joypad_axis_index)}},
+                                   .joypadAxisInputs = {{.sign = -1, .index = m_pimpl->axes_settings.ws_joypad_axis_index}},
                                    .col = ad} });
         }
         if (ad)
@@ -1227,10 +3039,10 @@ bool yarp::dev::KeyboardJoypad::open(yarp::os::Searchable& cfg)
             }
 
             wasd.rows.push_back({ {.alias = "A", .type = ButtonType::TOGGLE, .keys = {ImGuiKey_A}, .values = a_values,
-                                   .joypadAxisInputs = {{.sign = -1, .index = static_cast<size_t>(m_pimpl->axes_settings.ad_joypad_axis_index)}},
+                                   .joypadAxisInputs = {{.sign = -1, .index = m_pimpl->axes_settings.ad_joypad_axis_index}},
                                    .col = 0},
                                   {.alias = "D", .type = ButtonType::TOGGLE, .keys = {ImGuiKey_D}, .values = d_values,
-                                   .joypadAxisInputs = {{.sign = +1, .index = static_cast<size_t>(m_pimpl->axes_settings.ad_joypad_axis_index)}},
+                                   .joypadAxisInputs = {{.sign = +1, .index = m_pimpl->axes_settings.ad_joypad_axis_index}},
                                    .col = 2} });
         }
         else
@@ -1251,7 +3063,7 @@ bool yarp::dev::KeyboardJoypad::open(yarp::os::Searchable& cfg)
             }
 
             wasd.rows.push_back({ {.alias = "S", .type = ButtonType::TOGGLE, .keys = {ImGuiKey_S}, .values = values,
-                                   .joypadAxisInputs = {{.sign = +1, .index = static_cast<size_t>(m_pimpl->axes_settings.ws_joypad_axis_index)}},
+                                   .joypadAxisInputs = {{.sign = +1, .index = m_pimpl->axes_settings.ws_joypad_axis_index}},
                                    .col = ad}});
         }
     }
@@ -1271,7 +3083,7 @@ bool yarp::dev::KeyboardJoypad::open(yarp::os::Searchable& cfg)
                 values.push_back({ .sign = -ws_settings.sign, .index = ws_settings.index });
             }
             arrows.rows.push_back({ {.alias = "top", .type = ButtonType::TOGGLE, .keys = {ImGuiKey_UpArrow}, .values = values,
-                                     .joypadAxisInputs = {{.sign = -1, .index = static_cast<size_t>(m_pimpl->axes_settings.up_down_joypad_axis_index)}},
+                                     .joypadAxisInputs = {{.sign = -1, .index = m_pimpl->axes_settings.up_down_joypad_axis_index}},
                                      .col = left_right} });
         }
         if (left_right)
@@ -1289,10 +3101,10 @@ bool yarp::dev::KeyboardJoypad::open(yarp::os::Searchable& cfg)
                 m_pimpl->sticks_values.back().push_back(0);
             }
             arrows.rows.push_back({ {.alias = "left", .type = ButtonType::TOGGLE, .keys = {ImGuiKey_LeftArrow}, .values = l_values,
-                                     .joypadAxisInputs = {{.sign = -1, .index = static_cast<size_t>(m_pimpl->axes_settings.left_right_joypad_axis_index)}},
+                                     .joypadAxisInputs = {{.sign = -1, .index = m_pimpl->axes_settings.left_right_joypad_axis_index}},
                                      .col = 0},
                                     {.alias = "right", .type = ButtonType::TOGGLE, .keys = {ImGuiKey_RightArrow}, .values = r_values,
-                                     .joypadAxisInputs = {{.sign = +1, .index = static_cast<size_t>(m_pimpl->axes_settings.left_right_joypad_axis_index)}},
+                                     .joypadAxisInputs = {{.sign = +1, .index = m_pimpl->axes_settings.left_right_joypad_axis_index}},
                                      .col = 2} });
         }
         else
@@ -1312,11 +3124,57 @@ bool yarp::dev::KeyboardJoypad::open(yarp::os::Searchable& cfg)
                 m_pimpl->sticks_values.back().push_back(0);
             }
             arrows.rows.push_back({ {.alias = "bottom", .type = ButtonType::TOGGLE, .keys = {ImGuiKey_DownArrow}, .values = values,
-                                     .joypadAxisInputs = {{.sign = +1, .index = static_cast<size_t>(m_pimpl->axes_settings.up_down_joypad_axis_index)}},
+                                     .joypadAxisInputs = {{.sign = +1, .index = m_pimpl->axes_settings.up_down_joypad_axis_index}},
                                      .col = left_right} });
         }
     }
 
+    m_pimpl->compileMapping();
+    const AxesSettings& axes_settings = m_pimpl->axes_settings;
+    m_pimpl->joypad_conditioning.configure(axes_settings.radial_deadzone, axes_settings.centering_time, axes_settings.centering_window,
+                                           { {axes_settings.ad_joypad_axis_index, axes_settings.ws_joypad_axis_index},
+                                             {axes_settings.left_right_joypad_axis_index, axes_settings.up_down_joypad_axis_index} });
+    m_pimpl->axis_pipeline.configure(m_pimpl->axes_values.size(), axes_settings.expo, axes_settings.slew_rate, axes_settings.low_pass_cutoff);
+
+    // The passthrough outputs are appended after the mapped ones
+    const Settings& settings = m_pimpl->settings;
+    m_pimpl->passthrough.configure(settings.passthrough_axes, m_pimpl->axes_values.size(),
+                                   settings.passthrough_buttons, m_pimpl->buttons_values.size(), settings.passthrough_hats);
+    m_pimpl->axes_values.resize(m_pimpl->axes_values.size() + m_pimpl->passthrough.numberOfAxes(), 0.0);
+    m_pimpl->buttons_values.resize(m_pimpl->buttons_values.size() + m_pimpl->passthrough.numberOfButtons(), 0.0);
+    m_pimpl->hat_values.resize(m_pimpl->passthrough.numberOfHats(), 0);
+
+    if (m_pimpl->settings.headless)
+    {
+        yCInfo(KEYBOARDJOYPAD) << "The device is running in headless mode, using the" << m_pimpl->settings.input_backend << "input backend.";
+        m_pimpl->createHeadlessInputBackend();
+    }
+
+    m_pimpl->outputs_snapshot.resize(m_pimpl->axes_values.size(), m_pimpl->buttons_values.size(), m_pimpl->hat_values.size(),
+                                     m_pimpl->sticks_values);
+    m_pimpl->previous_axes_values = m_pimpl->axes_values;
+    m_pimpl->previous_buttons_values = m_pimpl->buttons_values;
+    m_pimpl->previous_hat_values = m_pimpl->hat_values;
+    m_pimpl->previous_sticks_values = m_pimpl->sticks_values;
+    m_pimpl->changed_axes.reserve(m_pimpl->axes_values.size());
+    m_pimpl->changed_buttons.reserve(m_pimpl->buttons_values.size());
+    m_pimpl->changed_hats.reserve(m_pimpl->hat_values.size());
+    m_pimpl->changed_sticks.reserve(m_pimpl->sticks_values.size());
+    m_pimpl->changed_axes_positions.assign(m_pimpl->axes_values.size(), Impl::noPendingChange);
+    m_pimpl->changed_buttons_positions.assign(m_pimpl->buttons_values.size(), Impl::noPendingChange);
+    m_pimpl->changed_hats_positions.assign(m_pimpl->hat_values.size(), Impl::noPendingChange);
+    m_pimpl->changed_sticks_positions.assign(m_pimpl->sticks_values.size(), Impl::noPendingChange);
+    for (const auto& stick : m_pimpl->sticks_values)
+    {
+        m_pimpl->stick_event_buffers.emplace_back(stick.size());
+    }
+
+    if (!m_pimpl->openOutputs())
+    {
+        m_pimpl->closeOutputs();
+        return false;
+    }
+
     if (m_pimpl->settings.single_threaded)
     {
         yCInfo(KEYBOARDJOYPAD) << "The device is running in single threaded mode.";
@@ -1324,11 +3182,10 @@ bool yarp::dev::KeyboardJoypad::open(yarp::os::Searchable& cfg)
     else
     {
         yCInfo(KEYBOARDJOYPAD) << "The device is running in multi threaded mode.";
-        this->setPeriod(m_pimpl->settings.gui_period);
 
-        // Start the thread
-        if (!this->start()) {
-            yCError(KEYBOARDJOYPAD) << "Thread start failed, aborting.";
+        // The GUI thread is shared with the other devices of the process running in multi threaded mode
+        if (!GuiRuntime::addClient(m_pimpl.get(), m_pimpl->settings.input_period)) {
+            yCError(KEYBOARDJOYPAD) << "Initialization in the GUI thread failed, aborting.";
             this->close();
             return false;
         }
@@ -1340,76 +3197,17 @@ bool yarp::dev::KeyboardJoypad::open(yarp::os::Searchable& cfg)
 bool yarp::dev::KeyboardJoypad::close()
 {
     yCInfo(KEYBOARDJOYPAD) << "Closing the device";
-    this->askToStop();
     if (m_pimpl->settings.single_threaded)
     {
         m_pimpl->close();
     }
-    return true;
-}
-
-bool yarp::dev::KeyboardJoypad::threadInit()
-{
-    if (m_pimpl->closed || m_pimpl->settings.single_threaded)
-    {
-        return false;
-    }
-
-    std::lock_guard<std::mutex> lock(m_pimpl->mutex);
-
-    return m_pimpl->initialize();
-}
-
-void yarp::dev::KeyboardJoypad::threadRelease()
-{
-    if (m_pimpl->closed || m_pimpl->settings.single_threaded)
-    {
-        return;
-    }
-
-    std::lock_guard<std::mutex> lock(m_pimpl->mutex);
-
-    m_pimpl->close();
-}
-
-void yarp::dev::KeyboardJoypad::run()
-{
-    if (m_pimpl->closed || m_pimpl->settings.single_threaded)
-    {
-        return;
-    }
-    {
-        std::lock_guard<std::mutex> lock(m_pimpl->mutex);
-        if (m_pimpl->settings.allow_window_closing)
-        {
-            m_pimpl->need_to_close = glfwWindowShouldClose(m_pimpl->window);
-        }
-    }
-    double period = 0;
-    double desired_period = 0;
-
-    if (!m_pimpl->need_to_close)
-    {
-        std::lock_guard<std::mutex> lock(m_pimpl->mutex);
-
-        m_pimpl->update();
-
-        desired_period = getPeriod();
-        period = getEstimatedUsed();
-
-    }
     else
     {
-        this->close();
-    }
-
-    if (period > desired_period)
-    {
-        yCWarningThrottle(KEYBOARDJOYPAD, 5.0, "The period of the GUI is higher than the period of the thread. The GUI will be updated at a lower rate.");
-        yarp::os::Time::delay(1e-3); //Sleep for 1 ms to avoid the other threads to go to starvation
+        GuiRuntime::removeClient(m_pimpl.get());
     }
-
-
+    // The GUI thread does not close a device that failed to join it
+    m_pimpl->closeOutputs();
+    return true;
 }
 
 bool yarp::dev::KeyboardJoypad::startService()
@@ -1423,7 +3221,7 @@ bool yarp::dev::KeyboardJoypad::updateService()
     //To let the device driver that we are still alive
     if (m_pimpl->settings.single_threaded && !m_pimpl->closed)
     {
-        std::lock_guard<std::mutex> lock(m_pimpl->mutex);
+        auto lock = m_pimpl->lockMutex();
         if (!m_pimpl->initialized)
         {
             if (!m_pimpl->initialize())
@@ -1433,6 +3231,7 @@ bool yarp::dev::KeyboardJoypad::updateService()
         }
         m_pimpl->update();
     }
+    m_pimpl->dispatchEvents();
     return !m_pimpl->closed;
 }
 
@@ -1444,15 +3243,13 @@ bool yarp::dev::KeyboardJoypad::stopService()
 
 bool yarp::dev::KeyboardJoypad::getAxisCount(unsigned int& axis_count)
 {
-    std::lock_guard<std::mutex> lock(m_pimpl->mutex);
-    axis_count = static_cast<unsigned int>(m_pimpl->axes_values.size());
+    axis_count = static_cast<unsigned int>(m_pimpl->outputs_snapshot.numberOfAxes());
     return true;
 }
 
 bool yarp::dev::KeyboardJoypad::getButtonCount(unsigned int& button_count)
 {
-    std::lock_guard<std::mutex> lock(m_pimpl->mutex);
-    button_count = static_cast<unsigned int>(m_pimpl->buttons_values.size());
+    button_count = static_cast<unsigned int>(m_pimpl->outputs_snapshot.numberOfButtons());
     return true;
 }
 
@@ -1464,7 +3261,7 @@ bool yarp::dev::KeyboardJoypad::getTrackballCount(unsigned int& trackball_count)
 
 bool yarp::dev::KeyboardJoypad::getHatCount(unsigned int& hat_count)
 {
-    hat_count = 0;
+    hat_count = static_cast<unsigned int>(m_pimpl->outputs_snapshot.numberOfHats());
     return true;
 }
 
@@ -1476,45 +3273,35 @@ bool yarp::dev::KeyboardJoypad::getTouchSurfaceCount(unsigned int& touch_count)
 
 bool yarp::dev::KeyboardJoypad::getStickCount(unsigned int& stick_count)
 {
-    std::lock_guard<std::mutex> lock(m_pimpl->mutex);
-    stick_count = static_cast<unsigned int>(m_pimpl->sticks_to_axes.size());
+    stick_count = static_cast<unsigned int>(m_pimpl->outputs_snapshot.numberOfSticks());
     return true;
 }
 
 bool yarp::dev::KeyboardJoypad::getStickDoF(unsigned int stick_id, unsigned int& dof)
 {
-    std::lock_guard<std::mutex> lock(m_pimpl->mutex);
-    if (stick_id >= m_pimpl->sticks_to_axes.size())
+    if (stick_id >= m_pimpl->outputs_snapshot.numberOfSticks())
     {
         yCError(KEYBOARDJOYPAD) << "The stick with id" << stick_id << "does not exist.";
         return false;
     }
 
-    dof = static_cast<unsigned int>(m_pimpl->sticks_to_axes[stick_id].size());
+    dof = static_cast<unsigned int>(m_pimpl->outputs_snapshot.stickDoF(stick_id));
 
     return true;
 }
 
 bool yarp::dev::KeyboardJoypad::getButton(unsigned int button_id, float& value)
 {
-    std::lock_guard<std::mutex> lock(m_pimpl->mutex);
-    if (!m_pimpl->initialized)
-    {
-        if (!m_pimpl->initialize())
-        {
-            return false;
-        }
-    }
-    if (m_pimpl->settings.single_threaded && m_pimpl->needUpdate())
+    if (!m_pimpl->updateIfSingleThreaded())
     {
-        m_pimpl->update();
+        return false;
     }
-    if (button_id >= m_pimpl->buttons_values.size())
+    if (button_id >= m_pimpl->outputs_snapshot.numberOfButtons())
     {
         yCError(KEYBOARDJOYPAD) << "The button with id" << button_id << "does not exist.";
         return false;
     }
-    value = static_cast<float>(m_pimpl->buttons_values[button_id]);
+    value = static_cast<float>(m_pimpl->outputs_snapshot.button(button_id));
     return true;
 }
 
@@ -1524,61 +3311,49 @@ bool yarp::dev::KeyboardJoypad::getTrackball(unsigned int /*trackball_id*/, yarp
     return false;
 }
 
-bool yarp::dev::KeyboardJoypad::getHat(unsigned int /*hat_id*/, unsigned char& /*value*/)
+bool yarp::dev::KeyboardJoypad::getHat(unsigned int hat_id, unsigned char& value)
 {
-    yCError(KEYBOARDJOYPAD) << "This device does not consider hats.";
-    return false;
+    if (!m_pimpl->updateIfSingleThreaded())
+    {
+        return false;
+    }
+    if (hat_id >= m_pimpl->outputs_snapshot.numberOfHats())
+    {
+        yCError(KEYBOARDJOYPAD) << "The hat with id" << hat_id << "does not exist.";
+        return false;
+    }
+    value = m_pimpl->outputs_snapshot.hat(hat_id);
+    return true;
 }
 
 bool yarp::dev::KeyboardJoypad::getAxis(unsigned int axis_id, double& value)
 {
-    std::lock_guard<std::mutex> lock(m_pimpl->mutex);
-    if (!m_pimpl->initialized)
+    if (!m_pimpl->updateIfSingleThreaded())
     {
-        if (!m_pimpl->initialize())
-        {
-            return false;
-        }
-    }
-    if (m_pimpl->settings.single_threaded && m_pimpl->needUpdate())
-    {
-        m_pimpl->update();
+        return false;
     }
-    if (axis_id >= m_pimpl->axes_values.size())
+    if (axis_id >= m_pimpl->outputs_snapshot.numberOfAxes())
     {
         yCError(KEYBOARDJOYPAD) << "The axis with id" << axis_id << "does not exist.";
         return false;
     }
-    value = m_pimpl->axes_values[axis_id];
+    value = m_pimpl->outputs_snapshot.axis(axis_id);
     return true;
 }
 
 bool yarp::dev::KeyboardJoypad::getStick(unsigned int stick_id, yarp::sig::Vector& value, JoypadCtrl_coordinateMode coordinate_mode)
 {
-    std::lock_guard<std::mutex> lock(m_pimpl->mutex);
-    if (!m_pimpl->initialized)
-    {
-        if (!m_pimpl->initialize())
-        {
-            return false;
-        }
-    }
-    if (m_pimpl->settings.single_threaded && m_pimpl->needUpdate())
+    if (!m_pimpl->updateIfSingleThreaded())
     {
-        m_pimpl->update();
+        return false;
     }
-    if (stick_id >= m_pimpl->sticks_values.size())
+    if (stick_id >= m_pimpl->outputs_snapshot.numberOfSticks())
     {
         yCError(KEYBOARDJOYPAD) << "The stick with id" << stick_id << "does not exist.";
         return false;
     }
 
-    value.resize(m_pimpl->sticks_values[stick_id].size());
-
-    for (size_t i = 0; i < value.size(); i++)
-    {
-        value[i] = m_pimpl->sticks_values[stick_id][i];
-    }
+    m_pimpl->outputs_snapshot.stick(stick_id, value);
 
     if (value.size() != 2)
     {
@@ -1601,3 +3376,68 @@ bool yarp::dev::KeyboardJoypad::getTouch(unsigned int /*touch_id*/, yarp::sig::V
     yCError(KEYBOARDJOYPAD) << "This device does not consider touch surfaces.";
     return false;
 }
+
+yarp::os::Stamp yarp::dev::KeyboardJoypad::getLastInputStamp()
+{
+    // Not triggering a sample in single threaded mode, the stamp refers to the outputs returned by the last getters
+    return m_pimpl->outputs_snapshot.stamp();
+}
+
+bool yarp::dev::KeyboardJoypad::setKey(const std::string& key, bool pressed)
+{
+    std::string key_name = key;
+    std::transform(key_name.begin(), key_name.end(), key_name.begin(), ::toupper);
+
+    std::vector<ImGuiKey> keys;
+    if (!parseKeyName(key_name, keys))
+    {
+        yCError(KEYBOARDJOYPAD) << "The key" << key << "is not supported.";
+        return false;
+    }
+
+    if (!m_pimpl->keyboard.setKeyDown(keys.front(), pressed))
+    {
+        yCError(KEYBOARDJOYPAD) << "The queue of the key events is full, the key" << key << "has been dropped.";
+        return false;
+    }
+    return true;
+}
+
+bool yarp::dev::KeyboardJoypad::setJoypadAxis(unsigned int axis_id, float value)
+{
+    if (!m_pimpl->programmatic_backend)
+    {
+        yCError(KEYBOARDJOYPAD) << "The joypad axes can be set only when using the \"programmatic\" input backend.";
+        return false;
+    }
+    return m_pimpl->programmatic_backend->setAxis(axis_id, value);
+}
+
+bool yarp::dev::KeyboardJoypad::setJoypadButton(unsigned int button_id, bool pressed)
+{
+    if (!m_pimpl->programmatic_backend)
+    {
+        yCError(KEYBOARDJOYPAD) << "The joypad buttons can be set only when using the \"programmatic\" input backend.";
+        return false;
+    }
+    return m_pimpl->programmatic_backend->setButton(button_id, pressed);
+}
+
+bool yarp::dev::KeyboardJoypad::eventDriven(bool enable, yarp::dev::IJoypadEvent* event)
+{
+    if (enable && !event)
+    {
+        yCError(KEYBOARDJOYPAD) << "The event cannot be null when enabling the events.";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_pimpl->event_mutex);
+    m_pimpl->event = enable ? event : nullptr;
+    m_pimpl->event_driven = enable;
+    return true;
+}
+
+bool yarp::dev::KeyboardJoypad::isEventDriven()
+{
+    return m_pimpl->event_driven;
+}
@@ -13,19 +13,26 @@
 
 #include <yarp/dev/DeviceDriver.h>
 #include <yarp/dev/IJoypadController.h>
-#include <yarp/os/PeriodicThread.h>
+#include <yarp/dev/IPreciselyTimed.h>
 #include <yarp/dev/ServiceInterfaces.h>
 
+#include <IKeyboardJoypadEventDriven.h>
+#include <IKeyboardJoypadInput.h>
+
 namespace yarp {
     namespace dev {
         class KeyboardJoypad;
     }
 }
 
+class KeyboardJoypadBenchmarks;
+
 class yarp::dev::KeyboardJoypad : public yarp::dev::DeviceDriver,
-    public yarp::os::PeriodicThread,
     public yarp::dev::IService,
-    public yarp::dev::IJoypadController
+    public yarp::dev::IJoypadController,
+    public yarp::dev::IPreciselyTimed,
+    public yarp::dev::IKeyboardJoypadInput,
+    public yarp::dev::IKeyboardJoypadEventDriven
 {
 public:
     KeyboardJoypad();
@@ -36,12 +43,7 @@ public:
     virtual bool open(yarp::os::Searchable& cfg) override;
     virtual bool close() override;
 
-    // yarp::os::RateThread methods
-    virtual bool threadInit() override;
-    virtual void threadRelease() override;
-    virtual void run() override;
-
-    //  yarp::dev::IService methods
+    // yarp::dev::IService methods
     virtual bool startService() override;
     virtual bool updateService() override;
     virtual bool stopService() override;
@@ -61,10 +63,24 @@ public:
     virtual bool getStick(unsigned int stick_id, yarp::sig::Vector& value, JoypadCtrl_coordinateMode coordinate_mode) override;
     virtual bool getTouch(unsigned int touch_id, yarp::sig::Vector& value) override;
 
+    // yarp::dev::IPreciselyTimed methods
+    virtual yarp::os::Stamp getLastInputStamp() override;
+
+    // yarp::dev::IKeyboardJoypadInput methods
+    virtual bool setKey(const std::string& key, bool pressed) override;
+    virtual bool setJoypadAxis(unsigned int axis_id, float value) override;
+    virtual bool setJoypadButton(unsigned int button_id, bool pressed) override;
+
+    // yarp::dev::IKeyboardJoypadEventDriven methods
+    virtual bool eventDriven(bool enable, yarp::dev::IJoypadEvent* event = nullptr) override;
+    virtual bool isEventDriven() override;
+
 private:
 
     class Impl;
     std::unique_ptr<Impl> m_pimpl;
+
+    friend class ::KeyboardJoypadBenchmarks; //The benchmarks exercise the internals directly
 };
 
 
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+#include <KeyboardJoypadAxisPipeline.h>
+
+// Per axis deadzone, symmetric with respect to the center
+static float axisDeadzone(float value, float deadzone)
+{
+    float magnitude = std::abs(value);
+    if (magnitude <= deadzone)
+    {
+        return 0.0f;
+    }
+    return std::copysign((magnitude - deadzone) / (1.0f - deadzone), value);
+}
+
+void JoypadAxesConditioning::configure(bool radial_deadzone, double centering_time, float centering_window, const std::vector<std::pair<int, int>>& sticks)
+{
+    m_radial_deadzone = radial_deadzone;
+    m_centering_time = centering_time;
+    m_centering_window = centering_window;
+    m_sticks.clear();
+    for (const auto& stick : sticks)
+    {
+        if (stick.first >= 0 && stick.second >= 0 && stick.first != stick.second)
+        {
+            m_sticks.push_back(stick);
+        }
+    }
+    m_centers.clear();
+    m_in_stick.clear();
+    m_last_timestamp = -1.0;
+}
+
+bool JoypadAxesConditioning::enabled() const
+{
+    return m_radial_deadzone || m_centering_time > 0;
+}
+
+void JoypadAxesConditioning::apply(const std::vector<float>& joypad_axis_values, float deadzone, double timestamp, std::vector<float>& output)
+{
+    const size_t number_of_axes = joypad_axis_values.size();
+    if (m_centers.size() != number_of_axes)
+    {
+        // A joypad has been connected or disconnected, the calibration restarts
+        m_centers.assign(number_of_axes, 0.0f);
+        m_in_stick.assign(number_of_axes, false);
+        for (const auto& [x, y] : m_sticks)
+        {
+            if (m_radial_deadzone && static_cast<size_t>(x) < number_of_axes && static_cast<size_t>(y) < number_of_axes)
+            {
+                m_in_stick[static_cast<size_t>(x)] = true;
+                m_in_stick[static_cast<size_t>(y)] = true;
+            }
+        }
+    }
+    if (output.size() != number_of_axes)
+    {
+        output.resize(number_of_axes);
+    }
+
+    double dt = m_last_timestamp < 0 ? 0.0 : std::max(timestamp - m_last_timestamp, 0.0);
+    m_last_timestamp = timestamp;
+    float centering_gain = m_centering_time > 0 ? static_cast<float>(dt / (m_centering_time + dt)) : 0.0f;
+
+    for (size_t i = 0; i < number_of_axes; ++i)
+    {
+        float offset = joypad_axis_values[i] - m_centers[i];
+        // The rest position is tracked only while the axis is within the centering window, i.e. not moved by the user
+        m_centers[i] += std::abs(offset) < m_centering_window ? centering_gain * offset : 0.0f;
+        float centered = std::clamp(joypad_axis_values[i] - m_centers[i], -1.0f, 1.0f);
+        output[i] = m_in_stick[i] ? centered : axisDeadzone(centered, deadzone);
+    }
+
+    if (!m_radial_deadzone)
+    {
+        return;
+    }
+
+    for (const auto& [x_index, y_index] : m_sticks)
+    {
+        size_t x = static_cast<size_t>(x_index);
+        size_t y = static_cast<size_t>(y_index);
+        if (x >= number_of_axes || y >= number_of_axes)
+        {
+            continue;
+        }
+        float radius = std::hypot(output[x], output[y]);
+        float scale = radius > deadzone && deadzone < 1.0f ? (radius - deadzone) / ((1.0f - deadzone) * radius) : 0.0f;
+        output[x] = std::clamp(output[x] * scale, -1.0f, 1.0f);
+        output[y] = std::clamp(output[y] * scale, -1.0f, 1.0f);
+    }
+}
+
+void AxisPipeline::configure(size_t number_of_axes, const std::vector<float>& expo,
+                             const std::vector<float>& slew_rate, const std::vector<float>& low_pass_cutoff)
+{
+    m_expo.assign(number_of_axes, 0.0);
+    m_max_rate.assign(number_of_axes, std::numeric_limits<double>::infinity());
+    m_time_constant.assign(number_of_axes, 0.0);
+    m_state.assign(number_of_axes, 0.0);
+    m_last_timestamp = -1.0;
+    m_enabled = false;
+
+    for (size_t i = 0; i < number_of_axes; ++i)
+    {
+        if (i < expo.size() && expo[i] > 0)
+        {
+            m_expo[i] = expo[i];
+            m_enabled = true;
+        }
+        if (i < slew_rate.size() && slew_rate[i] > 0)
+        {
+            m_max_rate[i] = slew_rate[i];
+            m_enabled = true;
+        }
+        if (i < low_pass_cutoff.size() && low_pass_cutoff[i] > 0)
+        {
+            m_time_constant[i] = 1.0 / (2.0 * std::numbers::pi * low_pass_cutoff[i]);
+            m_enabled = true;
+        }
+    }
+}
+
+bool AxisPipeline::enabled() const
+{
+    return m_enabled;
+}
+
+void AxisPipeline::apply(std::vector<double>& axes_values, double timestamp)
+{
+    double dt = m_last_timestamp < 0 ? 0.0 : std::max(timestamp - m_last_timestamp, 0.0);
+    m_last_timestamp = timestamp;
+
+    // Below this difference, the filtered value is snapped to the target, to avoid an endless tail of tiny changes
+    constexpr double snap_threshold = 1e-6;
+
+    const size_t number_of_axes = std::min(axes_values.size(), m_state.size());
+    for (size_t i = 0; i < number_of_axes; ++i)
+    {
+        double x = axes_values[i];
+        double shaped = (1.0 - m_expo[i]) * x + m_expo[i] * x * x * x;
+
+        double max_step = std::isinf(m_max_rate[i]) ? m_max_rate[i] : m_max_rate[i] * dt; //Avoids infinity * 0
+        double limited = m_state[i] + std::clamp(shaped - m_state[i], -max_step, max_step);
+
+        double alpha = m_time_constant[i] > 0 ? dt / (m_time_constant[i] + dt) : 1.0;
+        double filtered = m_state[i] + alpha * (limited - m_state[i]);
+        filtered = std::abs(filtered - shaped) < snap_threshold ? shaped : filtered;
+
+        m_state[i] = std::clamp(filtered, -1.0, 1.0);
+        axes_values[i] = m_state[i];
+    }
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_KEYBOARDJOYPADAXISPIPELINE_H
+#define YARP_DEV_KEYBOARDJOYPADAXISPIPELINE_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * Conditioning of the raw joypad axes, applied before the mapping:
+ * - auto-centering: the rest position of each axis is tracked while the axis is within the centering window, and removed;
+ * - deadzone: radial for the pairs of axes of a stick, so that the diagonals are not cut, per axis for the others.
+ * When enabled, the deadzone is applied here, and the mapping has to use a zero deadzone.
+ */
+class JoypadAxesConditioning
+{
+    bool m_radial_deadzone{ false };
+    double m_centering_time{ 0.0 };
+    float m_centering_window{ 0.0f };
+    std::vector<std::pair<int, int>> m_sticks;
+    std::vector<float> m_centers;
+    std::vector<unsigned char> m_in_stick; //Whether the axis is part of a stick, hence of a radial deadzone
+    double m_last_timestamp{ -1.0 };
+
+public:
+    // The sticks are pairs of joypad axis indices, negative indices are ignored. A centering time of 0 disables the centering.
+    // The centering window is independent of the deadzone, so that the centering works also without a deadzone.
+    void configure(bool radial_deadzone, double centering_time, float centering_window, const std::vector<std::pair<int, int>>& sticks);
+
+    bool enabled() const;
+
+    // Writes the conditioned values in output, resized only if the number of joypad axes changed
+    void apply(const std::vector<float>& joypad_axis_values, float deadzone, double timestamp, std::vector<float>& output);
+};
+
+/**
+ * Shaping of the output axes, applied after the mapping at every input sample:
+ * - expo response curve, (1 - e) * x + e * x^3;
+ * - slew-rate limiting, in units per second, so that the steps of the keys become ramps;
+ * - first-order low-pass filter, with the cutoff frequency in Hz.
+ * All the stages are evaluated in a single branch-free pass over the axes. A parameter equal to 0 disables its stage.
+ */
+class AxisPipeline
+{
+    std::vector<double> m_expo;
+    std::vector<double> m_max_rate; //Infinity when the slew-rate limiting is disabled
+    std::vector<double> m_time_constant; //Zero when the low-pass filter is disabled
+    std::vector<double> m_state;
+    double m_last_timestamp{ -1.0 };
+    bool m_enabled{ false };
+
+public:
+    void configure(size_t number_of_axes, const std::vector<float>& expo,
+                   const std::vector<float>& slew_rate, const std::vector<float>& low_pass_cutoff);
+
+    bool enabled() const;
+
+    // Filters the axes values in place. The timestamp is in seconds.
+    void apply(std::vector<double>& axes_values, double timestamp);
+};
+
+#endif // YARP_DEV_KEYBOARDJOYPADAXISPIPELINE_H
@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <yarp/os/LogStream.h>
+#include <yarp/os/PeriodicThread.h>
+#include <yarp/os/Time.h>
+
+#include <KeyboardJoypadGuiRuntime.h>
+#include <KeyboardJoypadLogComponent.h>
+
+static std::mutex glfwUsersMutex;
+static size_t glfwUsers = 0;
+static bool glfwOffscreen = false;
+
+static void glfwErrorCallback(int error, const char* description)
+{
+    yCError(KEYBOARDJOYPAD, "GLFW error %d: %s", error, description);
+}
+
+bool GuiRuntime::acquireGlfw(bool offscreen)
+{
+    std::lock_guard<std::mutex> lock(glfwUsersMutex);
+    if (glfwUsers == 0)
+    {
+        glfwSetErrorCallback(&glfwErrorCallback);
+#ifdef GLFW_PLATFORM_NULL
+        glfwInitHint(GLFW_PLATFORM, offscreen ? GLFW_PLATFORM_NULL : GLFW_ANY_PLATFORM);
+#else
+        if (offscreen)
+        {
+            yCError(KEYBOARDJOYPAD, "The offscreen rendering requires GLFW 3.4 or newer");
+            return false;
+        }
+#endif
+        if (!glfwInit())
+        {
+            yCError(KEYBOARDJOYPAD, "Unable to initialize GLFW");
+            return false;
+        }
+        glfwOffscreen = offscreen;
+    }
+    else if (offscreen != glfwOffscreen)
+    {
+        yCError(KEYBOARDJOYPAD, "GLFW is already initialized %s. All the devices in the process have to use the same value of \"offscreen\"",
+                glfwOffscreen ? "for the offscreen rendering" : "with a display");
+        return false;
+    }
+    glfwUsers++;
+    return true;
+}
+
+void GuiRuntime::releaseGlfw()
+{
+    std::lock_guard<std::mutex> lock(glfwUsersMutex);
+    if (glfwUsers == 0)
+    {
+        return;
+    }
+    glfwUsers--;
+    if (glfwUsers == 0)
+    {
+        glfwTerminate();
+    }
+}
+
+class GuiLoop : public yarp::os::PeriodicThread
+{
+    struct Request
+    {
+        GuiRuntimeClient* client;
+        double period;
+        bool add;
+        bool done{ false };
+        bool result{ false };
+        size_t number_of_clients{ 0 }; //After processing the request
+    };
+
+    struct Entry
+    {
+        GuiRuntimeClient* client;
+        double period;
+        double next_run;
+        bool removed;
+    };
+
+    std::mutex m_lifecycle_mutex; //Serializes the starts and the stops of the thread
+    std::mutex m_requests_mutex;
+    std::condition_variable m_request_done;
+    std::vector<Request*> m_requests; //Owned by the callers waiting for them
+    std::vector<Request*> m_requests_buffer; //Swapped with m_requests to process them without holding the mutex
+    std::vector<Entry> m_clients; //Accessed only by the loop thread
+    std::atomic<std::thread::id> m_thread_id;
+
+    bool onLoopThread() const
+    {
+        return m_thread_id.load() == std::this_thread::get_id();
+    }
+
+    void process(Request& request)
+    {
+        auto entry = std::find_if(m_clients.begin(), m_clients.end(),
+                                  [&request](const Entry& e) { return e.client == request.client && !e.removed; });
+        if (request.add)
+        {
+            request.result = entry == m_clients.end() && request.client->guiThreadInit();
+            if (request.result)
+            {
+                m_clients.push_back({ request.client, request.period, yarp::os::Time::now(), false });
+            }
+        }
+        else if (entry != m_clients.end())
+        {
+            entry->removed = true;
+            entry->client->guiThreadRelease();
+        }
+        // Counted before the request is marked as done, since the caller stops the thread when no client is left
+        request.number_of_clients = static_cast<size_t>(std::count_if(m_clients.begin(), m_clients.end(),
+                                                                      [](const Entry& e) { return !e.removed; }));
+    }
+
+    // Processes the request on the loop thread, waiting for it if called from another thread
+    void submit(Request& request)
+    {
+        if (onLoopThread())
+        {
+            process(request);
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_requests_mutex);
+        m_requests.push_back(&request);
+        m_request_done.wait(lock, [&request]() { return request.done; });
+    }
+
+    void processRequests()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_requests_mutex);
+            m_requests_buffer.swap(m_requests);
+        }
+        if (m_requests_buffer.empty())
+        {
+            return;
+        }
+        for (Request* request : m_requests_buffer)
+        {
+            process(*request);
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_requests_mutex);
+            for (Request* request : m_requests_buffer)
+            {
+                request->done = true;
+            }
+            m_requests_buffer.clear();
+        }
+        m_request_done.notify_all();
+    }
+
+    void eraseRemovedClients()
+    {
+        m_clients.erase(std::remove_if(m_clients.begin(), m_clients.end(), [](const Entry& e) { return e.removed; }),
+                        m_clients.end());
+
+        double period = std::numeric_limits<double>::infinity();
+        for (const Entry& entry : m_clients)
+        {
+            period = std::min(period, entry.period);
+        }
+        if (!m_clients.empty() && period != this->getPeriod())
+        {
+            this->setPeriod(period);
+        }
+    }
+
+public:
+    GuiLoop()
+        : yarp::os::PeriodicThread(0.033, yarp::os::ShouldUseSystemClock::Yes)
+    {
+    }
+
+    ~GuiLoop() override
+    {
+        this->stop();
+    }
+
+    bool addClient(GuiRuntimeClient* client, double period)
+    {
+        Request request{ client, period, true };
+        if (onLoopThread())
+        {
+            process(request);
+            return request.result;
+        }
+
+        std::lock_guard<std::mutex> lock(m_lifecycle_mutex);
+        if (!this->isRunning())
+        {
+            this->setPeriod(period);
+            if (!this->start())
+            {
+                yCError(KEYBOARDJOYPAD) << "Failed to start the GUI thread.";
+                return false;
+            }
+        }
+        submit(request);
+        if (request.number_of_clients == 0)
+        {
+            this->stop();
+        }
+        return request.result;
+    }
+
+    void removeClient(GuiRuntimeClient* client)
+    {
+        Request request{ client, 0.0, false };
+        if (onLoopThread())
+        {
+            process(request);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_lifecycle_mutex);
+        if (!this->isRunning())
+        {
+            return;
+        }
+        submit(request);
+        if (request.number_of_clients == 0)
+        {
+            this->stop();
+        }
+    }
+
+    bool threadInit() override
+    {
+        m_thread_id = std::this_thread::get_id();
+        return true;
+    }
+
+    void run() override
+    {
+        processRequests();
+        eraseRemovedClients();
+
+        // Half loop period of tolerance, to avoid skipping a run of the slower clients because of the jitter
+        double now = yarp::os::Time::now();
+        double tolerance = 0.5 * this->getPeriod();
+        for (size_t i = 0; i < m_clients.size(); ++i)
+        {
+            if (m_clients[i].removed || now < m_clients[i].next_run - tolerance)
+            {
+                continue;
+            }
+            m_clients[i].next_run = std::max(m_clients[i].next_run + m_clients[i].period, now);
+            // The client can remove itself, or add another client, from within its run
+            if (!m_clients[i].client->guiThreadRun() && !m_clients[i].removed)
+            {
+                m_clients[i].removed = true;
+                m_clients[i].client->guiThreadRelease();
+            }
+        }
+        eraseRemovedClients();
+
+        if (this->getEstimatedUsed() > this->getPeriod())
+        {
+            yCWarningThrottle(KEYBOARDJOYPAD, 5.0, "The period of the GUI is higher than the period of the thread. The GUI will be updated at a lower rate.");
+            yarp::os::Time::delay(1e-3); //Sleep for 1 ms to avoid the other threads to go to starvation
+        }
+    }
+
+    void threadRelease() override
+    {
+        // Requests submitted while stopping are answered, releasing the remaining clients
+        processRequests();
+        for (Entry& entry : m_clients)
+        {
+            if (!entry.removed)
+            {
+                entry.removed = true;
+                entry.client->guiThreadRelease();
+            }
+        }
+        m_clients.clear();
+        m_thread_id = std::thread::id();
+    }
+};
+
+static GuiLoop& guiLoop()
+{
+    static GuiLoop loop;
+    return loop;
+}
+
+bool GuiRuntime::addClient(GuiRuntimeClient* client, double period)
+{
+    return guiLoop().addClient(client, period);
+}
+
+void GuiRuntime::removeClient(GuiRuntimeClient* client)
+{
+    guiLoop().removeClient(client);
+}
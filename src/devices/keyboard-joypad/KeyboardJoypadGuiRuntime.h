@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_KEYBOARDJOYPADGUIRUNTIME_H
+#define YARP_DEV_KEYBOARDJOYPADGUIRUNTIME_H
+
+/**
+ * A device driven by the shared GUI thread. All the methods are called on that thread.
+ */
+class GuiRuntimeClient
+{
+public:
+    virtual ~GuiRuntimeClient() = default;
+
+    // Called when the client is added. If it returns false, the client is not added.
+    virtual bool guiThreadInit() = 0;
+
+    // Called with the period of the client. If it returns false, the client is released and removed.
+    virtual bool guiThreadRun() = 0;
+
+    // Called when the client is removed.
+    virtual void guiThreadRelease() = 0;
+};
+
+/**
+ * GLFW state shared by all the devices in the process.
+ *
+ * GLFW is process-global: it is initialized by the first device needing it and terminated by the last one.
+ * Moreover, its windows and events have to be handled by a single thread. Hence, all the devices running
+ * their own GUI loop are driven by a single shared thread, started with the first client and stopped when
+ * the last one is removed. Each client has its own window, OpenGL context and ImGui context.
+ */
+class GuiRuntime
+{
+public:
+    // Reference counted glfwInit and glfwTerminate. With offscreen, GLFW is initialized with its null platform,
+    // that needs no display. The platform is chosen by the first user, and cannot change until the last one releases it.
+    static bool acquireGlfw(bool offscreen = false);
+    static void releaseGlfw();
+
+    // Adds a client to the shared thread, waiting for its guiThreadInit to be called, and returning its result
+    static bool addClient(GuiRuntimeClient* client, double period);
+
+    // Removes a client, waiting for its guiThreadRelease to be called if it was not removed already.
+    // It can be called also from the shared thread, e.g. from a callback.
+    static void removeClient(GuiRuntimeClient* client);
+};
+
+#endif // YARP_DEV_KEYBOARDJOYPADGUIRUNTIME_H
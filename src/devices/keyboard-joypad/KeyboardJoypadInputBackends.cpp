@@ -0,0 +1,627 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#include <GLFW/glfw3.h>
+#include <imgui_impl_glfw.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/joystick.h>
+#include <cerrno>
+#endif
+
+#include <yarp/os/LogStream.h>
+
+#include <KeyboardJoypadGuiRuntime.h>
+#include <KeyboardJoypadInputBackends.h>
+#include <KeyboardJoypadLogComponent.h>
+#include <KeyboardJoypadTrace.h>
+
+// Backends notified by the GLFW joystick callback
+static std::mutex joystickListenersMutex;
+static std::vector<GlfwInputBackend*> joystickListeners;
+
+GlfwInputBackend::GlfwInputBackend(GLFWwindow* window)
+    : m_window(window)
+{
+}
+
+void GlfwInputBackend::setImGuiContext(ImGuiContext* context)
+{
+    m_imgui_context = context;
+}
+
+void GlfwInputBackend::setTrace(TraceWriter* trace)
+{
+    m_trace = trace;
+}
+
+ImGuiKey GlfwInputBackend::glfwKeyToImGuiKey(int key, int scancode)
+{
+    // Same translation used by the ImGui GLFW backend, including the handling of non-QWERTY layouts
+    if (key < GLFW_KEY_KP_0 || key > GLFW_KEY_KP_EQUAL)
+    {
+        const char* key_name = glfwGetKeyName(key, scancode);
+        if (key_name && key_name[0] != 0 && key_name[1] == 0)
+        {
+            const char char_names[] = "`-=[]\\,;\'./";
+            const int char_keys[] = { GLFW_KEY_GRAVE_ACCENT, GLFW_KEY_MINUS, GLFW_KEY_EQUAL, GLFW_KEY_LEFT_BRACKET, GLFW_KEY_RIGHT_BRACKET,
+                                      GLFW_KEY_BACKSLASH, GLFW_KEY_COMMA, GLFW_KEY_SEMICOLON, GLFW_KEY_APOSTROPHE, GLFW_KEY_PERIOD, GLFW_KEY_SLASH, 0 };
+            if (key_name[0] >= '0' && key_name[0] <= '9')
+            {
+                key = GLFW_KEY_0 + (key_name[0] - '0');
+            }
+            else if (key_name[0] >= 'A' && key_name[0] <= 'Z')
+            {
+                key = GLFW_KEY_A + (key_name[0] - 'A');
+            }
+            else if (key_name[0] >= 'a' && key_name[0] <= 'z')
+            {
+                key = GLFW_KEY_A + (key_name[0] - 'a');
+            }
+            else if (const char* p = strchr(char_names, key_name[0]))
+            {
+                key = char_keys[p - char_names];
+            }
+        }
+    }
+
+    if (key >= GLFW_KEY_0 && key <= GLFW_KEY_9)
+    {
+        return static_cast<ImGuiKey>(ImGuiKey_0 + (key - GLFW_KEY_0));
+    }
+    if (key >= GLFW_KEY_A && key <= GLFW_KEY_Z)
+    {
+        return static_cast<ImGuiKey>(ImGuiKey_A + (key - GLFW_KEY_A));
+    }
+    if (key >= GLFW_KEY_F1 && key <= GLFW_KEY_F12)
+    {
+        return static_cast<ImGuiKey>(ImGuiKey_F1 + (key - GLFW_KEY_F1));
+    }
+#if IMGUI_VERSION_NUM >= 19000
+    if (key >= GLFW_KEY_F13 && key <= GLFW_KEY_F24)
+    {
+        return static_cast<ImGuiKey>(ImGuiKey_F13 + (key - GLFW_KEY_F13));
+    }
+#endif
+    if (key >= GLFW_KEY_KP_0 && key <= GLFW_KEY_KP_9)
+    {
+        return static_cast<ImGuiKey>(ImGuiKey_Keypad0 + (key - GLFW_KEY_KP_0));
+    }
+
+    switch (key)
+    {
+    case GLFW_KEY_TAB: return ImGuiKey_Tab;
+    case GLFW_KEY_LEFT: return ImGuiKey_LeftArrow;
+    case GLFW_KEY_RIGHT: return ImGuiKey_RightArrow;
+    case GLFW_KEY_UP: return ImGuiKey_UpArrow;
+    case GLFW_KEY_DOWN: return ImGuiKey_DownArrow;
+    case GLFW_KEY_PAGE_UP: return ImGuiKey_PageUp;
+    case GLFW_KEY_PAGE_DOWN: return ImGuiKey_PageDown;
+    case GLFW_KEY_HOME: return ImGuiKey_Home;
+    case GLFW_KEY_END: return ImGuiKey_End;
+    case GLFW_KEY_INSERT: return ImGuiKey_Insert;
+    case GLFW_KEY_DELETE: return ImGuiKey_Delete;
+    case GLFW_KEY_BACKSPACE: return ImGuiKey_Backspace;
+    case GLFW_KEY_SPACE: return ImGuiKey_Space;
+    case GLFW_KEY_ENTER: return ImGuiKey_Enter;
+    case GLFW_KEY_ESCAPE: return ImGuiKey_Escape;
+    case GLFW_KEY_APOSTROPHE: return ImGuiKey_Apostrophe;
+    case GLFW_KEY_COMMA: return ImGuiKey_Comma;
+    case GLFW_KEY_MINUS: return ImGuiKey_Minus;
+    case GLFW_KEY_PERIOD: return ImGuiKey_Period;
+    case GLFW_KEY_SLASH: return ImGuiKey_Slash;
+    case GLFW_KEY_SEMICOLON: return ImGuiKey_Semicolon;
+    case GLFW_KEY_EQUAL: return ImGuiKey_Equal;
+    case GLFW_KEY_LEFT_BRACKET: return ImGuiKey_LeftBracket;
+    case GLFW_KEY_BACKSLASH: return ImGuiKey_Backslash;
+    case GLFW_KEY_RIGHT_BRACKET: return ImGuiKey_RightBracket;
+    case GLFW_KEY_GRAVE_ACCENT: return ImGuiKey_GraveAccent;
+    case GLFW_KEY_CAPS_LOCK: return ImGuiKey_CapsLock;
+    case GLFW_KEY_SCROLL_LOCK: return ImGuiKey_ScrollLock;
+    case GLFW_KEY_NUM_LOCK: return ImGuiKey_NumLock;
+    case GLFW_KEY_PRINT_SCREEN: return ImGuiKey_PrintScreen;
+    case GLFW_KEY_PAUSE: return ImGuiKey_Pause;
+    case GLFW_KEY_KP_DECIMAL: return ImGuiKey_KeypadDecimal;
+    case GLFW_KEY_KP_DIVIDE: return ImGuiKey_KeypadDivide;
+    case GLFW_KEY_KP_MULTIPLY: return ImGuiKey_KeypadMultiply;
+    case GLFW_KEY_KP_SUBTRACT: return ImGuiKey_KeypadSubtract;
+    case GLFW_KEY_KP_ADD: return ImGuiKey_KeypadAdd;
+    case GLFW_KEY_KP_ENTER: return ImGuiKey_KeypadEnter;
+    case GLFW_KEY_KP_EQUAL: return ImGuiKey_KeypadEqual;
+    case GLFW_KEY_LEFT_SHIFT: return ImGuiKey_LeftShift;
+    case GLFW_KEY_LEFT_CONTROL: return ImGuiKey_LeftCtrl;
+    case GLFW_KEY_LEFT_ALT: return ImGuiKey_LeftAlt;
+    case GLFW_KEY_LEFT_SUPER: return ImGuiKey_LeftSuper;
+    case GLFW_KEY_RIGHT_SHIFT: return ImGuiKey_RightShift;
+    case GLFW_KEY_RIGHT_CONTROL: return ImGuiKey_RightCtrl;
+    case GLFW_KEY_RIGHT_ALT: return ImGuiKey_RightAlt;
+    case GLFW_KEY_RIGHT_SUPER: return ImGuiKey_RightSuper;
+    case GLFW_KEY_MENU: return ImGuiKey_Menu;
+    default: return ImGuiKey_None;
+    }
+}
+
+
+void GlfwInputBackend::markWindowEvent(GLFWwindow* window)
+{
+    GlfwInputBackend* backend = static_cast<GlfwInputBackend*>(glfwGetWindowUserPointer(window));
+    if (backend)
+    {
+        backend->m_window_events = true;
+    }
+}
+
+template <typename Callback, typename... Args>
+void GlfwInputBackend::forwardToImGui(GLFWwindow* window, Callback callback, Args... args)
+{
+    GlfwInputBackend* backend = static_cast<GlfwInputBackend*>(glfwGetWindowUserPointer(window));
+    if (!backend || !backend->m_imgui_context)
+    {
+        return;
+    }
+    ImGuiContext* current_context = ImGui::GetCurrentContext();
+    ImGui::SetCurrentContext(backend->m_imgui_context);
+    callback(window, args...);
+    ImGui::SetCurrentContext(current_context);
+}
+
+void GlfwInputBackend::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    markWindowEvent(window);
+    forwardToImGui(window, &ImGui_ImplGlfw_KeyCallback, key, scancode, action, mods);
+    GlfwInputBackend* backend = static_cast<GlfwInputBackend*>(glfwGetWindowUserPointer(window));
+    if (!backend || !backend->m_keyboard || action == GLFW_REPEAT)
+    {
+        return;
+    }
+    backend->m_keyboard->setKeyDown(glfwKeyToImGuiKey(key, scancode), action == GLFW_PRESS);
+}
+
+void GlfwInputBackend::windowFocusCallback(GLFWwindow* window, int focused)
+{
+    markWindowEvent(window);
+    forwardToImGui(window, &ImGui_ImplGlfw_WindowFocusCallback, focused);
+    GlfwInputBackend* backend = static_cast<GlfwInputBackend*>(glfwGetWindowUserPointer(window));
+    if (backend && backend->m_keyboard && !focused)
+    {
+        backend->m_keyboard->releaseAll(); //The release events are not received when the window is not focused
+    }
+}
+
+void GlfwInputBackend::windowIconifyCallback(GLFWwindow* window, int iconified)
+{
+    markWindowEvent(window);
+    GlfwInputBackend* backend = static_cast<GlfwInputBackend*>(glfwGetWindowUserPointer(window));
+    if (backend)
+    {
+        backend->m_iconified = iconified == GLFW_TRUE;
+    }
+}
+
+void GlfwInputBackend::windowRefreshCallback(GLFWwindow* window)
+{
+    markWindowEvent(window);
+}
+
+void GlfwInputBackend::framebufferSizeCallback(GLFWwindow* window, int, int)
+{
+    markWindowEvent(window);
+}
+
+void GlfwInputBackend::cursorPosCallback(GLFWwindow* window, double x, double y)
+{
+    markWindowEvent(window);
+    forwardToImGui(window, &ImGui_ImplGlfw_CursorPosCallback, x, y);
+}
+
+void GlfwInputBackend::cursorEnterCallback(GLFWwindow* window, int entered)
+{
+    markWindowEvent(window);
+    forwardToImGui(window, &ImGui_ImplGlfw_CursorEnterCallback, entered);
+}
+
+void GlfwInputBackend::mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+    markWindowEvent(window);
+    forwardToImGui(window, &ImGui_ImplGlfw_MouseButtonCallback, button, action, mods);
+    GlfwInputBackend* backend = static_cast<GlfwInputBackend*>(glfwGetWindowUserPointer(window));
+    if (!backend || !backend->m_keyboard || button < GLFW_MOUSE_BUTTON_1 || button > GLFW_MOUSE_BUTTON_5)
+    {
+        return;
+    }
+    // The mouse buttons can be mapped as keys too. The GLFW order (left, right, middle, 4, 5) is the same of ImGui.
+    backend->m_keyboard->setKeyDown(static_cast<ImGuiKey>(ImGuiKey_MouseLeft + button), action == GLFW_PRESS);
+}
+
+void GlfwInputBackend::scrollCallback(GLFWwindow* window, double x_offset, double y_offset)
+{
+    markWindowEvent(window);
+    forwardToImGui(window, &ImGui_ImplGlfw_ScrollCallback, x_offset, y_offset);
+}
+
+void GlfwInputBackend::charCallback(GLFWwindow* window, unsigned int codepoint)
+{
+    markWindowEvent(window);
+    forwardToImGui(window, &ImGui_ImplGlfw_CharCallback, codepoint);
+}
+
+bool GlfwInputBackend::isIconified() const
+{
+    return m_iconified;
+}
+
+bool GlfwInputBackend::consumeWindowEvents()
+{
+    bool events = m_window_events;
+    m_window_events = false;
+    return events;
+}
+
+void GlfwInputBackend::enumerateJoypads(std::vector<JoypadInfo>& available_joypads)
+{
+    for (int i = GLFW_JOYSTICK_1; i <= GLFW_JOYSTICK_LAST; ++i) {
+        if (glfwJoystickPresent(i)) {
+            int axes_count, button_count, hat_count;
+            glfwGetJoystickAxes(i, &axes_count);
+            glfwGetJoystickButtons(i, &button_count);
+            glfwGetJoystickHats(i, &hat_count);
+            std::string name {glfwGetJoystickName(i)};
+            const char* guid = glfwGetJoystickGUID(i);
+            available_joypads.push_back({ .name = name, .guid = guid ? guid : "", .index = i,
+                                          .axes = axes_count, .buttons = button_count, .hats = hat_count });
+            yCInfo(KEYBOARDJOYPAD) << "Joypad" << name << "is available (index" << i
+                                   << "axes =" << axes_count << "buttons = " << button_count << "hats =" << hat_count << ").";
+        }
+    }
+}
+
+void GlfwInputBackend::joystickCallback(int jid, int event)
+{
+    if (event == GLFW_CONNECTED)
+    {
+        const char* name = glfwGetJoystickName(jid);
+        yCInfo(KEYBOARDJOYPAD) << "Joypad" << (name ? name : "") << "connected (index" << jid << ").";
+    }
+    else
+    {
+        yCWarning(KEYBOARDJOYPAD) << "The joypad with index" << jid << "has been disconnected.";
+    }
+
+    std::lock_guard<std::mutex> lock(joystickListenersMutex);
+    for (GlfwInputBackend* listener : joystickListeners)
+    {
+        listener->m_joypads_changed = true;
+    }
+}
+
+bool GlfwInputBackend::initialize(std::vector<JoypadInfo>& available_joypads)
+{
+    if (!m_window)
+    {
+        if (!GuiRuntime::acquireGlfw())
+        {
+            yCError(KEYBOARDJOYPAD, "Unable to initialize GLFW for reading the joypads.");
+            return false;
+        }
+        m_owns_glfw = true;
+    }
+    else
+    {
+        glfwSetWindowUserPointer(m_window, this);
+        glfwSetKeyCallback(m_window, &GlfwInputBackend::keyCallback);
+        glfwSetWindowFocusCallback(m_window, &GlfwInputBackend::windowFocusCallback);
+        glfwSetWindowIconifyCallback(m_window, &GlfwInputBackend::windowIconifyCallback);
+        glfwSetWindowRefreshCallback(m_window, &GlfwInputBackend::windowRefreshCallback);
+        glfwSetFramebufferSizeCallback(m_window, &GlfwInputBackend::framebufferSizeCallback);
+        glfwSetCursorPosCallback(m_window, &GlfwInputBackend::cursorPosCallback);
+        glfwSetCursorEnterCallback(m_window, &GlfwInputBackend::cursorEnterCallback);
+        glfwSetMouseButtonCallback(m_window, &GlfwInputBackend::mouseButtonCallback);
+        glfwSetScrollCallback(m_window, &GlfwInputBackend::scrollCallback);
+        glfwSetCharCallback(m_window, &GlfwInputBackend::charCallback);
+        m_iconified = glfwGetWindowAttrib(m_window, GLFW_ICONIFIED) == GLFW_TRUE;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(joystickListenersMutex);
+        joystickListeners.push_back(this);
+        glfwSetJoystickCallback(&GlfwInputBackend::joystickCallback);
+    }
+
+    enumerateJoypads(available_joypads);
+
+    return true;
+}
+
+bool GlfwInputBackend::sample(KeyboardState& keyboard, const std::vector<JoypadInfo>& joypads,
+                              std::vector<float>& joypad_axis_values, std::vector<bool>& joypad_button_values)
+{
+    // The key callbacks are called from within glfwPollEvents. The keyboard is kept after polling, since
+    // the events of this window are dispatched also when another device sharing the GUI thread polls.
+    m_keyboard = &keyboard;
+    {
+        TraceScope trace_scope(m_trace, "glfwPollEvents");
+        glfwPollEvents();
+    }
+
+    TraceScope trace_scope(m_trace, "joypad read");
+    // The connections and disconnections are notified by the joystick callback, hence the presence is not checked here.
+    // The axes and the buttons of a disconnected joypad are null with a zero count.
+    for (auto& joypad : joypads)
+    {
+        if (!joypad.active)
+        {
+            continue;
+        }
+
+        int new_axes = 0, new_buttons = 0;
+        const float* axes = glfwGetJoystickAxes(joypad.index, &new_axes);
+        const unsigned char* buttons = glfwGetJoystickButtons(joypad.index, &new_buttons);
+        if (!axes)
+        {
+            new_axes = 0;
+        }
+        if (!buttons)
+        {
+            new_buttons = 0;
+        }
+
+        for (size_t i = 0; i < std::min(joypad.axes, new_axes); ++i)
+        {
+            joypad_axis_values[joypad.axes_offset + i] = axes[i];
+        }
+
+        for (size_t i = 0; i < std::min(joypad.buttons, new_buttons); ++i)
+        {
+            joypad_button_values[joypad.buttons_offset + i] = buttons[i] == GLFW_PRESS;
+        }
+    }
+
+    return true;
+}
+
+bool GlfwInputBackend::consumeJoypadChanges(std::vector<JoypadInfo>& available_joypads)
+{
+    if (!m_joypads_changed.exchange(false))
+    {
+        return false;
+    }
+    enumerateJoypads(available_joypads);
+    return true;
+}
+
+void GlfwInputBackend::sampleHats(const std::vector<JoypadInfo>& joypads, std::vector<unsigned char>& joypad_hat_values)
+{
+    for (auto& joypad : joypads)
+    {
+        if (!joypad.active)
+        {
+            continue;
+        }
+
+        // The GLFW hat bits (up, right, down, left) are the same of the YARP ones
+        int new_hats = 0;
+        const unsigned char* hats = glfwGetJoystickHats(joypad.index, &new_hats);
+        if (!hats)
+        {
+            new_hats = 0;
+        }
+
+        for (int i = 0; i < std::min(joypad.hats, new_hats); ++i)
+        {
+            joypad_hat_values[joypad.hats_offset + static_cast<size_t>(i)] = hats[i];
+        }
+    }
+}
+
+void GlfwInputBackend::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(joystickListenersMutex);
+        auto listener = std::find(joystickListeners.begin(), joystickListeners.end(), this);
+        if (listener != joystickListeners.end())
+        {
+            joystickListeners.erase(listener);
+            if (joystickListeners.empty())
+            {
+                glfwSetJoystickCallback(nullptr);
+            }
+        }
+    }
+
+    if (m_window)
+    {
+        glfwSetKeyCallback(m_window, nullptr);
+        glfwSetWindowFocusCallback(m_window, nullptr);
+        glfwSetWindowIconifyCallback(m_window, nullptr);
+        glfwSetWindowRefreshCallback(m_window, nullptr);
+        glfwSetFramebufferSizeCallback(m_window, nullptr);
+        glfwSetCursorPosCallback(m_window, nullptr);
+        glfwSetCursorEnterCallback(m_window, nullptr);
+        glfwSetMouseButtonCallback(m_window, nullptr);
+        glfwSetScrollCallback(m_window, nullptr);
+        glfwSetCharCallback(m_window, nullptr);
+        glfwSetWindowUserPointer(m_window, nullptr);
+        m_window = nullptr;
+    }
+    m_keyboard = nullptr;
+    m_imgui_context = nullptr;
+    if (m_owns_glfw)
+    {
+        GuiRuntime::releaseGlfw();
+        m_owns_glfw = false;
+    }
+}
+
+#ifdef __linux__
+
+bool LinuxJoystickInputBackend::initialize(std::vector<JoypadInfo>& available_joypads)
+{
+    for (size_t i = 0; i < m_devices.size(); ++i)
+    {
+        std::string path = "/dev/input/js" + std::to_string(i);
+        int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK);
+        if (fd < 0)
+        {
+            continue;
+        }
+
+        unsigned char axes_count = 0;
+        unsigned char button_count = 0;
+        char name[128] = "Unknown";
+        ioctl(fd, JSIOCGAXES, &axes_count);
+        ioctl(fd, JSIOCGBUTTONS, &button_count);
+        ioctl(fd, JSIOCGNAME(sizeof(name)), name);
+        name[sizeof(name) - 1] = '\0';
+
+        m_devices[i].fd = fd;
+        m_devices[i].axes.assign(axes_count, 0.0f);
+        m_devices[i].buttons.assign(button_count, false);
+
+        available_joypads.push_back({ .name = name, .index = static_cast<int>(i), .axes = axes_count, .buttons = button_count });
+        yCInfo(KEYBOARDJOYPAD) << "Joypad" << name << "is available (" << path
+                               << "axes =" << static_cast<int>(axes_count) << "buttons = " << static_cast<int>(button_count) << ").";
+    }
+
+    return true;
+}
+
+bool LinuxJoystickInputBackend::sample(KeyboardState&, const std::vector<JoypadInfo>& joypads,
+                                       std::vector<float>& joypad_axis_values, std::vector<bool>& joypad_button_values)
+{
+    for (auto& joypad : joypads)
+    {
+        Device& device = m_devices[static_cast<size_t>(joypad.index)];
+        if (!joypad.active || device.fd < 0)
+        {
+            continue;
+        }
+
+        js_event event;
+        ssize_t read_bytes;
+        while ((read_bytes = read(device.fd, &event, sizeof(event))) == sizeof(event))
+        {
+            unsigned char type = event.type & ~JS_EVENT_INIT;
+            if (type == JS_EVENT_AXIS && event.number < device.axes.size())
+            {
+                device.axes[event.number] = std::max(-1.0f, event.value / 32767.0f);
+            }
+            else if (type == JS_EVENT_BUTTON && event.number < device.buttons.size())
+            {
+                device.buttons[event.number] = event.value != 0;
+            }
+        }
+
+        if (read_bytes < 0 && errno != EAGAIN)
+        {
+            yCWarning(KEYBOARDJOYPAD) << "The joypad" << joypad.name << "has been disconnected.";
+            ::close(device.fd);
+            device.fd = -1;
+            continue;
+        }
+
+        for (size_t i = 0; i < std::min(device.axes.size(), static_cast<size_t>(joypad.axes)); ++i)
+        {
+            joypad_axis_values[joypad.axes_offset + i] = device.axes[i];
+        }
+
+        for (size_t i = 0; i < std::min(device.buttons.size(), static_cast<size_t>(joypad.buttons)); ++i)
+        {
+            joypad_button_values[joypad.buttons_offset + i] = device.buttons[i];
+        }
+    }
+
+    return true;
+}
+
+void LinuxJoystickInputBackend::close()
+{
+    for (auto& device : m_devices)
+    {
+        if (device.fd >= 0)
+        {
+            ::close(device.fd);
+            device.fd = -1;
+        }
+    }
+}
+
+#endif // __linux__
+
+ProgrammaticInputBackend::ProgrammaticInputBackend(size_t number_of_axes, size_t number_of_buttons)
+    : m_axes(number_of_axes, 0.0f),
+      m_buttons(number_of_buttons, false)
+{
+}
+
+bool ProgrammaticInputBackend::setAxis(size_t axis_id, float value)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (axis_id >= m_axes.size())
+    {
+        yCError(KEYBOARDJOYPAD) << "The virtual joypad axis with id" << axis_id << "does not exist.";
+        return false;
+    }
+    m_axes[axis_id] = std::clamp(value, -1.0f, 1.0f);
+    return true;
+}
+
+bool ProgrammaticInputBackend::setButton(size_t button_id, bool pressed)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (button_id >= m_buttons.size())
+    {
+        yCError(KEYBOARDJOYPAD) << "The virtual joypad button with id" << button_id << "does not exist.";
+        return false;
+    }
+    m_buttons[button_id] = pressed;
+    return true;
+}
+
+bool ProgrammaticInputBackend::initialize(std::vector<JoypadInfo>& available_joypads)
+{
+    available_joypads.push_back({ .name = "Virtual joypad", .index = 0,
+                                  .axes = static_cast<int>(m_axes.size()), .buttons = static_cast<int>(m_buttons.size()) });
+    yCInfo(KEYBOARDJOYPAD) << "Using a virtual joypad with" << m_axes.size() << "axes and" << m_buttons.size() << "buttons.";
+    return true;
+}
+
+bool ProgrammaticInputBackend::sample(KeyboardState&, const std::vector<JoypadInfo>& joypads,
+                                      std::vector<float>& joypad_axis_values, std::vector<bool>& joypad_button_values)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& joypad : joypads)
+    {
+        if (!joypad.active)
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < m_axes.size(); ++i)
+        {
+            joypad_axis_values[joypad.axes_offset + i] = m_axes[i];
+        }
+
+        for (size_t i = 0; i < m_buttons.size(); ++i)
+        {
+            joypad_button_values[joypad.buttons_offset + i] = m_buttons[i];
+        }
+    }
+
+    return true;
+}
+
+void ProgrammaticInputBackend::close()
+{
+}
@@ -0,0 +1,424 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_KEYBOARDJOYPADINPUTBACKENDS_H
+#define YARP_DEV_KEYBOARDJOYPADINPUTBACKENDS_H
+
+#include <imgui.h>
+
+#include <KeyboardJoypadStatistics.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct GLFWwindow;
+class TraceWriter;
+
+struct JoypadInfo
+{
+    std::string name;
+    std::string guid; //Identifies the model, when available. Empty otherwise.
+    int index; //Index of the joypad in the backend, e.g. the GLFW joystick id
+    int axes;
+    int buttons;
+    int hats;
+    size_t axes_offset;
+    size_t buttons_offset;
+    size_t hats_offset;
+    bool active;
+};
+
+struct KeyEvent
+{
+    ImGuiKey key{ ImGuiKey_None }; //ImGuiKey_None to release all the keys
+    bool down{ false };
+    int64_t time{ 0 }; //Arrival time, as given by LatencyStatistics::now()
+};
+
+/**
+ * Bounded lock-free queue of key events, with multiple producers and a single consumer.
+ * Each cell has a sequence telling whether it is free for the producer of a given position, or ready for the consumer.
+ * The producers never wait: when the queue is full, the event is dropped and counted.
+ */
+class KeyEventQueue
+{
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        KeyEvent event;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+    alignas(64) std::atomic<size_t> m_push_position{ 0 };
+    alignas(64) size_t m_pop_position{ 0 }; //Only accessed by the consumer
+    std::atomic<uint64_t> m_dropped_events{ 0 };
+
+public:
+    // The capacity is rounded up to a power of two
+    explicit KeyEventQueue(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        m_cells = std::make_unique<Cell[]>(size);
+        m_mask = size - 1;
+        for (size_t i = 0; i < size; ++i)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Thread safe
+    bool push(const KeyEvent& event)
+    {
+        size_t position = m_push_position.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell& cell = m_cells[position & m_mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            if (sequence == position)
+            {
+                if (m_push_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    cell.event = event;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (sequence < position)
+            {
+                // The cell still holds the event pushed one lap before
+                m_dropped_events.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                position = m_push_position.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer only. The oldest event, nullptr if the queue is empty.
+    const KeyEvent* front() const
+    {
+        const Cell& cell = m_cells[m_pop_position & m_mask];
+        return cell.sequence.load(std::memory_order_acquire) == m_pop_position + 1 ? &cell.event : nullptr;
+    }
+
+    // Consumer only. Removes the event returned by front.
+    void pop()
+    {
+        Cell& cell = m_cells[m_pop_position & m_mask];
+        cell.sequence.store(m_pop_position + m_mask + 1, std::memory_order_release);
+        ++m_pop_position;
+    }
+
+    uint64_t droppedEvents() const
+    {
+        return m_dropped_events.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * The keys are set from any thread by queuing their events, e.g. from the GLFW callbacks or from IKeyboardJoypadInput.
+ * The thread sampling the inputs applies them in order before each sample, so that no edge is lost or merged.
+ */
+struct KeyboardState
+{
+    struct KeyState
+    {
+        bool down{ false };
+        bool pressed{ false };
+        bool released{ false };
+    };
+
+    static constexpr size_t queueCapacity = 1024;
+
+    std::array<KeyState, ImGuiKey_NamedKey_COUNT> keys;
+    KeyEventQueue events{ queueCapacity };
+    int64_t first_edge_time{ 0 }; //Arrival time of the first edge applied in this sample, 0 if none
+
+    static bool isNamedKey(ImGuiKey key)
+    {
+        return key >= ImGuiKey_NamedKey_BEGIN && key < ImGuiKey_NamedKey_END;
+    }
+
+    // Thread safe. The auto-repeated presses are expected to be filtered out by the caller.
+    bool setKeyDown(ImGuiKey key, bool down)
+    {
+        if (!isNamedKey(key))
+        {
+            return false;
+        }
+        return events.push({ key, down, LatencyStatistics::now() });
+    }
+
+    // Thread safe. Releases all the keys, e.g. when the release events cannot be received anymore.
+    bool releaseAll()
+    {
+        return events.push({ ImGuiKey_None, false, LatencyStatistics::now() });
+    }
+
+    // Applies the queued events in order, with at most one edge per key. Hence, each press and each release is
+    // seen by at least one sample, also when a key is tapped more than once within a sampling period.
+    // The events following the second edge of a key are left in the queue for the next samples.
+    void applyQueuedEvents()
+    {
+        while (const KeyEvent* event = events.front())
+        {
+            if (event->key == ImGuiKey_None)
+            {
+                for (const KeyState& state : keys)
+                {
+                    if (state.down && (state.pressed || state.released))
+                    {
+                        return;
+                    }
+                }
+                for (KeyState& state : keys)
+                {
+                    if (state.down)
+                    {
+                        applyEdge(state, false, event->time);
+                    }
+                }
+            }
+            else
+            {
+                KeyState& state = keys[static_cast<size_t>(event->key - ImGuiKey_NamedKey_BEGIN)];
+                if (event->down != state.down)
+                {
+                    if (state.pressed || state.released)
+                    {
+                        return;
+                    }
+                    applyEdge(state, event->down, event->time);
+                }
+            }
+            events.pop();
+        }
+    }
+
+    void applyEdge(KeyState& state, bool down, int64_t time)
+    {
+        if (first_edge_time == 0)
+        {
+            first_edge_time = time;
+        }
+        state.pressed = down;
+        state.released = !down;
+        state.down = down;
+    }
+
+    // Overrides the edges of a key, e.g. when replaying a recording
+    void setEdges(ImGuiKey key, bool pressed, bool released)
+    {
+        if (!isNamedKey(key))
+        {
+            return;
+        }
+        KeyState& state = keys[static_cast<size_t>(key - ImGuiKey_NamedKey_BEGIN)];
+        state.pressed = pressed;
+        state.released = released;
+    }
+
+    bool isPressed(ImGuiKey key) const
+    {
+        return isNamedKey(key) && keys[static_cast<size_t>(key - ImGuiKey_NamedKey_BEGIN)].pressed;
+    }
+
+    bool isReleased(ImGuiKey key) const
+    {
+        return isNamedKey(key) && keys[static_cast<size_t>(key - ImGuiKey_NamedKey_BEGIN)].released;
+    }
+
+    // To be called after each input sample, to clear the edges that have been consumed
+    void clearEdges()
+    {
+        first_edge_time = 0;
+        for (auto& state : keys)
+        {
+            state.pressed = false;
+            state.released = false;
+        }
+    }
+};
+
+/**
+ * Source of the raw inputs, i.e. the keyboard keys and the joypads axes and buttons.
+ * All the methods are called from the thread sampling the inputs.
+ */
+class InputBackend
+{
+public:
+    virtual ~InputBackend() = default;
+
+    // Fills the list of available joypads. The offsets and the active flag are set by the caller.
+    virtual bool initialize(std::vector<JoypadInfo>& available_joypads) = 0;
+
+    // Updates the keyboard state and writes the values of the active joypads at their offsets.
+    // Returns false if no new input is available, so that the outputs are not evaluated in this sample.
+    virtual bool sample(KeyboardState& keyboard, const std::vector<JoypadInfo>& joypads,
+                        std::vector<float>& joypad_axis_values, std::vector<bool>& joypad_button_values) = 0;
+
+    // Whether another input is already available, e.g. when replaying a recording faster than real time.
+    virtual bool samplePending() const
+    {
+        return false;
+    }
+
+    // Fills the list of available joypads if a joypad has been connected or disconnected since the last call.
+    // Returns false if nothing changed. The offsets and the active flag are set by the caller.
+    virtual bool consumeJoypadChanges(std::vector<JoypadInfo>& available_joypads)
+    {
+        return false;
+    }
+
+    // Writes the hats of the active joypads at their offsets, to be called after sample.
+    // The hats are provided only by GLFW, the other backends do not have any.
+    virtual void sampleHats(const std::vector<JoypadInfo>& joypads, std::vector<unsigned char>& joypad_hat_values)
+    {
+    }
+
+    virtual void close() = 0;
+};
+
+/**
+ * Keyboard from the GLFW window (if any) and joypads from the GLFW joystick API.
+ * If no window is provided, GLFW is acquired from the shared GUI runtime by the backend itself.
+ * The events of the window are forwarded to the ImGui GLFW backend, installed without its own callbacks.
+ */
+class GlfwInputBackend : public InputBackend
+{
+    GLFWwindow* m_window{ nullptr };
+    ImGuiContext* m_imgui_context{ nullptr };
+    KeyboardState* m_keyboard{ nullptr };
+    TraceWriter* m_trace{ nullptr };
+    bool m_owns_glfw{ false };
+    bool m_iconified{ false };
+    bool m_window_events{ true };
+    std::atomic<bool> m_joypads_changed{ false };
+
+    static ImGuiKey glfwKeyToImGuiKey(int key, int scancode);
+
+    static void enumerateJoypads(std::vector<JoypadInfo>& available_joypads);
+
+    // The GLFW joystick callback is global, hence it notifies all the backends
+    static void joystickCallback(int jid, int event);
+
+    static void markWindowEvent(GLFWwindow* window);
+
+    // The ImGui GLFW backend writes the events in the current ImGui context. With multiple windows,
+    // the events of a window can arrive while the context of another one is current, hence it is switched.
+    template <typename Callback, typename... Args>
+    static void forwardToImGui(GLFWwindow* window, Callback callback, Args... args);
+
+    static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+    static void windowFocusCallback(GLFWwindow* window, int focused);
+
+    static void windowIconifyCallback(GLFWwindow* window, int iconified);
+
+    static void windowRefreshCallback(GLFWwindow* window);
+
+    static void framebufferSizeCallback(GLFWwindow* window, int width, int height);
+
+    static void cursorPosCallback(GLFWwindow* window, double x, double y);
+
+    static void cursorEnterCallback(GLFWwindow* window, int entered);
+
+    static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+
+    static void scrollCallback(GLFWwindow* window, double x_offset, double y_offset);
+
+    static void charCallback(GLFWwindow* window, unsigned int codepoint);
+
+public:
+    explicit GlfwInputBackend(GLFWwindow* window = nullptr);
+
+    // Sets the ImGui context receiving the events of the window, nullptr to stop forwarding them
+    void setImGuiContext(ImGuiContext* context);
+
+    // Sets the trace receiving the durations of the polling and of the joypad reads, nullptr to disable it
+    void setTrace(TraceWriter* trace);
+
+    // Whether the window is minimized, hence there is no need to draw it
+    bool isIconified() const;
+
+    // Whether an event that may change the content of the window (mouse, keyboard, resize, ...) arrived since the last call
+    bool consumeWindowEvents();
+
+    bool initialize(std::vector<JoypadInfo>& available_joypads) override;
+
+    bool sample(KeyboardState& keyboard, const std::vector<JoypadInfo>& joypads,
+                std::vector<float>& joypad_axis_values, std::vector<bool>& joypad_button_values) override;
+
+    bool consumeJoypadChanges(std::vector<JoypadInfo>& available_joypads) override;
+
+    void sampleHats(const std::vector<JoypadInfo>& joypads, std::vector<unsigned char>& joypad_hat_values) override;
+
+    void close() override;
+};
+
+#ifdef __linux__
+/**
+ * Joypads read directly from the Linux joystick API (/dev/input/jsN), without needing a display.
+ */
+class LinuxJoystickInputBackend : public InputBackend
+{
+    struct Device
+    {
+        int fd{ -1 };
+        std::vector<float> axes;
+        std::vector<bool> buttons;
+    };
+
+    std::array<Device, 16> m_devices;
+
+public:
+    bool initialize(std::vector<JoypadInfo>& available_joypads) override;
+
+    bool sample(KeyboardState& keyboard, const std::vector<JoypadInfo>& joypads,
+                std::vector<float>& joypad_axis_values, std::vector<bool>& joypad_button_values) override;
+
+    void close() override;
+};
+#endif // __linux__
+
+/**
+ * A virtual joypad whose values are set from code, through the IKeyboardJoypadInput interface.
+ */
+class ProgrammaticInputBackend : public InputBackend
+{
+    std::mutex m_mutex;
+    std::vector<float> m_axes;
+    std::vector<bool> m_buttons;
+
+public:
+    ProgrammaticInputBackend(size_t number_of_axes, size_t number_of_buttons);
+
+    bool setAxis(size_t axis_id, float value);
+
+    bool setButton(size_t button_id, bool pressed);
+
+    bool initialize(std::vector<JoypadInfo>& available_joypads) override;
+
+    bool sample(KeyboardState& keyboard, const std::vector<JoypadInfo>& joypads,
+                std::vector<float>& joypad_axis_values, std::vector<bool>& joypad_button_values) override;
+
+    void close() override;
+};
+
+#endif // YARP_DEV_KEYBOARDJOYPADINPUTBACKENDS_H
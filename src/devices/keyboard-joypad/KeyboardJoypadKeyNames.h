@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_KEYBOARDJOYPADKEYNAMES_H
+#define YARP_DEV_KEYBOARDJOYPADKEYNAMES_H
+
+#include <imgui.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Names of the keys accepted in the "buttons" parameter and by IKeyboardJoypadInput::setKey, in uppercase.
+ * A name can refer to more than one key, e.g. the digits refer both to the main ones and to the keypad ones.
+ */
+struct KeyName
+{
+    std::string_view name;
+    std::array<ImGuiKey, 2> keys; //ImGuiKey_None when unused
+};
+
+inline constexpr KeyName keyNames[] = {
+    { "A", { ImGuiKey_A, ImGuiKey_None } },
+    { "B", { ImGuiKey_B, ImGuiKey_None } },
+    { "C", { ImGuiKey_C, ImGuiKey_None } },
+    { "D", { ImGuiKey_D, ImGuiKey_None } },
+    { "E", { ImGuiKey_E, ImGuiKey_None } },
+    { "F", { ImGuiKey_F, ImGuiKey_None } },
+    { "G", { ImGuiKey_G, ImGuiKey_None } },
+    { "H", { ImGuiKey_H, ImGuiKey_None } },
+    { "I", { ImGuiKey_I, ImGuiKey_None } },
+    { "J", { ImGuiKey_J, ImGuiKey_None } },
+    { "K", { ImGuiKey_K, ImGuiKey_None } },
+    { "L", { ImGuiKey_L, ImGuiKey_None } },
+    { "M", { ImGuiKey_M, ImGuiKey_None } },
+    { "N", { ImGuiKey_N, ImGuiKey_None } },
+    { "O", { ImGuiKey_O, ImGuiKey_None } },
+    { "P", { ImGuiKey_P, ImGuiKey_None } },
+    { "Q", { ImGuiKey_Q, ImGuiKey_None } },
+    { "R", { ImGuiKey_R, ImGuiKey_None } },
+    { "S", { ImGuiKey_S, ImGuiKey_None } },
+    { "T", { ImGuiKey_T, ImGuiKey_None } },
+    { "U", { ImGuiKey_U, ImGuiKey_None } },
+    { "V", { ImGuiKey_V, ImGuiKey_None } },
+    { "W", { ImGuiKey_W, ImGuiKey_None } },
+    { "X", { ImGuiKey_X, ImGuiKey_None } },
+    { "Y", { ImGuiKey_Y, ImGuiKey_None } },
+    { "Z", { ImGuiKey_Z, ImGuiKey_None } },
+    { "0", { ImGuiKey_0, ImGuiKey_Keypad0 } },
+    { "1", { ImGuiKey_1, ImGuiKey_Keypad1 } },
+    { "2", { ImGuiKey_2, ImGuiKey_Keypad2 } },
+    { "3", { ImGuiKey_3, ImGuiKey_Keypad3 } },
+    { "4", { ImGuiKey_4, ImGuiKey_Keypad4 } },
+    { "5", { ImGuiKey_5, ImGuiKey_Keypad5 } },
+    { "6", { ImGuiKey_6, ImGuiKey_Keypad6 } },
+    { "7", { ImGuiKey_7, ImGuiKey_Keypad7 } },
+    { "8", { ImGuiKey_8, ImGuiKey_Keypad8 } },
+    { "9", { ImGuiKey_9, ImGuiKey_Keypad9 } },
+    { "F1", { ImGuiKey_F1, ImGuiKey_None } },
+    { "F2", { ImGuiKey_F2, ImGuiKey_None } },
+    { "F3", { ImGuiKey_F3, ImGuiKey_None } },
+    { "F4", { ImGuiKey_F4, ImGuiKey_None } },
+    { "F5", { ImGuiKey_F5, ImGuiKey_None } },
+    { "F6", { ImGuiKey_F6, ImGuiKey_None } },
+    { "F7", { ImGuiKey_F7, ImGuiKey_None } },
+    { "F8", { ImGuiKey_F8, ImGuiKey_None } },
+    { "F9", { ImGuiKey_F9, ImGuiKey_None } },
+    { "F10", { ImGuiKey_F10, ImGuiKey_None } },
+    { "F11", { ImGuiKey_F11, ImGuiKey_None } },
+    { "F12", { ImGuiKey_F12, ImGuiKey_None } },
+    { "SPACE", { ImGuiKey_Space, ImGuiKey_None } },
+    { "ENTER", { ImGuiKey_Enter, ImGuiKey_None } },
+    { "ESCAPE", { ImGuiKey_Escape, ImGuiKey_None } },
+    { "BACKSPACE", { ImGuiKey_Backspace, ImGuiKey_None } },
+    { "DELETE", { ImGuiKey_Delete, ImGuiKey_None } },
+    { "TAB", { ImGuiKey_Tab, ImGuiKey_None } },
+    { "LEFT", { ImGuiKey_LeftArrow, ImGuiKey_None } },
+    { "RIGHT", { ImGuiKey_RightArrow, ImGuiKey_None } },
+    { "UP", { ImGuiKey_UpArrow, ImGuiKey_None } },
+    { "DOWN", { ImGuiKey_DownArrow, ImGuiKey_None } },
+    { "INSERT", { ImGuiKey_Insert, ImGuiKey_None } },
+    { "HOME", { ImGuiKey_Home, ImGuiKey_None } },
+    { "END", { ImGuiKey_End, ImGuiKey_None } },
+    { "PAGE_UP", { ImGuiKey_PageUp, ImGuiKey_None } },
+    { "PAGE_DOWN", { ImGuiKey_PageDown, ImGuiKey_None } },
+    { "LEFT_SHIFT", { ImGuiKey_LeftShift, ImGuiKey_None } },
+    { "RIGHT_SHIFT", { ImGuiKey_RightShift, ImGuiKey_None } },
+    { "SHIFT", { ImGuiKey_LeftShift, ImGuiKey_RightShift } },
+    { "LEFT_CTRL", { ImGuiKey_LeftCtrl, ImGuiKey_None } },
+    { "RIGHT_CTRL", { ImGuiKey_RightCtrl, ImGuiKey_None } },
+    { "CTRL", { ImGuiKey_LeftCtrl, ImGuiKey_RightCtrl } },
+    { "LEFT_ALT", { ImGuiKey_LeftAlt, ImGuiKey_None } },
+    { "RIGHT_ALT", { ImGuiKey_RightAlt, ImGuiKey_None } },
+    { "ALT", { ImGuiKey_LeftAlt, ImGuiKey_RightAlt } },
+    { "LEFT_SUPER", { ImGuiKey_LeftSuper, ImGuiKey_None } },
+    { "RIGHT_SUPER", { ImGuiKey_RightSuper, ImGuiKey_None } },
+    { "SUPER", { ImGuiKey_LeftSuper, ImGuiKey_RightSuper } },
+    { "MENU", { ImGuiKey_Menu, ImGuiKey_None } },
+    { "APOSTROPHE", { ImGuiKey_Apostrophe, ImGuiKey_None } },
+    { "COMMA", { ImGuiKey_Comma, ImGuiKey_None } },
+    { "MINUS", { ImGuiKey_Minus, ImGuiKey_None } },
+    { "PERIOD", { ImGuiKey_Period, ImGuiKey_None } },
+    { "SLASH", { ImGuiKey_Slash, ImGuiKey_None } },
+    { "SEMICOLON", { ImGuiKey_Semicolon, ImGuiKey_None } },
+    { "EQUAL", { ImGuiKey_Equal, ImGuiKey_None } },
+    { "LEFT_BRACKET", { ImGuiKey_LeftBracket, ImGuiKey_None } },
+    { "BACKSLASH", { ImGuiKey_Backslash, ImGuiKey_None } },
+    { "RIGHT_BRACKET", { ImGuiKey_RightBracket, ImGuiKey_None } },
+    { "GRAVE_ACCENT", { ImGuiKey_GraveAccent, ImGuiKey_None } },
+    { "CAPS_LOCK", { ImGuiKey_CapsLock, ImGuiKey_None } },
+    { "SCROLL_LOCK", { ImGuiKey_ScrollLock, ImGuiKey_None } },
+    { "NUM_LOCK", { ImGuiKey_NumLock, ImGuiKey_None } },
+    { "PRINT_SCREEN", { ImGuiKey_PrintScreen, ImGuiKey_None } },
+    { "PAUSE", { ImGuiKey_Pause, ImGuiKey_None } },
+    { "KP_0", { ImGuiKey_Keypad0, ImGuiKey_None } },
+    { "KP_1", { ImGuiKey_Keypad1, ImGuiKey_None } },
+    { "KP_2", { ImGuiKey_Keypad2, ImGuiKey_None } },
+    { "KP_3", { ImGuiKey_Keypad3, ImGuiKey_None } },
+    { "KP_4", { ImGuiKey_Keypad4, ImGuiKey_None } },
+    { "KP_5", { ImGuiKey_Keypad5, ImGuiKey_None } },
+    { "KP_6", { ImGuiKey_Keypad6, ImGuiKey_None } },
+    { "KP_7", { ImGuiKey_Keypad7, ImGuiKey_None } },
+    { "KP_8", { ImGuiKey_Keypad8, ImGuiKey_None } },
+    { "KP_9", { ImGuiKey_Keypad9, ImGuiKey_None } },
+    { "KP_DECIMAL", { ImGuiKey_KeypadDecimal, ImGuiKey_None } },
+    { "KP_DIVIDE", { ImGuiKey_KeypadDivide, ImGuiKey_None } },
+    { "KP_MULTIPLY", { ImGuiKey_KeypadMultiply, ImGuiKey_None } },
+    { "KP_SUBTRACT", { ImGuiKey_KeypadSubtract, ImGuiKey_None } },
+    { "KP_ADD", { ImGuiKey_KeypadAdd, ImGuiKey_None } },
+    { "KP_ENTER", { ImGuiKey_KeypadEnter, ImGuiKey_None } },
+    { "KP_EQUAL", { ImGuiKey_KeypadEqual, ImGuiKey_None } },
+    { "MOUSE_LEFT", { ImGuiKey_MouseLeft, ImGuiKey_None } },
+    { "MOUSE_RIGHT", { ImGuiKey_MouseRight, ImGuiKey_None } },
+    { "MOUSE_MIDDLE", { ImGuiKey_MouseMiddle, ImGuiKey_None } },
+    { "MOUSE_X1", { ImGuiKey_MouseX1, ImGuiKey_None } },
+    { "MOUSE_X2", { ImGuiKey_MouseX2, ImGuiKey_None } },
+#if IMGUI_VERSION_NUM >= 19000 // The keys from F13 to F24 are available since ImGui 1.90
+    { "F13", { ImGuiKey_F13, ImGuiKey_None } },
+    { "F14", { ImGuiKey_F14, ImGuiKey_None } },
+    { "F15", { ImGuiKey_F15, ImGuiKey_None } },
+    { "F16", { ImGuiKey_F16, ImGuiKey_None } },
+    { "F17", { ImGuiKey_F17, ImGuiKey_None } },
+    { "F18", { ImGuiKey_F18, ImGuiKey_None } },
+    { "F19", { ImGuiKey_F19, ImGuiKey_None } },
+    { "F20", { ImGuiKey_F20, ImGuiKey_None } },
+    { "F21", { ImGuiKey_F21, ImGuiKey_None } },
+    { "F22", { ImGuiKey_F22, ImGuiKey_None } },
+    { "F23", { ImGuiKey_F23, ImGuiKey_None } },
+    { "F24", { ImGuiKey_F24, ImGuiKey_None } },
+#endif
+};
+
+/**
+ * Perfect hash table of the key names, built at compile time. The seed of the hash is searched such that
+ * each name has its own slot, hence a lookup is a single hash and a single comparison.
+ */
+class KeyNameTable
+{
+    static constexpr size_t tableSize = 4096;
+    static_assert(std::size(keyNames) < 256, "The slots store the index of the names in a byte");
+
+    std::array<uint8_t, tableSize> m_slots{}; //Index of the name plus one, 0 if the slot is empty
+    uint32_t m_seed{ 0 };
+
+    // FNV-1a
+    static constexpr uint32_t hash(std::string_view name, uint32_t seed)
+    {
+        uint32_t value = 2166136261u ^ seed;
+        for (char c : name)
+        {
+            value = (value ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+        return value;
+    }
+
+    constexpr bool tryBuild(uint32_t seed)
+    {
+        m_slots = {};
+        for (size_t i = 0; i < std::size(keyNames); ++i)
+        {
+            uint8_t& slot = m_slots[hash(keyNames[i].name, seed) % tableSize];
+            if (slot != 0)
+            {
+                return false;
+            }
+            slot = static_cast<uint8_t>(i + 1);
+        }
+        m_seed = seed;
+        return true;
+    }
+
+public:
+    constexpr KeyNameTable()
+    {
+        uint32_t seed = 0;
+        while (!tryBuild(seed))
+        {
+            ++seed;
+        }
+    }
+
+    // Returns nullptr if the name is not known
+    constexpr const KeyName* find(std::string_view name) const
+    {
+        uint8_t slot = m_slots[hash(name, m_seed) % tableSize];
+        if (slot == 0 || keyNames[slot - 1].name != name)
+        {
+            return nullptr;
+        }
+        return &keyNames[slot - 1];
+    }
+};
+
+inline constexpr KeyNameTable keyNameTable;
+
+static_assert(keyNameTable.find("A") && keyNameTable.find("A")->keys[0] == ImGuiKey_A, "Key name table check");
+static_assert(keyNameTable.find("KP_ENTER") && keyNameTable.find("KP_ENTER")->keys[0] == ImGuiKey_KeypadEnter, "Key name table check");
+static_assert(!keyNameTable.find("NOT_A_KEY"), "Key name table check");
+
+#endif // YARP_DEV_KEYBOARDJOYPADKEYNAMES_H
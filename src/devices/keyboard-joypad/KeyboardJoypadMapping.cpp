@@ -0,0 +1,344 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#include <algorithm>
+
+#include <yarp/os/LogStream.h>
+
+#include <KeyboardJoypadMapping.h>
+#include <KeyboardJoypadLogComponent.h>
+
+uint32_t MappingTable::addButton(ButtonType type, bool holdable)
+{
+    uint32_t button = static_cast<uint32_t>(m_toggle.size());
+    m_toggle.push_back(type == ButtonType::TOGGLE);
+    m_holdable.push_back(holdable);
+    m_any_pressed.push_back(false);
+    m_any_released.push_back(false);
+    m_pressed.push_back(false);
+    m_active.push_back(false);
+    m_gui_clicked.push_back(false);
+    m_gui_kept_pressed.push_back(false);
+    m_value_from_joypad_axes.push_back(0.0f);
+    m_levels.push_back(0.0f);
+    m_presses.push_back(0);
+    m_releases.push_back(0);
+    return button;
+}
+
+void MappingTable::addKey(uint32_t button, ImGuiKey key)
+{
+    m_keys.push_back(key);
+    m_keys_buttons.push_back(button);
+}
+
+void MappingTable::addJoypadButton(uint32_t button, int joypad_button)
+{
+    if (joypad_button < 0)
+    {
+        return;
+    }
+    m_joypad_buttons.push_back(static_cast<uint32_t>(joypad_button));
+    m_joypad_buttons_buttons.push_back(button);
+}
+
+void MappingTable::addJoypadAxis(uint32_t button, int joypad_axis, int sign)
+{
+    if (joypad_axis < 0)
+    {
+        return;
+    }
+    m_joypad_axes.push_back(static_cast<uint32_t>(joypad_axis));
+    m_joypad_axes_signs.push_back(static_cast<float>(sign));
+    m_joypad_axes_buttons.push_back(button);
+}
+
+void MappingTable::addOutput(uint32_t button, MappingOutput output, size_t index, int sign)
+{
+    Contributions& contributions = output == MappingOutput::AXES ? m_axes_contributions : m_buttons_contributions;
+    contributions.buttons.push_back(button);
+    contributions.outputs.push_back(static_cast<uint32_t>(index));
+    contributions.signs.push_back(static_cast<double>(sign));
+}
+
+void MappingTable::setHoldButton(uint32_t button)
+{
+    m_hold_button = button;
+}
+
+void MappingTable::checkJoypadInputs(size_t number_of_joypad_axes, size_t number_of_joypad_buttons) const
+{
+    if (number_of_joypad_buttons > 0)
+    {
+        for (uint32_t joypad_button : m_joypad_buttons)
+        {
+            if (joypad_button >= number_of_joypad_buttons)
+            {
+                yCError(KEYBOARDJOYPAD) << "The joypad button index" << joypad_button << "is out of range.";
+            }
+        }
+    }
+
+    if (number_of_joypad_axes > 0)
+    {
+        for (uint32_t joypad_axis : m_joypad_axes)
+        {
+            if (joypad_axis >= number_of_joypad_axes)
+            {
+                yCError(KEYBOARDJOYPAD) << "The joypad axis index" << joypad_axis << "is out of range.";
+            }
+        }
+    }
+}
+
+size_t MappingTable::size() const
+{
+    return m_toggle.size();
+}
+
+void MappingTable::updateButton(size_t button, bool hold_active)
+{
+    bool toggle_button = m_toggle[button];
+    bool regular_button = !toggle_button;
+    bool active = m_active[button];
+    bool pressed = m_pressed[button];
+
+    if (m_any_pressed[button])
+    {
+        pressed = true;
+        if (toggle_button || !hold_active)
+        {
+            active = true;
+        }
+        else
+        {
+            active = !active;
+        }
+    }
+    else if (pressed && m_any_released[button])
+    {
+        pressed = false;
+        if (toggle_button || !hold_active)
+        {
+            active = false;
+        }
+    }
+
+    if (m_gui_clicked[button] && (toggle_button || hold_active))
+    {
+        active = !active; //Toggle the button
+    }
+    else if (regular_button && m_gui_kept_pressed[button] && !hold_active) //The button is clicked and is not a toggling button
+    {
+        active = true;
+    }
+    else if (regular_button && !pressed && !hold_active) //The button is not clicked and is not a toggling button
+    {
+        active = false;
+    }
+
+    if (pressed != m_pressed[button])
+    {
+        (pressed ? m_presses : m_releases)[button]++;
+    }
+
+    m_gui_clicked[button] = false;
+    m_active[button] = active;
+    m_pressed[button] = pressed;
+}
+
+void MappingTable::evaluate(const KeyboardState& keyboard, float deadzone,
+                            const std::vector<float>& joypad_axis_values, const std::vector<bool>& joypad_button_values,
+                            std::vector<double>& axes_values, std::vector<double>& buttons_values)
+{
+    const size_t number_of_buttons = m_toggle.size();
+    std::fill(m_any_pressed.begin(), m_any_pressed.end(), uint8_t{ 0 });
+    std::fill(m_any_released.begin(), m_any_released.end(), uint8_t{ 0 });
+    std::fill(m_value_from_joypad_axes.begin(), m_value_from_joypad_axes.end(), 0.0f);
+
+    for (size_t i = 0; i < m_keys.size(); ++i)
+    {
+        m_any_pressed[m_keys_buttons[i]] |= keyboard.isPressed(m_keys[i]);
+        m_any_released[m_keys_buttons[i]] |= keyboard.isReleased(m_keys[i]);
+    }
+
+    for (size_t i = 0; i < m_joypad_buttons.size(); ++i)
+    {
+        if (m_joypad_buttons[i] < joypad_button_values.size())
+        {
+            bool value = joypad_button_values[m_joypad_buttons[i]];
+            m_any_pressed[m_joypad_buttons_buttons[i]] |= value;
+            m_any_released[m_joypad_buttons_buttons[i]] |= !value;
+        }
+    }
+
+    for (size_t i = 0; i < m_joypad_axes.size(); ++i)
+    {
+        if (m_joypad_axes[i] < joypad_axis_values.size())
+        {
+            float input = m_joypad_axes_signs[i] * joypad_axis_values[m_joypad_axes[i]];
+            m_value_from_joypad_axes[m_joypad_axes_buttons[i]] += input > deadzone ? (input - deadzone) / (1.0f - deadzone) : 0.0f;
+        }
+    }
+
+    // The hold button is updated first, since it changes the behavior of the others
+    bool hold_active = false;
+    if (m_hold_button >= 0)
+    {
+        size_t hold_button = static_cast<size_t>(m_hold_button);
+        this->updateButton(hold_button, false);
+        hold_active = m_active[hold_button] || m_value_from_joypad_axes[hold_button] > 0;
+    }
+    for (size_t i = 0; i < number_of_buttons; ++i)
+    {
+        if (static_cast<int64_t>(i) != m_hold_button)
+        {
+            this->updateButton(i, hold_active && m_holdable[i]);
+        }
+    }
+
+    for (size_t i = 0; i < number_of_buttons; ++i)
+    {
+        m_levels[i] = static_cast<float>(m_active[i]) + m_value_from_joypad_axes[i];
+    }
+
+    std::fill(axes_values.begin(), axes_values.end(), 0.0);
+    for (size_t i = 0; i < m_axes_contributions.buttons.size(); ++i)
+    {
+        axes_values[m_axes_contributions.outputs[i]] += m_axes_contributions.signs[i] * static_cast<double>(m_levels[m_axes_contributions.buttons[i]]);
+    }
+    for (double& value : axes_values)
+    {
+        value = std::clamp(value, -1.0, 1.0);
+    }
+
+    std::fill(buttons_values.begin(), buttons_values.end(), 0.0);
+    for (size_t i = 0; i < m_buttons_contributions.buttons.size(); ++i)
+    {
+        buttons_values[m_buttons_contributions.outputs[i]] += m_buttons_contributions.signs[i] * static_cast<double>(m_levels[m_buttons_contributions.buttons[i]]);
+    }
+    for (double& value : buttons_values)
+    {
+        value = value > 0 ? 1.0 : 0.0;
+    }
+}
+
+bool MappingTable::isHighlighted(uint32_t button) const
+{
+    return m_active[button] || m_value_from_joypad_axes[button] > 0;
+}
+
+uint64_t MappingTable::presses(uint32_t button) const
+{
+    return m_presses[button];
+}
+
+uint64_t MappingTable::releases(uint32_t button) const
+{
+    return m_releases[button];
+}
+
+bool MappingTable::isGuiClicked(uint32_t button) const
+{
+    return m_gui_clicked[button];
+}
+
+bool MappingTable::isGuiKeptPressed(uint32_t button) const
+{
+    return m_gui_kept_pressed[button];
+}
+
+void MappingTable::markGuiClicked(uint32_t button)
+{
+    m_gui_clicked[button] = true;
+}
+
+void MappingTable::setGuiKeptPressed(uint32_t button, bool kept_pressed)
+{
+    m_gui_kept_pressed[button] = kept_pressed;
+}
+
+void MappingTable::clearGuiEvents()
+{
+    std::fill(m_gui_clicked.begin(), m_gui_clicked.end(), uint8_t{ 0 });
+    std::fill(m_gui_kept_pressed.begin(), m_gui_kept_pressed.end(), uint8_t{ 0 });
+}
+
+void JoypadPassthrough::configure(const std::vector<uint32_t>& joypad_axes, size_t axes_offset,
+                                  const std::vector<uint32_t>& joypad_buttons, size_t buttons_offset,
+                                  const std::vector<uint32_t>& joypad_hats)
+{
+    m_axes = joypad_axes;
+    m_buttons = joypad_buttons;
+    m_hats = joypad_hats;
+    m_axes_offset = axes_offset;
+    m_buttons_offset = buttons_offset;
+}
+
+size_t JoypadPassthrough::numberOfAxes() const
+{
+    return m_axes.size();
+}
+
+size_t JoypadPassthrough::numberOfButtons() const
+{
+    return m_buttons.size();
+}
+
+size_t JoypadPassthrough::numberOfHats() const
+{
+    return m_hats.size();
+}
+
+void JoypadPassthrough::checkJoypadInputs(size_t number_of_joypad_axes, size_t number_of_joypad_buttons, size_t number_of_joypad_hats) const
+{
+    for (uint32_t joypad_axis : m_axes)
+    {
+        if (joypad_axis >= number_of_joypad_axes)
+        {
+            yCWarning(KEYBOARDJOYPAD) << "The passthrough joypad axis" << joypad_axis << "is not available. Its output will be zero.";
+        }
+    }
+    for (uint32_t joypad_button : m_buttons)
+    {
+        if (joypad_button >= number_of_joypad_buttons)
+        {
+            yCWarning(KEYBOARDJOYPAD) << "The passthrough joypad button" << joypad_button << "is not available. Its output will be zero.";
+        }
+    }
+    for (uint32_t joypad_hat : m_hats)
+    {
+        if (joypad_hat >= number_of_joypad_hats)
+        {
+            yCWarning(KEYBOARDJOYPAD) << "The passthrough joypad hat" << joypad_hat << "is not available. Its output will be centered.";
+        }
+    }
+}
+
+void JoypadPassthrough::apply(const std::vector<float>& joypad_axis_values, const std::vector<bool>& joypad_button_values,
+                              const std::vector<unsigned char>& joypad_hat_values, std::vector<double>& axes_values,
+                              std::vector<double>& buttons_values, std::vector<unsigned char>& hat_values) const
+{
+    const size_t number_of_joypad_axes = joypad_axis_values.size();
+    for (size_t i = 0; i < m_axes.size(); ++i)
+    {
+        axes_values[m_axes_offset + i] = m_axes[i] < number_of_joypad_axes ? joypad_axis_values[m_axes[i]] : 0.0;
+    }
+
+    const size_t number_of_joypad_buttons = joypad_button_values.size();
+    for (size_t i = 0; i < m_buttons.size(); ++i)
+    {
+        buttons_values[m_buttons_offset + i] = m_buttons[i] < number_of_joypad_buttons && joypad_button_values[m_buttons[i]] ? 1.0 : 0.0;
+    }
+
+    const size_t number_of_joypad_hats = joypad_hat_values.size();
+    for (size_t i = 0; i < m_hats.size(); ++i)
+    {
+        hat_values[i] = m_hats[i] < number_of_joypad_hats ? joypad_hat_values[m_hats[i]] : 0;
+    }
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_KEYBOARDJOYPADMAPPING_H
+#define YARP_DEV_KEYBOARDJOYPADMAPPING_H
+
+#include <KeyboardJoypadInputBackends.h>
+
+#include <cstdint>
+#include <vector>
+
+enum class ButtonType
+{
+    REGULAR,
+    TOGGLE,
+};
+
+enum class MappingOutput
+{
+    AXES,
+    BUTTONS,
+};
+
+/**
+ * Mapping from the raw inputs to the outputs, compiled from the configuration when opening the device.
+ *
+ * The buttons are identified by their index, and the mapping is stored in flat structure-of-arrays tables:
+ * - the inputs (keys, joypad buttons and joypad axes), each with the index of the button it drives;
+ * - the state of the buttons;
+ * - the contributions of the buttons to the outputs, each with the index of the output and its sign.
+ * The evaluation is a sequence of tight loops over these tables, while the GUI only reads and writes the state.
+ */
+class MappingTable
+{
+    struct Contributions
+    {
+        std::vector<uint32_t> buttons;
+        std::vector<uint32_t> outputs;
+        std::vector<double> signs;
+    };
+
+    // Inputs
+    std::vector<ImGuiKey> m_keys;
+    std::vector<uint32_t> m_keys_buttons;
+    std::vector<uint32_t> m_joypad_buttons;
+    std::vector<uint32_t> m_joypad_buttons_buttons;
+    std::vector<uint32_t> m_joypad_axes;
+    std::vector<float> m_joypad_axes_signs;
+    std::vector<uint32_t> m_joypad_axes_buttons;
+
+    // State of the buttons. Bytes are used in place of bools to avoid the packed std::vector<bool>.
+    std::vector<uint8_t> m_toggle;
+    std::vector<uint8_t> m_holdable; //The hold button changes the behavior of the button
+    std::vector<uint8_t> m_any_pressed; //Scratch, recomputed at every evaluation
+    std::vector<uint8_t> m_any_released; //Scratch, recomputed at every evaluation
+    std::vector<uint8_t> m_pressed;
+    std::vector<uint8_t> m_active;
+    std::vector<uint8_t> m_gui_clicked; //The button in the GUI has been clicked since the last evaluation
+    std::vector<uint8_t> m_gui_kept_pressed; //The button in the GUI was kept pressed in the last rendered frame
+    std::vector<float> m_value_from_joypad_axes;
+    std::vector<float> m_levels; //Value of each button, contributed to the outputs
+    std::vector<uint64_t> m_presses; //Number of times the inputs of each button have been pressed
+    std::vector<uint64_t> m_releases;
+
+    // Outputs
+    Contributions m_axes_contributions;
+    Contributions m_buttons_contributions;
+    int64_t m_hold_button{ -1 };
+
+    void updateButton(size_t button, bool hold_active);
+
+public:
+    // Adds a button without inputs nor outputs, and returns its index. Only the holdable buttons are affected
+    // by the hold button, e.g. not the ones of the sticks, that have to return to zero when released.
+    uint32_t addButton(ButtonType type, bool holdable);
+
+    void addKey(uint32_t button, ImGuiKey key);
+
+    // Negative indices are ignored
+    void addJoypadButton(uint32_t button, int joypad_button);
+
+    // Negative indices are ignored
+    void addJoypadAxis(uint32_t button, int joypad_axis, int sign);
+
+    void addOutput(uint32_t button, MappingOutput output, size_t index, int sign);
+
+    // While the hold button is active, pressing a regular holdable button toggles it
+    void setHoldButton(uint32_t button);
+
+    // Logs the joypad inputs that are not available. They are ignored in the evaluation.
+    void checkJoypadInputs(size_t number_of_joypad_axes, size_t number_of_joypad_buttons) const;
+
+    size_t size() const;
+
+    // Updates the state of the buttons and computes the outputs, clamping the axes in [-1, 1] and the buttons to 0 or 1
+    void evaluate(const KeyboardState& keyboard, float deadzone,
+                  const std::vector<float>& joypad_axis_values, const std::vector<bool>& joypad_button_values,
+                  std::vector<double>& axes_values, std::vector<double>& buttons_values);
+
+    // Whether the button is shown as active, including the values from the joypad axes
+    bool isHighlighted(uint32_t button) const;
+
+    // Number of times the button has been pressed and released through its keys and joypad buttons,
+    // including the taps shorter than the sampling period.
+    uint64_t presses(uint32_t button) const;
+
+    uint64_t releases(uint32_t button) const;
+
+    bool isGuiClicked(uint32_t button) const;
+
+    bool isGuiKeptPressed(uint32_t button) const;
+
+    void markGuiClicked(uint32_t button);
+
+    void setGuiKeptPressed(uint32_t button, bool kept_pressed);
+
+    void clearGuiEvents();
+};
+
+/**
+ * Copy of selected raw joypad axes, buttons and hats to outputs appended after the mapped ones.
+ * The values bypass the buttons, the deadzone and the axes pipeline, hence the axes keep their full resolution.
+ * The joypad inputs that are not available give zero.
+ */
+class JoypadPassthrough
+{
+    std::vector<uint32_t> m_axes;
+    std::vector<uint32_t> m_buttons;
+    std::vector<uint32_t> m_hats;
+    size_t m_axes_offset{ 0 };
+    size_t m_buttons_offset{ 0 };
+
+public:
+    // The offsets are the indices of the first passthrough output, i.e. the number of mapped outputs
+    void configure(const std::vector<uint32_t>& joypad_axes, size_t axes_offset,
+                   const std::vector<uint32_t>& joypad_buttons, size_t buttons_offset,
+                   const std::vector<uint32_t>& joypad_hats);
+
+    size_t numberOfAxes() const;
+
+    size_t numberOfButtons() const;
+
+    size_t numberOfHats() const;
+
+    // Logs the joypad inputs that are not available
+    void checkJoypadInputs(size_t number_of_joypad_axes, size_t number_of_joypad_buttons, size_t number_of_joypad_hats) const;
+
+    void apply(const std::vector<float>& joypad_axis_values, const std::vector<bool>& joypad_button_values,
+               const std::vector<unsigned char>& joypad_hat_values, std::vector<double>& axes_values,
+               std::vector<double>& buttons_values, std::vector<unsigned char>& hat_values) const;
+};
+
+#endif // YARP_DEV_KEYBOARDJOYPADMAPPING_H
@@ -0,0 +1,576 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Time.h>
+
+#include <KeyboardJoypadRecording.h>
+#include <KeyboardJoypadLogComponent.h>
+
+static constexpr char recordingMagic[8] = "KBJPREC";
+static constexpr uint32_t recordingVersion = 1;
+
+// Size of the fixed fields of a frame: size, timestamp, deadzone, number of key edges and number of GUI events
+static constexpr size_t frameFixedSize = sizeof(uint32_t) + sizeof(double) + sizeof(float) + 2 * sizeof(uint16_t);
+static constexpr size_t keyEdgeSize = sizeof(uint16_t) + sizeof(uint8_t);
+static constexpr size_t guiEventSize = sizeof(uint32_t) + sizeof(uint8_t);
+
+template <typename T>
+static void appendValue(std::vector<char>& buffer, const T& value)
+{
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+// The frames are not aligned, hence the values are copied out of the mapped memory
+template <typename T>
+static T readValue(const unsigned char* data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+InputRecorder::~InputRecorder()
+{
+    close();
+}
+
+bool InputRecorder::open(const std::string& path, const RecordingHeader& header)
+{
+    close();
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file)
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to open the recording file" << path << ":" << std::strerror(errno);
+        return false;
+    }
+
+    // Large buffer, so that the frames reach the disk in big chunks
+    std::setvbuf(m_file, nullptr, _IOFBF, 1 << 20);
+
+    m_header = header;
+    std::memcpy(m_header.magic, recordingMagic, sizeof(m_header.magic));
+    m_header.version = recordingVersion;
+    m_header.reserved = 0;
+
+    if (std::fwrite(&m_header, sizeof(m_header), 1, m_file) != 1)
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to write the header of the recording file" << path;
+        close();
+        return false;
+    }
+
+    yCInfo(KEYBOARDJOYPAD) << "Recording the inputs to" << path;
+    return true;
+}
+
+bool InputRecorder::isOpen() const
+{
+    return m_file != nullptr;
+}
+
+void InputRecorder::beginFrame(double timestamp, float deadzone)
+{
+    m_timestamp = timestamp;
+    m_deadzone = deadzone;
+    m_key_edges.clear();
+    m_gui_events.clear();
+    m_number_of_key_edges = 0;
+    m_number_of_gui_events = 0;
+}
+
+void InputRecorder::addKeyEdges(const KeyboardState& keyboard)
+{
+    for (size_t i = 0; i < keyboard.keys.size(); ++i)
+    {
+        const KeyboardState::KeyState& state = keyboard.keys[i];
+        if (!state.pressed && !state.released)
+        {
+            continue;
+        }
+        uint8_t flags = (state.pressed ? RecordedKeyPressed : 0) | (state.released ? RecordedKeyReleased : 0);
+        appendValue(m_key_edges, static_cast<uint16_t>(ImGuiKey_NamedKey_BEGIN + i));
+        appendValue(m_key_edges, flags);
+        m_number_of_key_edges++;
+    }
+}
+
+void InputRecorder::addGuiEvent(uint32_t button_id, bool clicked, bool kept_pressed)
+{
+    uint8_t flags = (clicked ? RecordedGuiClicked : 0) | (kept_pressed ? RecordedGuiKeptPressed : 0);
+    appendValue(m_gui_events, button_id);
+    appendValue(m_gui_events, flags);
+    m_number_of_gui_events++;
+}
+
+void InputRecorder::endFrame(const std::vector<float>& joypad_axis_values, const std::vector<bool>& joypad_button_values,
+                             const std::vector<double>& axes_values, const std::vector<double>& buttons_values,
+                             const std::vector<std::vector<double>>& sticks_values)
+{
+    if (!m_file)
+    {
+        return;
+    }
+
+    m_frame.clear();
+    appendValue(m_frame, uint32_t{ 0 }); //Filled at the end
+    appendValue(m_frame, m_timestamp);
+    appendValue(m_frame, m_deadzone);
+    appendValue(m_frame, m_number_of_key_edges);
+    m_frame.insert(m_frame.end(), m_key_edges.begin(), m_key_edges.end());
+    appendValue(m_frame, m_number_of_gui_events);
+    m_frame.insert(m_frame.end(), m_gui_events.begin(), m_gui_events.end());
+
+    for (size_t i = 0; i < m_header.joypad_axes; ++i)
+    {
+        appendValue(m_frame, i < joypad_axis_values.size() ? joypad_axis_values[i] : 0.0f);
+    }
+    for (size_t i = 0; i < m_header.joypad_buttons; ++i)
+    {
+        appendValue(m_frame, static_cast<uint8_t>(i < joypad_button_values.size() && joypad_button_values[i]));
+    }
+    for (size_t i = 0; i < m_header.axes; ++i)
+    {
+        appendValue(m_frame, i < axes_values.size() ? axes_values[i] : 0.0);
+    }
+    for (size_t i = 0; i < m_header.buttons; ++i)
+    {
+        appendValue(m_frame, i < buttons_values.size() ? buttons_values[i] : 0.0);
+    }
+    size_t written_sticks_values = 0;
+    for (const auto& stick : sticks_values)
+    {
+        for (size_t j = 0; j < stick.size() && written_sticks_values < m_header.sticks_values; ++j, ++written_sticks_values)
+        {
+            appendValue(m_frame, stick[j]);
+        }
+    }
+    for (; written_sticks_values < m_header.sticks_values; ++written_sticks_values)
+    {
+        appendValue(m_frame, 0.0);
+    }
+
+    uint32_t frame_size = static_cast<uint32_t>(m_frame.size());
+    std::memcpy(m_frame.data(), &frame_size, sizeof(frame_size));
+
+    if (std::fwrite(m_frame.data(), m_frame.size(), 1, m_file) != 1)
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to write to the recording file. The recording is stopped.";
+        close();
+    }
+}
+
+void InputRecorder::close()
+{
+    if (m_file)
+    {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+ImGuiKey RecordingReader::Frame::keyEdge(size_t i, uint8_t& flags) const
+{
+    const unsigned char* edge = key_edges + i * keyEdgeSize;
+    flags = edge[sizeof(uint16_t)];
+    return static_cast<ImGuiKey>(readValue<uint16_t>(edge));
+}
+
+uint32_t RecordingReader::Frame::guiEvent(size_t i, uint8_t& flags) const
+{
+    const unsigned char* event = gui_events + i * guiEventSize;
+    flags = event[sizeof(uint32_t)];
+    return readValue<uint32_t>(event);
+}
+
+float RecordingReader::Frame::joypadAxis(size_t i) const
+{
+    return readValue<float>(joypad_axes + i * sizeof(float));
+}
+
+bool RecordingReader::Frame::joypadButton(size_t i) const
+{
+    return joypad_buttons[i] != 0;
+}
+
+double RecordingReader::Frame::output(size_t i) const
+{
+    return readValue<double>(outputs + i * sizeof(double));
+}
+
+RecordingReader::~RecordingReader()
+{
+    close();
+}
+
+bool RecordingReader::open(const std::string& path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to open the recording file" << path;
+        return false;
+    }
+    m_file = file;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || static_cast<size_t>(file_size.QuadPart) < sizeof(RecordingHeader))
+    {
+        yCError(KEYBOARDJOYPAD) << "The recording file" << path << "is not valid.";
+        close();
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to map the recording file" << path;
+        close();
+        return false;
+    }
+    m_mapping = mapping;
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to map the recording file" << path;
+        close();
+        return false;
+    }
+    m_data = static_cast<const unsigned char*>(data);
+    m_size = static_cast<size_t>(file_size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to open the recording file" << path << ":" << std::strerror(errno);
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(RecordingHeader))
+    {
+        yCError(KEYBOARDJOYPAD) << "The recording file" << path << "is not valid.";
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); //The mapping stays valid after closing the file descriptor
+    if (data == MAP_FAILED)
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to map the recording file" << path << ":" << std::strerror(errno);
+        return false;
+    }
+    // The frames are read once, in order
+    madvise(data, static_cast<size_t>(file_stat.st_size), MADV_SEQUENTIAL);
+    m_data = static_cast<const unsigned char*>(data);
+    m_size = static_cast<size_t>(file_stat.st_size);
+#endif
+
+    std::memcpy(&m_header, m_data, sizeof(m_header));
+    if (std::memcmp(m_header.magic, recordingMagic, sizeof(m_header.magic)) != 0 || m_header.version != recordingVersion)
+    {
+        yCError(KEYBOARDJOYPAD) << "The file" << path << "is not a recording, or it has been made with an incompatible version.";
+        close();
+        return false;
+    }
+    m_offset = sizeof(RecordingHeader);
+
+    return true;
+}
+
+const RecordingHeader& RecordingReader::header() const
+{
+    return m_header;
+}
+
+bool RecordingReader::parse(size_t offset, Frame& frame, size_t& frame_size) const
+{
+    if (!m_data || offset + frameFixedSize > m_size)
+    {
+        return false;
+    }
+
+    frame_size = readValue<uint32_t>(m_data + offset);
+    if (frame_size < frameFixedSize || frame_size > m_size - offset)
+    {
+        // Truncated frame, e.g. if the recording process has been killed
+        return false;
+    }
+
+    const unsigned char* data = m_data + offset + sizeof(uint32_t);
+    const unsigned char* end = m_data + offset + frame_size;
+
+    frame.timestamp = readValue<double>(data);
+    data += sizeof(double);
+    frame.deadzone = readValue<float>(data);
+    data += sizeof(float);
+
+    frame.number_of_key_edges = readValue<uint16_t>(data);
+    data += sizeof(uint16_t);
+    frame.key_edges = data;
+    data += frame.number_of_key_edges * keyEdgeSize;
+    if (data + sizeof(uint16_t) > end)
+    {
+        return false;
+    }
+
+    frame.number_of_gui_events = readValue<uint16_t>(data);
+    data += sizeof(uint16_t);
+    frame.gui_events = data;
+    data += frame.number_of_gui_events * guiEventSize;
+
+    frame.joypad_axes = data;
+    data += m_header.joypad_axes * sizeof(float);
+    frame.joypad_buttons = data;
+    data += m_header.joypad_buttons;
+    frame.outputs = data;
+    data += (static_cast<size_t>(m_header.axes) + m_header.buttons + m_header.sticks_values) * sizeof(double);
+
+    return data == end;
+}
+
+bool RecordingReader::next(Frame& frame)
+{
+    size_t frame_size = 0;
+    if (!parse(m_offset, frame, frame_size))
+    {
+        return false;
+    }
+    m_offset += frame_size;
+    return true;
+}
+
+bool RecordingReader::peekTimestamp(double& timestamp) const
+{
+    Frame frame;
+    size_t frame_size = 0;
+    if (!parse(m_offset, frame, frame_size))
+    {
+        return false;
+    }
+    timestamp = frame.timestamp;
+    return true;
+}
+
+void RecordingReader::close()
+{
+#ifdef _WIN32
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping)
+    {
+        CloseHandle(static_cast<HANDLE>(m_mapping));
+        m_mapping = nullptr;
+    }
+    if (m_file)
+    {
+        CloseHandle(static_cast<HANDLE>(m_file));
+        m_file = nullptr;
+    }
+#else
+    if (m_data)
+    {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+    m_offset = 0;
+}
+
+ReplayInputBackend::ReplayInputBackend(const std::string& path, double speed)
+    : m_path(path),
+      m_speed(speed)
+{
+}
+
+bool ReplayInputBackend::isNextFrameDue() const
+{
+    double timestamp = 0;
+    if (!m_reader.peekTimestamp(timestamp))
+    {
+        return false;
+    }
+    if (m_speed <= 0 || m_start_time < 0)
+    {
+        return true;
+    }
+    return (timestamp - m_first_timestamp) / m_speed <= yarp::os::Time::now() - m_start_time;
+}
+
+const RecordingHeader& ReplayInputBackend::header() const
+{
+    return m_reader.header();
+}
+
+const RecordingReader::Frame& ReplayInputBackend::currentFrame() const
+{
+    return m_frame;
+}
+
+void ReplayInputBackend::setCompareOutputs(bool compare)
+{
+    m_compare_outputs = compare;
+}
+
+void ReplayInputBackend::compareOutputs(const std::vector<double>& axes_values, const std::vector<double>& buttons_values,
+                                        const std::vector<std::vector<double>>& sticks_values)
+{
+    if (!m_compare_outputs)
+    {
+        return;
+    }
+
+    constexpr double tolerance = 1e-9;
+    size_t offset = 0;
+    bool mismatch = false;
+    for (size_t i = 0; i < axes_values.size() && !mismatch; ++i)
+    {
+        mismatch = std::abs(axes_values[i] - m_frame.output(offset + i)) > tolerance;
+    }
+    offset += axes_values.size();
+    for (size_t i = 0; i < buttons_values.size() && !mismatch; ++i)
+    {
+        mismatch = std::abs(buttons_values[i] - m_frame.output(offset + i)) > tolerance;
+    }
+    offset += buttons_values.size();
+    for (const auto& stick : sticks_values)
+    {
+        for (size_t j = 0; j < stick.size() && !mismatch; ++j)
+        {
+            mismatch = std::abs(stick[j] - m_frame.output(offset + j)) > tolerance;
+        }
+        offset += stick.size();
+    }
+
+    if (mismatch)
+    {
+        if (m_mismatching_frames == 0)
+        {
+            yCWarning(KEYBOARDJOYPAD) << "The outputs of the frame" << m_replayed_frames << "(timestamp" << m_frame.timestamp
+                                      << ") differ from the recorded ones.";
+        }
+        m_mismatching_frames++;
+    }
+}
+
+bool ReplayInputBackend::initialize(std::vector<JoypadInfo>& available_joypads)
+{
+    if (!m_reader.open(m_path))
+    {
+        return false;
+    }
+
+    const RecordingHeader& header = m_reader.header();
+    available_joypads.push_back({ .name = "Replayed joypad", .index = 0,
+                                  .axes = static_cast<int>(header.joypad_axes), .buttons = static_cast<int>(header.joypad_buttons) });
+
+    if (m_speed > 0)
+    {
+        yCInfo(KEYBOARDJOYPAD) << "Replaying" << m_path << "at" << m_speed << "times the original speed.";
+    }
+    else
+    {
+        yCInfo(KEYBOARDJOYPAD) << "Replaying" << m_path << "one frame per input sample.";
+    }
+    return true;
+}
+
+bool ReplayInputBackend::sample(KeyboardState& keyboard, const std::vector<JoypadInfo>& joypads,
+                                std::vector<float>& joypad_axis_values, std::vector<bool>& joypad_button_values)
+{
+    if (m_start_time < 0)
+    {
+        m_start_time = yarp::os::Time::now();
+        m_reader.peekTimestamp(m_first_timestamp);
+    }
+
+    if (!isNextFrameDue())
+    {
+        double timestamp = 0;
+        if (!m_completed && !m_reader.peekTimestamp(timestamp))
+        {
+            m_completed = true;
+            yCInfo(KEYBOARDJOYPAD) << "Replay completed:" << m_replayed_frames << "frames replayed,"
+                                   << m_mismatching_frames << "with outputs different from the recorded ones.";
+        }
+        return false;
+    }
+
+    m_reader.next(m_frame);
+    m_replayed_frames++;
+
+    for (size_t i = 0; i < m_frame.number_of_key_edges; ++i)
+    {
+        uint8_t flags = 0;
+        ImGuiKey key = m_frame.keyEdge(i, flags);
+        keyboard.setEdges(key, flags & RecordedKeyPressed, flags & RecordedKeyReleased);
+    }
+
+    const RecordingHeader& header = m_reader.header();
+    for (auto& joypad : joypads)
+    {
+        if (!joypad.active)
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < std::min(static_cast<size_t>(joypad.axes), static_cast<size_t>(header.joypad_axes)); ++i)
+        {
+            joypad_axis_values[joypad.axes_offset + i] = m_frame.joypadAxis(i);
+        }
+
+        for (size_t i = 0; i < std::min(static_cast<size_t>(joypad.buttons), static_cast<size_t>(header.joypad_buttons)); ++i)
+        {
+            joypad_button_values[joypad.buttons_offset + i] = m_frame.joypadButton(i);
+        }
+    }
+
+    return true;
+}
+
+bool ReplayInputBackend::samplePending() const
+{
+    // With speed 0 a single frame is replayed per sample, otherwise all the frames that are due
+    return m_speed > 0 && isNextFrameDue();
+}
+
+void ReplayInputBackend::close()
+{
+    m_reader.close();
+}
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_KEYBOARDJOYPADRECORDING_H
+#define YARP_DEV_KEYBOARDJOYPADRECORDING_H
+
+#include <KeyboardJoypadInputBackends.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Layout of the recordings. All the values are stored in the native byte order.
+ *
+ * The file starts with a RecordingHeader, followed by one frame per input sample:
+ * - uint32 size of the frame in bytes, including this field
+ * - float64 timestamp in seconds
+ * - float32 deadzone used for the joypad axes
+ * - uint16 number of key edges, then for each edge: uint16 ImGuiKey, uint8 flags (1 = pressed, 2 = released)
+ * - uint16 number of GUI button events, then for each event: uint32 button id, uint8 flags (1 = clicked, 2 = kept pressed)
+ * - float32 joypad axes values [header.joypad_axes]
+ * - uint8 joypad buttons values [header.joypad_buttons]
+ * - float64 output axes [header.axes], buttons [header.buttons] and sticks values [header.sticks_values]
+ *
+ * The frames are only appended, so a recording interrupted abruptly can be replayed up to the last complete frame.
+ */
+struct RecordingHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t joypad_axes;
+    uint32_t joypad_buttons;
+    uint32_t axes;
+    uint32_t buttons;
+    uint32_t sticks_values;
+    uint32_t gui_buttons;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(RecordingHeader) == 40, "The recording header is not expected to have padding");
+
+constexpr uint8_t RecordedKeyPressed = 1;
+constexpr uint8_t RecordedKeyReleased = 2;
+constexpr uint8_t RecordedGuiClicked = 1;
+constexpr uint8_t RecordedGuiKeptPressed = 2;
+
+/**
+ * Appends the frames to a recording file. The frame is serialized in a reused buffer and written with a single call,
+ * so that recording does not allocate memory once the buffers reached their steady state size.
+ */
+class InputRecorder
+{
+    FILE* m_file{ nullptr };
+    RecordingHeader m_header{};
+    std::vector<char> m_frame;
+    std::vector<char> m_key_edges;
+    std::vector<char> m_gui_events;
+    uint16_t m_number_of_key_edges{ 0 };
+    uint16_t m_number_of_gui_events{ 0 };
+    double m_timestamp{ 0 };
+    float m_deadzone{ 0 };
+
+public:
+    ~InputRecorder();
+
+    bool open(const std::string& path, const RecordingHeader& header);
+
+    bool isOpen() const;
+
+    void beginFrame(double timestamp, float deadzone);
+
+    void addKeyEdges(const KeyboardState& keyboard);
+
+    void addGuiEvent(uint32_t button_id, bool clicked, bool kept_pressed);
+
+    void endFrame(const std::vector<float>& joypad_axis_values, const std::vector<bool>& joypad_button_values,
+                  const std::vector<double>& axes_values, const std::vector<double>& buttons_values,
+                  const std::vector<std::vector<double>>& sticks_values);
+
+    void close();
+};
+
+/**
+ * Reads a recording memory mapped, one frame at a time, so that long recordings are not loaded in memory.
+ */
+class RecordingReader
+{
+public:
+    struct Frame
+    {
+        double timestamp{ 0 };
+        float deadzone{ 0 };
+        uint16_t number_of_key_edges{ 0 };
+        uint16_t number_of_gui_events{ 0 };
+        const unsigned char* key_edges{ nullptr };
+        const unsigned char* gui_events{ nullptr };
+        const unsigned char* joypad_axes{ nullptr };
+        const unsigned char* joypad_buttons{ nullptr };
+        const unsigned char* outputs{ nullptr };
+
+        ImGuiKey keyEdge(size_t i, uint8_t& flags) const;
+
+        uint32_t guiEvent(size_t i, uint8_t& flags) const;
+
+        float joypadAxis(size_t i) const;
+
+        bool joypadButton(size_t i) const;
+
+        // The outputs are stored contiguously: axes, then buttons, then sticks values
+        double output(size_t i) const;
+    };
+
+private:
+    const unsigned char* m_data{ nullptr };
+    size_t m_size{ 0 };
+    size_t m_offset{ 0 };
+    RecordingHeader m_header{};
+#ifdef _WIN32
+    void* m_file{ nullptr };
+    void* m_mapping{ nullptr };
+#endif
+
+    bool parse(size_t offset, Frame& frame, size_t& frame_size) const;
+
+public:
+    ~RecordingReader();
+
+    bool open(const std::string& path);
+
+    const RecordingHeader& header() const;
+
+    // Reads the frame at the current position and moves to the next one. Returns false at the end of the recording.
+    bool next(Frame& frame);
+
+    // Timestamp of the frame at the current position, without moving to the next one.
+    bool peekTimestamp(double& timestamp) const;
+
+    void close();
+};
+
+/**
+ * Feeds a recording back as raw inputs. With a speed of 1, the frames are replayed with the original timing,
+ * a higher speed replays them faster, while a speed of 0 replays one frame per sample, as fast as possible.
+ * The recorded outputs are compared with the ones obtained from the current mapping.
+ */
+class ReplayInputBackend : public InputBackend
+{
+    std::string m_path;
+    double m_speed;
+    RecordingReader m_reader;
+    RecordingReader::Frame m_frame;
+    double m_start_time{ -1.0 };
+    double m_first_timestamp{ 0.0 };
+    size_t m_replayed_frames{ 0 };
+    size_t m_mismatching_frames{ 0 };
+    bool m_compare_outputs{ false };
+    bool m_completed{ false };
+
+    bool isNextFrameDue() const;
+
+public:
+    ReplayInputBackend(const std::string& path, double speed);
+
+    const RecordingHeader& header() const;
+
+    // Frame applied in the last sample
+    const RecordingReader::Frame& currentFrame() const;
+
+    // Enables the comparison of the outputs, only meaningful if the output sizes match the recording
+    void setCompareOutputs(bool compare);
+
+    void compareOutputs(const std::vector<double>& axes_values, const std::vector<double>& buttons_values,
+                        const std::vector<std::vector<double>>& sticks_values);
+
+    bool initialize(std::vector<JoypadInfo>& available_joypads) override;
+
+    bool sample(KeyboardState& keyboard, const std::vector<JoypadInfo>& joypads,
+                std::vector<float>& joypad_axis_values, std::vector<bool>& joypad_button_values) override;
+
+    bool samplePending() const override;
+
+    void close() override;
+};
+
+#endif // YARP_DEV_KEYBOARDJOYPADRECORDING_H
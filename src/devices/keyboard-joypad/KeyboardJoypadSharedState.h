@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_KEYBOARDJOYPADSHAREDSTATE_H
+#define YARP_DEV_KEYBOARDJOYPADSHAREDSTATE_H
+
+/**
+ * Layout of the shared memory segment written by the keyboard-joypad device when "shared_memory_name" is set,
+ * and a header-only reader for the consumers running on the same host. This file depends only on the standard
+ * library and POSIX, so that it can be copied in the consumers.
+ *
+ * The segment contains a header followed by a ring of "capacity" slots. The input frame n is written in the slot
+ * n % capacity. Each slot is protected by a sequence: 2 * n + 1 while the frame n is written, 2 * n + 2 once done.
+ * The writer never waits for the readers. A reader detects a frame overwritten while reading from its sequence,
+ * and retries or skips it. After opening, the reader does not perform any system call.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+constexpr uint32_t SharedStateMagic = 0x4B4A5353; //"KJSS"
+constexpr uint32_t SharedStateVersion = 1;
+constexpr size_t SharedStateMaxSticks = 8;
+constexpr size_t SharedStateAlignment = 64; //Cache line
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The shared state requires lock-free atomic integers");
+static_assert(std::atomic<double>::is_always_lock_free, "The shared state requires lock-free atomic doubles");
+
+struct SharedStateHeader
+{
+    std::atomic<uint32_t> magic; //Written last by the writer, once the segment is initialized
+    uint32_t version;
+    uint32_t capacity; //Number of slots
+    uint32_t number_of_axes;
+    uint32_t number_of_buttons;
+    uint32_t number_of_sticks;
+    uint32_t sticks_offsets[SharedStateMaxSticks + 1]; //The values of the stick i are in [sticks_offsets[i], sticks_offsets[i+1])
+    uint64_t slot_size; //In bytes
+    alignas(SharedStateAlignment) std::atomic<uint64_t> written_frames; //Number of frames completely written
+};
+
+/**
+ * Each slot is followed by the axes, the buttons and the sticks values, as atomic doubles.
+ */
+struct SharedStateSlot
+{
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> frame;
+    std::atomic<double> timestamp;
+    std::atomic<uint64_t> reserved;
+
+    std::atomic<double>* values()
+    {
+        return reinterpret_cast<std::atomic<double>*>(this + 1);
+    }
+
+    const std::atomic<double>* values() const
+    {
+        return reinterpret_cast<const std::atomic<double>*>(this + 1);
+    }
+};
+
+inline size_t sharedStateHeaderSize()
+{
+    return (sizeof(SharedStateHeader) + SharedStateAlignment - 1) / SharedStateAlignment * SharedStateAlignment;
+}
+
+inline size_t sharedStateSlotSize(size_t number_of_values)
+{
+    size_t size = sizeof(SharedStateSlot) + number_of_values * sizeof(std::atomic<double>);
+    return (size + SharedStateAlignment - 1) / SharedStateAlignment * SharedStateAlignment;
+}
+
+#ifndef _WIN32
+
+/**
+ * Reader of the shared memory segment. It is meant to be used by a single thread.
+ */
+class SharedStateReader
+{
+public:
+    struct Frame
+    {
+        uint64_t frame{ 0 };
+        double timestamp{ 0.0 };
+        std::vector<double> axes;
+        std::vector<double> buttons;
+        std::vector<double> sticks; //The values of the stick i are in [stickOffset(i), stickOffset(i+1))
+    };
+
+private:
+    void* m_memory{ nullptr };
+    size_t m_size{ 0 };
+    const SharedStateHeader* m_header{ nullptr };
+    const unsigned char* m_slots{ nullptr };
+    uint64_t m_lost_frames{ 0 };
+
+    const SharedStateSlot& slot(uint64_t frame) const
+    {
+        return *reinterpret_cast<const SharedStateSlot*>(m_slots + (frame % m_header->capacity) * m_header->slot_size);
+    }
+
+    // Copies the frame, returns false if it is not in the ring anymore or it has been overwritten while copying
+    bool tryRead(uint64_t frame, Frame& output) const
+    {
+        const SharedStateSlot& s = slot(frame);
+        uint64_t before = s.sequence.load(std::memory_order_acquire);
+        if (before != 2 * frame + 2)
+        {
+            return false;
+        }
+        const std::atomic<double>* values = s.values();
+        size_t offset = 0;
+        for (double& value : output.axes)
+        {
+            value = values[offset++].load(std::memory_order_relaxed);
+        }
+        for (double& value : output.buttons)
+        {
+            value = values[offset++].load(std::memory_order_relaxed);
+        }
+        for (double& value : output.sticks)
+        {
+            value = values[offset++].load(std::memory_order_relaxed);
+        }
+        output.frame = s.frame.load(std::memory_order_relaxed);
+        output.timestamp = s.timestamp.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return s.sequence.load(std::memory_order_relaxed) == before;
+    }
+
+    // Checks that the header describes a layout that fits in the mapped memory, before trusting it
+    bool validHeader() const
+    {
+        if (m_header->magic.load(std::memory_order_acquire) != SharedStateMagic
+            || m_header->version != SharedStateVersion
+            || m_header->capacity == 0
+            || m_header->number_of_sticks > SharedStateMaxSticks
+            || m_header->sticks_offsets[0] != 0)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < m_header->number_of_sticks; ++i)
+        {
+            if (m_header->sticks_offsets[i + 1] < m_header->sticks_offsets[i])
+            {
+                return false;
+            }
+        }
+        // The fields are 32 bits wide, hence their sum does not overflow
+        uint64_t number_of_values = static_cast<uint64_t>(m_header->number_of_axes) + m_header->number_of_buttons
+                                    + m_header->sticks_offsets[m_header->number_of_sticks];
+        if (number_of_values > (SIZE_MAX - sizeof(SharedStateSlot) - SharedStateAlignment) / sizeof(std::atomic<double>)
+            || m_header->slot_size < sharedStateSlotSize(static_cast<size_t>(number_of_values))
+            || m_header->slot_size % alignof(SharedStateSlot) != 0)
+        {
+            return false;
+        }
+        // Division instead of multiplication, so that a corrupted capacity or slot size cannot overflow
+        return m_header->slot_size <= (m_size - sharedStateHeaderSize()) / m_header->capacity;
+    }
+
+public:
+    SharedStateReader() = default;
+    SharedStateReader(const SharedStateReader&) = delete;
+    SharedStateReader& operator=(const SharedStateReader&) = delete;
+
+    ~SharedStateReader()
+    {
+        close();
+    }
+
+    // The name is the one set in "shared_memory_name". Returns false if the segment does not exist or is not ready yet.
+    bool open(const std::string& name)
+    {
+        close();
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sharedStateHeaderSize())
+        {
+            ::close(fd);
+            return false;
+        }
+        m_size = static_cast<size_t>(info.st_size);
+        m_memory = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (m_memory == MAP_FAILED)
+        {
+            m_memory = nullptr;
+            return false;
+        }
+        m_header = static_cast<const SharedStateHeader*>(m_memory);
+        if (!validHeader())
+        {
+            close();
+            return false;
+        }
+        m_slots = static_cast<const unsigned char*>(m_memory) + sharedStateHeaderSize();
+        m_lost_frames = 0;
+        return true;
+    }
+
+    void close()
+    {
+        if (m_memory)
+        {
+            munmap(m_memory, m_size);
+        }
+        m_memory = nullptr;
+        m_header = nullptr;
+        m_slots = nullptr;
+        m_size = 0;
+    }
+
+    bool isOpen() const
+    {
+        return m_header != nullptr;
+    }
+
+    size_t numberOfAxes() const
+    {
+        return m_header->number_of_axes;
+    }
+
+    size_t numberOfButtons() const
+    {
+        return m_header->number_of_buttons;
+    }
+
+    size_t numberOfSticks() const
+    {
+        return m_header->number_of_sticks;
+    }
+
+    size_t stickOffset(size_t stick) const
+    {
+        return m_header->sticks_offsets[stick];
+    }
+
+    // Number of frames written by the device so far
+    uint64_t writtenFrames() const
+    {
+        return m_header->written_frames.load(std::memory_order_acquire);
+    }
+
+    // Frames overwritten by the device before readSince could read them
+    uint64_t lostFrames() const
+    {
+        return m_lost_frames;
+    }
+
+    // Sizes the vectors of a frame, so that the reads do not allocate memory
+    void prepare(Frame& frame) const
+    {
+        frame.axes.resize(m_header->number_of_axes);
+        frame.buttons.resize(m_header->number_of_buttons);
+        frame.sticks.resize(m_header->sticks_offsets[m_header->number_of_sticks]);
+    }
+
+    // Reads the most recent frame. Returns false if no frame has been written yet.
+    bool readLatest(Frame& frame) const
+    {
+        prepare(frame);
+        while (true)
+        {
+            uint64_t written = writtenFrames();
+            if (written == 0)
+            {
+                return false;
+            }
+            if (tryRead(written - 1, frame))
+            {
+                return true;
+            }
+        }
+    }
+
+    // Calls callback(const Frame&) for each frame written from next_frame on, and updates next_frame.
+    // The frames no longer in the ring are skipped, and counted in lostFrames. Returns the number of frames read.
+    template <typename Callback>
+    size_t readSince(uint64_t& next_frame, Frame& frame, Callback&& callback)
+    {
+        prepare(frame);
+        size_t read_frames = 0;
+        uint64_t written = writtenFrames();
+        while (next_frame < written)
+        {
+            uint64_t oldest = written > m_header->capacity ? written - m_header->capacity : 0;
+            if (next_frame < oldest)
+            {
+                m_lost_frames += oldest - next_frame;
+                next_frame = oldest;
+            }
+            if (tryRead(next_frame, frame))
+            {
+                callback(static_cast<const Frame&>(frame));
+                ++read_frames;
+            }
+            else
+            {
+                // Overwritten while reading
+                ++m_lost_frames;
+            }
+            ++next_frame;
+        }
+        return read_frames;
+    }
+};
+
+#endif // _WIN32
+
+#endif // YARP_DEV_KEYBOARDJOYPADSHAREDSTATE_H
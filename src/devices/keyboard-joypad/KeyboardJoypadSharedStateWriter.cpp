@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <yarp/os/LogStream.h>
+
+#include <KeyboardJoypadSharedStateWriter.h>
+#include <KeyboardJoypadLogComponent.h>
+
+SharedStateWriter::~SharedStateWriter()
+{
+    close();
+}
+
+#ifndef _WIN32
+
+bool SharedStateWriter::open(const std::string& name, size_t capacity, size_t number_of_axes, size_t number_of_buttons,
+                             const std::vector<std::vector<double>>& sticks_values)
+{
+    close();
+
+    if (sticks_values.size() > SharedStateMaxSticks)
+    {
+        yCError(KEYBOARDJOYPAD) << "The shared memory supports at most" << SharedStateMaxSticks << "sticks.";
+        return false;
+    }
+
+    size_t number_of_values = number_of_axes + number_of_buttons;
+    for (const auto& stick : sticks_values)
+    {
+        number_of_values += stick.size();
+    }
+    size_t slot_size = sharedStateSlotSize(number_of_values);
+    size_t size = sharedStateHeaderSize() + capacity * slot_size;
+
+    // Remove a stale segment, so that the readers still mapping it do not see it changing layout
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to create the shared memory" << name << ":" << std::strerror(errno);
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to resize the shared memory" << name << ":" << std::strerror(errno);
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to map the shared memory" << name << ":" << std::strerror(errno);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    m_name = name;
+    m_memory = memory;
+    m_size = size;
+    m_slots = static_cast<unsigned char*>(memory) + sharedStateHeaderSize();
+    m_written_frames = 0;
+
+    // The memory is zero initialized by ftruncate, hence the magic is not valid until the end of the initialization
+    m_header = new (memory) SharedStateHeader;
+    m_header->version = SharedStateVersion;
+    m_header->capacity = static_cast<uint32_t>(capacity);
+    m_header->number_of_axes = static_cast<uint32_t>(number_of_axes);
+    m_header->number_of_buttons = static_cast<uint32_t>(number_of_buttons);
+    m_header->number_of_sticks = static_cast<uint32_t>(sticks_values.size());
+    m_header->sticks_offsets[0] = 0;
+    for (size_t i = 0; i < sticks_values.size(); ++i)
+    {
+        m_header->sticks_offsets[i + 1] = m_header->sticks_offsets[i] + static_cast<uint32_t>(sticks_values[i].size());
+    }
+    m_header->slot_size = slot_size;
+    m_header->written_frames.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        SharedStateSlot* slot = new (m_slots + i * slot_size) SharedStateSlot;
+        slot->sequence.store(0, std::memory_order_relaxed);
+        std::atomic<double>* values = slot->values();
+        for (size_t j = 0; j < number_of_values; ++j)
+        {
+            new (values + j) std::atomic<double>(0.0);
+        }
+    }
+    m_header->magic.store(SharedStateMagic, std::memory_order_release);
+
+    yCInfo(KEYBOARDJOYPAD) << "Writing the outputs in the shared memory" << name << "with" << capacity << "frames.";
+    return true;
+}
+
+void SharedStateWriter::close()
+{
+    if (!m_memory)
+    {
+        return;
+    }
+    munmap(m_memory, m_size);
+    shm_unlink(m_name.c_str());
+    m_memory = nullptr;
+    m_header = nullptr;
+    m_slots = nullptr;
+    m_size = 0;
+}
+
+void SharedStateWriter::write(double timestamp, const std::vector<double>& axes_values, const std::vector<double>& buttons_values,
+                              const std::vector<std::vector<double>>& sticks_values)
+{
+    if (!m_header)
+    {
+        return;
+    }
+
+    uint64_t frame = m_written_frames;
+    SharedStateSlot& slot = *reinterpret_cast<SharedStateSlot*>(m_slots + (frame % m_header->capacity) * m_header->slot_size);
+
+    slot.sequence.store(2 * frame + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.frame.store(frame, std::memory_order_relaxed);
+    slot.timestamp.store(timestamp, std::memory_order_relaxed);
+    std::atomic<double>* values = slot.values();
+    size_t offset = 0;
+    for (double value : axes_values)
+    {
+        values[offset++].store(value, std::memory_order_relaxed);
+    }
+    for (double value : buttons_values)
+    {
+        values[offset++].store(value, std::memory_order_relaxed);
+    }
+    for (const auto& stick : sticks_values)
+    {
+        for (double value : stick)
+        {
+            values[offset++].store(value, std::memory_order_relaxed);
+        }
+    }
+
+    slot.sequence.store(2 * frame + 2, std::memory_order_release);
+    m_written_frames = frame + 1;
+    m_header->written_frames.store(m_written_frames, std::memory_order_release);
+}
+
+#else
+
+bool SharedStateWriter::open(const std::string&, size_t, size_t, size_t, const std::vector<std::vector<double>>&)
+{
+    yCError(KEYBOARDJOYPAD) << "The shared memory output is available only on POSIX systems.";
+    return false;
+}
+
+void SharedStateWriter::close()
+{
+}
+
+void SharedStateWriter::write(double, const std::vector<double>&, const std::vector<double>&,
+                              const std::vector<std::vector<double>>&)
+{
+}
+
+#endif // _WIN32
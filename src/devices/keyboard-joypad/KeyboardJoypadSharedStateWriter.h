@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_KEYBOARDJOYPADSHAREDSTATEWRITER_H
+#define YARP_DEV_KEYBOARDJOYPADSHAREDSTATEWRITER_H
+
+#include <KeyboardJoypadSharedState.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Writer of the shared memory segment described in KeyboardJoypadSharedState.h.
+ * It is the only producer, and it is called from the input path after each sample.
+ */
+class SharedStateWriter
+{
+    std::string m_name;
+    void* m_memory{ nullptr };
+    size_t m_size{ 0 };
+    SharedStateHeader* m_header{ nullptr };
+    unsigned char* m_slots{ nullptr };
+    uint64_t m_written_frames{ 0 };
+
+public:
+    SharedStateWriter() = default;
+    SharedStateWriter(const SharedStateWriter&) = delete;
+    SharedStateWriter& operator=(const SharedStateWriter&) = delete;
+
+    ~SharedStateWriter();
+
+    // Creates the segment, replacing an existing one with the same name, e.g. left by a crashed device
+    bool open(const std::string& name, size_t capacity, size_t number_of_axes, size_t number_of_buttons,
+              const std::vector<std::vector<double>>& sticks_values);
+
+    // Unmaps and removes the segment. The readers that have it mapped keep reading the last frames.
+    void close();
+
+    void write(double timestamp, const std::vector<double>& axes_values, const std::vector<double>& buttons_values,
+               const std::vector<std::vector<double>>& sticks_values);
+};
+
+#endif // YARP_DEV_KEYBOARDJOYPADSHAREDSTATEWRITER_H
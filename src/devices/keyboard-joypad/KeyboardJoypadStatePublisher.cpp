@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/LogStream.h>
+
+#include <KeyboardJoypadStatePublisher.h>
+#include <KeyboardJoypadLogComponent.h>
+
+int16_t StateMessage::quantize(double value)
+{
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0, 1.0) * 32767.0));
+}
+
+bool StateMessage::read(yarp::os::ConnectionReader&)
+{
+    return false;
+}
+
+bool StateMessage::write(yarp::os::ConnectionWriter& writer) const
+{
+    auto addValues = [this](yarp::os::Bottle& bottle, const std::vector<double>& values)
+    {
+        for (double value : values)
+        {
+            if (this->quantized)
+            {
+                bottle.addInt16(quantize(value));
+            }
+            else
+            {
+                bottle.addFloat64(value);
+            }
+        }
+    };
+
+    if (writer.isTextMode())
+    {
+        // Only for debugging connections, hence the allocations of the bottle are acceptable
+        yarp::os::Bottle bottle;
+        bottle.addInt64(this->sequence);
+        bottle.addFloat64(this->timestamp);
+        bottle.addInt8(this->keyframe ? 1 : 0);
+        yarp::os::Bottle& axes_ids_list = bottle.addList();
+        for (int32_t id : this->axes_ids)
+        {
+            axes_ids_list.addInt32(id);
+        }
+        addValues(bottle.addList(), this->axes_values);
+        yarp::os::Bottle& buttons_ids_list = bottle.addList();
+        for (int32_t id : this->buttons_ids)
+        {
+            buttons_ids_list.addInt32(id);
+        }
+        addValues(bottle.addList(), this->buttons_values);
+        writer.appendText(bottle.toString());
+        return !writer.isError();
+    }
+
+    // Binary Bottle: the outer list has mixed types, hence a tag for each element,
+    // while the inner lists are homogeneous, hence their tag includes the type of the elements
+    const int32_t value_tag = this->quantized ? BOTTLE_TAG_INT16 : BOTTLE_TAG_FLOAT64;
+    auto writeIds = [&writer](const std::vector<int32_t>& ids)
+    {
+        writer.appendInt32(BOTTLE_TAG_LIST + BOTTLE_TAG_INT32);
+        writer.appendInt32(static_cast<int32_t>(ids.size()));
+        for (int32_t id : ids)
+        {
+            writer.appendInt32(id);
+        }
+    };
+    auto writeValues = [this, &writer, value_tag](const std::vector<double>& values)
+    {
+        writer.appendInt32(BOTTLE_TAG_LIST + value_tag);
+        writer.appendInt32(static_cast<int32_t>(values.size()));
+        for (double value : values)
+        {
+            if (this->quantized)
+            {
+                writer.appendInt16(quantize(value));
+            }
+            else
+            {
+                writer.appendFloat64(value);
+            }
+        }
+    };
+
+    writer.appendInt32(BOTTLE_TAG_LIST);
+    writer.appendInt32(7);
+    writer.appendInt32(BOTTLE_TAG_INT64);
+    writer.appendInt64(this->sequence);
+    writer.appendInt32(BOTTLE_TAG_FLOAT64);
+    writer.appendFloat64(this->timestamp);
+    writer.appendInt32(BOTTLE_TAG_INT8);
+    writer.appendInt8(this->keyframe ? 1 : 0);
+    writeIds(this->axes_ids);
+    writeValues(this->axes_values);
+    writeIds(this->buttons_ids);
+    writeValues(this->buttons_values);
+    return !writer.isError();
+}
+
+StatePublisher::StatePublisher(double keyframe_period, bool quantize)
+    : m_keyframe_period(keyframe_period),
+      m_quantize(quantize)
+{
+}
+
+double StatePublisher::sentValue(double value) const
+{
+    return m_quantize ? StateMessage::quantize(value) / 32767.0 : value;
+}
+
+bool StatePublisher::open(const std::string& port_name, size_t number_of_axes, size_t number_of_buttons)
+{
+    if (!m_port.open(port_name))
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to open the port" << port_name;
+        return false;
+    }
+
+    m_sent_axes.assign(number_of_axes, 0.0);
+    m_sent_buttons.assign(number_of_buttons, 0.0);
+    m_last_keyframe_time = -1.0;
+    m_sequence = 0;
+
+    yCInfo(KEYBOARDJOYPAD) << "Publishing the changes of the outputs on" << port_name
+                           << "with a keyframe every" << m_keyframe_period << "seconds.";
+    return true;
+}
+
+void StatePublisher::close()
+{
+    m_port.close();
+}
+
+void StatePublisher::publish(double timestamp, const std::vector<double>& axes_values, const std::vector<double>& buttons_values)
+{
+    bool keyframe = m_last_keyframe_time < 0 || timestamp - m_last_keyframe_time >= m_keyframe_period;
+
+    bool changed = keyframe;
+    for (size_t i = 0; i < axes_values.size() && !changed; ++i)
+    {
+        changed = sentValue(axes_values[i]) != m_sent_axes[i];
+    }
+    for (size_t i = 0; i < buttons_values.size() && !changed; ++i)
+    {
+        changed = sentValue(buttons_values[i]) != m_sent_buttons[i];
+    }
+    if (!changed)
+    {
+        return;
+    }
+
+    StateMessage& message = m_port.prepare();
+    message.sequence = m_sequence++;
+    message.timestamp = timestamp;
+    message.keyframe = keyframe;
+    message.quantized = m_quantize;
+    message.axes_ids.clear();
+    message.axes_values.clear();
+    message.buttons_ids.clear();
+    message.buttons_values.clear();
+
+    for (size_t i = 0; i < axes_values.size(); ++i)
+    {
+        double value = sentValue(axes_values[i]);
+        if (keyframe || value != m_sent_axes[i])
+        {
+            message.axes_ids.push_back(static_cast<int32_t>(i));
+            message.axes_values.push_back(axes_values[i]);
+            m_sent_axes[i] = value;
+        }
+    }
+    for (size_t i = 0; i < buttons_values.size(); ++i)
+    {
+        double value = sentValue(buttons_values[i]);
+        if (keyframe || value != m_sent_buttons[i])
+        {
+            message.buttons_ids.push_back(static_cast<int32_t>(i));
+            message.buttons_values.push_back(buttons_values[i]);
+            m_sent_buttons[i] = value;
+        }
+    }
+
+    if (keyframe)
+    {
+        m_last_keyframe_time = timestamp;
+    }
+
+    m_stamp.update(timestamp);
+    m_port.setEnvelope(m_stamp);
+    m_port.write();
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_KEYBOARDJOYPADSTATEPUBLISHER_H
+#define YARP_DEV_KEYBOARDJOYPADSTATEPUBLISHER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/ConnectionReader.h>
+#include <yarp/os/ConnectionWriter.h>
+#include <yarp/os/Portable.h>
+#include <yarp/os/Stamp.h>
+
+/**
+ * Message of the state stream. It is serialized with the same wire format of a Bottle, hence clients can read it
+ * as a Bottle, while the writer reuses its vectors and does not allocate memory once they reached their maximum size:
+ *
+ * sequence(int64) timestamp(float64) keyframe(int8) (axes ids (int32)) (axes values) (buttons ids (int32)) (buttons values)
+ *
+ * The values are float64, or int16 scaled by 32767 when quantized. A keyframe contains all the values.
+ */
+class StateMessage : public yarp::os::Portable
+{
+public:
+    int64_t sequence{ 0 };
+    double timestamp{ 0.0 };
+    bool keyframe{ false };
+    bool quantized{ false };
+    std::vector<int32_t> axes_ids;
+    std::vector<double> axes_values;
+    std::vector<int32_t> buttons_ids;
+    std::vector<double> buttons_values;
+
+    static int16_t quantize(double value);
+
+    // The message is only written by the device
+    bool read(yarp::os::ConnectionReader& reader) override;
+
+    bool write(yarp::os::ConnectionWriter& writer) const override;
+};
+
+/**
+ * Publishes the outputs on a port, writing only the values that changed since the last message,
+ * plus a periodic keyframe with all the values. It is called from the input path, after each sample.
+ */
+class StatePublisher
+{
+    yarp::os::BufferedPort<StateMessage> m_port;
+    yarp::os::Stamp m_stamp;
+    double m_keyframe_period;
+    bool m_quantize;
+    double m_last_keyframe_time{ -1.0 };
+    int64_t m_sequence{ 0 };
+    std::vector<double> m_sent_axes;
+    std::vector<double> m_sent_buttons;
+
+    // Value as received by the clients
+    double sentValue(double value) const;
+
+public:
+    StatePublisher(double keyframe_period, bool quantize);
+
+    bool open(const std::string& port_name, size_t number_of_axes, size_t number_of_buttons);
+
+    void close();
+
+    // Writes a message if any value changed, or if a keyframe is due
+    void publish(double timestamp, const std::vector<double>& axes_values, const std::vector<double>& buttons_values);
+};
+
+#endif // YARP_DEV_KEYBOARDJOYPADSTATEPUBLISHER_H
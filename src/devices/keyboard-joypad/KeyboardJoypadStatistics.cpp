@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <yarp/os/LogStream.h>
+
+#include <KeyboardJoypadStatistics.h>
+#include <KeyboardJoypadLogComponent.h>
+
+double threadCpuTime()
+{
+#ifdef _WIN32
+    FILETIME creation_time, exit_time, kernel_time, user_time;
+    if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time))
+    {
+        return 0.0;
+    }
+    auto toSeconds = [](const FILETIME& time)
+    {
+        return (static_cast<uint64_t>(time.dwHighDateTime) << 32 | time.dwLowDateTime) * 1e-7; //100 ns units
+    };
+    return toSeconds(kernel_time) + toSeconds(user_time);
+#else
+    timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+    {
+        return 0.0;
+    }
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1e-9;
+#endif
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t nanoseconds)
+{
+    if (nanoseconds < subBuckets)
+    {
+        return static_cast<size_t>(nanoseconds);
+    }
+    unsigned int exponent = static_cast<unsigned int>(std::bit_width(nanoseconds)) - 1 - subBucketBits;
+    return (exponent + 1) * subBuckets + static_cast<size_t>((nanoseconds >> exponent) - subBuckets);
+}
+
+uint64_t LatencyHistogram::bucketValue(size_t index)
+{
+    if (index < subBuckets)
+    {
+        return index;
+    }
+    unsigned int exponent = static_cast<unsigned int>(index / subBuckets) - 1;
+    uint64_t lowest = static_cast<uint64_t>(subBuckets + index % subBuckets) << exponent;
+    return lowest + ((uint64_t{ 1 } << exponent) - 1);
+}
+
+void LatencyHistogram::record(int64_t nanoseconds)
+{
+    uint64_t value = static_cast<uint64_t>(std::max<int64_t>(nanoseconds, 0));
+    m_counts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other)
+{
+    for (size_t i = 0; i < numberOfBuckets; ++i)
+    {
+        m_counts[i].fetch_add(other.m_counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    uint64_t other_max = other.m_max.load(std::memory_order_relaxed);
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (other_max > max && !m_max.compare_exchange_weak(max, other_max, std::memory_order_relaxed))
+    {
+    }
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary(bool reset)
+{
+    std::array<uint64_t, numberOfBuckets> counts;
+    Summary output;
+    for (size_t i = 0; i < numberOfBuckets; ++i)
+    {
+        counts[i] = reset ? m_counts[i].exchange(0, std::memory_order_relaxed) : m_counts[i].load(std::memory_order_relaxed);
+        output.count += counts[i];
+    }
+    uint64_t max = reset ? m_max.exchange(0, std::memory_order_relaxed) : m_max.load(std::memory_order_relaxed);
+
+    if (output.count == 0)
+    {
+        return output;
+    }
+
+    auto percentile = [&](double quantile)
+    {
+        uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(output.count))));
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < numberOfBuckets; ++i)
+        {
+            cumulative += counts[i];
+            if (cumulative >= target)
+            {
+                // The max is exact, while the buckets only provide an upper bound
+                return std::min(bucketValue(i), max) * 1e-9;
+            }
+        }
+        return max * 1e-9;
+    };
+
+    output.p50 = percentile(0.5);
+    output.p99 = percentile(0.99);
+    output.p999 = percentile(0.999);
+    output.max = max * 1e-9;
+    return output;
+}
+
+const char* LatencyStatistics::stageName(LatencyStage stage)
+{
+    switch (stage)
+    {
+    case LatencyStage::InputToMapping:
+        return "input_to_mapping";
+    case LatencyStage::MappingToPublish:
+        return "mapping_to_publish";
+    case LatencyStage::PublishToRead:
+        return "publish_to_read";
+    case LatencyStage::InputToRead:
+        return "input_to_read";
+    case LatencyStage::MutexWait:
+        return "mutex_wait";
+    default:
+        return "unknown";
+    }
+}
+
+void LatencyStatistics::record(LatencyStage stage, int64_t nanoseconds)
+{
+    m_histograms[static_cast<size_t>(stage)].record(nanoseconds);
+}
+
+void LatencyStatistics::outputsPublished(int64_t input_time, int64_t publish_time)
+{
+    m_pending_input_time.store(input_time, std::memory_order_relaxed);
+    m_pending_publish_time.store(publish_time, std::memory_order_release);
+}
+
+void LatencyStatistics::outputsRead()
+{
+    // Cheap check first, to avoid writing on the shared cache line at every read
+    if (m_pending_publish_time.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+    int64_t publish_time = m_pending_publish_time.exchange(0, std::memory_order_acquire);
+    if (publish_time == 0)
+    {
+        return; //Another getter has been faster
+    }
+    int64_t input_time = m_pending_input_time.load(std::memory_order_relaxed);
+    int64_t read_time = now();
+    record(LatencyStage::PublishToRead, read_time - publish_time);
+    record(LatencyStage::InputToRead, read_time - input_time);
+}
+
+LatencyHistogram::Summary LatencyStatistics::summary(LatencyStage stage, bool reset)
+{
+    return m_histograms[static_cast<size_t>(stage)].summary(reset);
+}
+
+LatencyStatisticsPublisher::LatencyStatisticsPublisher(LatencyStatistics& statistics, double period)
+    : yarp::os::PeriodicThread(period),
+      m_statistics(statistics)
+{
+}
+
+bool LatencyStatisticsPublisher::open(const std::string& port_name)
+{
+    if (!m_port.open(port_name))
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to open the port" << port_name;
+        return false;
+    }
+
+    if (!this->start())
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to start the thread publishing the latency statistics.";
+        m_port.close();
+        return false;
+    }
+
+    yCInfo(KEYBOARDJOYPAD) << "Publishing the latency statistics on" << port_name << "every" << this->getPeriod() << "seconds.";
+    return true;
+}
+
+void LatencyStatisticsPublisher::close()
+{
+    this->stop();
+    m_port.close();
+}
+
+void LatencyStatisticsPublisher::run()
+{
+    // Each stage is written as (name (count n) (p50 s) (p99 s) (p999 s) (max s)), with the values in seconds
+    yarp::os::Bottle& output = m_port.prepare();
+    output.clear();
+    for (size_t i = 0; i < static_cast<size_t>(LatencyStage::COUNT); ++i)
+    {
+        LatencyStage stage = static_cast<LatencyStage>(i);
+        LatencyHistogram::Summary summary = m_statistics.summary(stage, true);
+
+        yarp::os::Bottle& stage_bottle = output.addList();
+        stage_bottle.addString(LatencyStatistics::stageName(stage));
+
+        yarp::os::Bottle& count = stage_bottle.addList();
+        count.addString("count");
+        count.addInt64(static_cast<int64_t>(summary.count));
+
+        auto addValue = [&stage_bottle](const std::string& name, double value)
+        {
+            yarp::os::Bottle& entry = stage_bottle.addList();
+            entry.addString(name);
+            entry.addFloat64(value);
+        };
+        addValue("p50", summary.p50);
+        addValue("p99", summary.p99);
+        addValue("p999", summary.p999);
+        addValue("max", summary.max);
+    }
+    m_port.write();
+}
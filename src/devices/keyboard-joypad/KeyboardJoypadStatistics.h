@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_KEYBOARDJOYPADSTATISTICS_H
+#define YARP_DEV_KEYBOARDJOYPADSTATISTICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/PeriodicThread.h>
+
+// CPU time consumed by the calling thread, in seconds
+double threadCpuTime();
+
+/**
+ * Histogram of durations with logarithmic buckets, each split in 16 linear sub-buckets, similar to HDR histograms.
+ * The values are stored in nanoseconds with a relative error lower than 1/16, from 1 ns up to the maximum int64.
+ * Values can be recorded concurrently from any thread without locks.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned int subBucketBits = 4;
+    static constexpr size_t subBuckets = size_t{ 1 } << subBucketBits;
+    static constexpr size_t numberOfBuckets = 64 * subBuckets;
+
+    struct Summary
+    {
+        uint64_t count{ 0 };
+        double p50{ 0 };
+        double p99{ 0 };
+        double p999{ 0 };
+        double max{ 0 };
+    };
+
+private:
+    std::array<std::atomic<uint64_t>, numberOfBuckets> m_counts{};
+    std::atomic<uint64_t> m_max{ 0 };
+
+    static size_t bucketIndex(uint64_t nanoseconds);
+
+    // Highest value that falls in the bucket
+    static uint64_t bucketValue(size_t index);
+
+public:
+    void record(int64_t nanoseconds);
+
+    // Adds the values recorded by another histogram, e.g. one per thread
+    void add(const LatencyHistogram& other);
+
+    // Summary of the values in seconds. The histogram is cleared if reset is true.
+    Summary summary(bool reset);
+};
+
+enum class LatencyStage : size_t
+{
+    InputToMapping = 0, //From the arrival of an input to the end of the mapping
+    MappingToPublish,   //From the end of the mapping to the publication of the outputs for the getters
+    PublishToRead,      //From the publication to the first read of a getter
+    InputToRead,        //From the arrival of an input to the first read of a getter
+    MutexWait,          //Time spent waiting for the device mutex
+    COUNT
+};
+
+/**
+ * Latency histograms of the stages of the input path.
+ */
+class LatencyStatistics
+{
+    std::array<LatencyHistogram, static_cast<size_t>(LatencyStage::COUNT)> m_histograms;
+    std::atomic<int64_t> m_pending_input_time{ 0 };
+    std::atomic<int64_t> m_pending_publish_time{ 0 };
+
+public:
+    // Monotonic time in nanoseconds used for all the timestamps
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static const char* stageName(LatencyStage stage);
+
+    void record(LatencyStage stage, int64_t nanoseconds);
+
+    // To be called when the outputs depending on an input arrived at input_time are published
+    void outputsPublished(int64_t input_time, int64_t publish_time);
+
+    // To be called by the getters. Only the first read after a publication is considered.
+    void outputsRead();
+
+    LatencyHistogram::Summary summary(LatencyStage stage, bool reset);
+};
+
+/**
+ * Periodically writes the summary of the latency histograms on a port, clearing them after each write.
+ */
+class LatencyStatisticsPublisher : public yarp::os::PeriodicThread
+{
+    LatencyStatistics& m_statistics;
+    yarp::os::BufferedPort<yarp::os::Bottle> m_port;
+
+public:
+    LatencyStatisticsPublisher(LatencyStatistics& statistics, double period);
+
+    bool open(const std::string& port_name);
+
+    void close();
+
+protected:
+    void run() override;
+};
+
+#endif // YARP_DEV_KEYBOARDJOYPADSTATISTICS_H
@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#include <algorithm>
+
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Os.h>
+
+#include <KeyboardJoypadTrace.h>
+#include <KeyboardJoypadLogComponent.h>
+
+static constexpr double flushPeriod = 0.1; //seconds
+static constexpr size_t maxTracedThreads = 256;
+
+static std::atomic<uint64_t> traceWriterGenerations{ 0 };
+
+TraceWriter::TraceWriter()
+    : yarp::os::PeriodicThread(flushPeriod, yarp::os::ShouldUseSystemClock::Yes)
+{
+}
+
+TraceWriter::~TraceWriter()
+{
+    close();
+}
+
+bool TraceWriter::open(const std::string& file_name, size_t max_file_size, int max_files)
+{
+    close();
+
+    m_file_name = file_name;
+    m_max_file_size = max_file_size;
+    m_max_files = std::max(max_files, 1);
+    m_start_time = LatencyStatistics::now();
+    m_pid = yarp::os::getpid();
+    m_dropped_events = 0;
+    if (!openFile())
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to open the trace file" << file_name;
+        return false;
+    }
+
+    // A new writer at the address of a closed one must not reuse the rings cached by the threads
+    m_generation.store(++traceWriterGenerations, std::memory_order_relaxed);
+    m_enabled = true;
+    if (!this->start())
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to start the thread writing the trace.";
+        m_enabled = false;
+        closeFile();
+        return false;
+    }
+
+    yCInfo(KEYBOARDJOYPAD) << "Writing the trace of the stages in" << file_name;
+    return true;
+}
+
+void TraceWriter::close()
+{
+    m_enabled = false;
+    if (this->isRunning())
+    {
+        this->stop(); //The remaining events are written by threadRelease
+    }
+    if (!m_file)
+    {
+        return;
+    }
+    closeFile();
+    if (m_dropped_events > 0)
+    {
+        yCWarning(KEYBOARDJOYPAD) << m_dropped_events << "trace events have been dropped, since they were recorded faster than written.";
+    }
+}
+
+void TraceWriter::record(const char* name, int64_t start, int64_t end)
+{
+    if (!enabled())
+    {
+        return;
+    }
+    TraceRing* ring = threadRing();
+    if (ring)
+    {
+        ring->push({ name, start, end - start });
+    }
+}
+
+void TraceWriter::nameThread(const std::string& name)
+{
+    if (!enabled() || !threadRing())
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_rings_mutex);
+    for (auto& ring : m_rings)
+    {
+        if (ring->thread == std::this_thread::get_id())
+        {
+            ring->name = name;
+        }
+    }
+    m_names_changed = true;
+}
+
+TraceRing* TraceWriter::threadRing()
+{
+    // Each thread caches the rings of the last writers it used, to find them without locking
+    struct CacheEntry
+    {
+        const TraceWriter* writer{ nullptr };
+        uint64_t generation{ 0 };
+        TraceRing* ring{ nullptr };
+    };
+    thread_local std::array<CacheEntry, 4> cache;
+    thread_local size_t next_entry = 0;
+
+    uint64_t generation = m_generation.load(std::memory_order_relaxed);
+    for (const CacheEntry& entry : cache)
+    {
+        if (entry.writer == this && entry.generation == generation)
+        {
+            return entry.ring;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_rings_mutex);
+    std::thread::id thread = std::this_thread::get_id();
+    TraceRing* ring = nullptr;
+    for (auto& existing : m_rings)
+    {
+        if (existing->thread == thread)
+        {
+            ring = existing.get();
+            break;
+        }
+    }
+    if (!ring)
+    {
+        if (m_rings.size() >= maxTracedThreads)
+        {
+            return nullptr;
+        }
+        m_rings.push_back(std::make_unique<TraceRing>(thread, static_cast<uint32_t>(m_rings.size() + 1)));
+        ring = m_rings.back().get();
+        ring->name = "Thread " + std::to_string(ring->trace_id);
+    }
+    cache[next_entry] = { this, generation, ring };
+    next_entry = (next_entry + 1) % cache.size();
+    return ring;
+}
+
+bool TraceWriter::openFile()
+{
+    m_file = std::fopen(m_file_name.c_str(), "w");
+    if (!m_file)
+    {
+        return false;
+    }
+    // JSON array format. Perfetto loads also a file that has not been completed, e.g. after a crash.
+    std::fputs("[\n", m_file);
+    m_file_size = 2;
+    m_first_event = true;
+    m_named_rings = 0;
+    return true;
+}
+
+void TraceWriter::closeFile()
+{
+    if (!m_file)
+    {
+        return;
+    }
+    std::fputs("\n]\n", m_file);
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+void TraceWriter::rotate()
+{
+    closeFile();
+    // The file becomes ".1", ".1" becomes ".2", and so on, dropping the oldest one. With a single file, it is restarted.
+    for (int i = m_max_files - 1; i >= 1; --i)
+    {
+        std::string from = i == 1 ? m_file_name : m_file_name + "." + std::to_string(i - 1);
+        std::string to = m_file_name + "." + std::to_string(i);
+        std::remove(to.c_str());
+        std::rename(from.c_str(), to.c_str());
+    }
+    if (!openFile())
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to open the trace file" << m_file_name << "after the rotation. The trace is stopped.";
+        m_enabled = false;
+    }
+}
+
+void TraceWriter::append(const char* json)
+{
+    if (!m_first_event)
+    {
+        m_buffer += ",\n";
+    }
+    m_first_event = false;
+    m_buffer += json;
+}
+
+void TraceWriter::flush()
+{
+    if (!m_file)
+    {
+        return;
+    }
+
+    char json[256];
+    m_buffer.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_rings_mutex);
+        if (m_names_changed)
+        {
+            m_named_rings = 0;
+            m_names_changed = false;
+        }
+        // The names are written again in each file, since each one is loaded on its own
+        for (; m_named_rings < m_rings.size(); ++m_named_rings)
+        {
+            const TraceRing& ring = *m_rings[m_named_rings];
+            std::snprintf(json, sizeof(json), R"({"name":"thread_name","ph":"M","pid":%d,"tid":%u,"args":{"name":"%s"}})",
+                          m_pid, ring.trace_id, ring.name.c_str());
+            append(json);
+        }
+
+        for (auto& ring : m_rings)
+        {
+            m_events.clear();
+            ring->drain(m_events);
+            m_dropped_events += ring->takeDropped();
+            for (const TraceEvent& event : m_events)
+            {
+                // Complete events, with the times in microseconds from the opening of the trace
+                std::snprintf(json, sizeof(json), R"({"name":"%s","cat":"keyboardJoypad","ph":"X","pid":%d,"tid":%u,"ts":%.3f,"dur":%.3f})",
+                              event.name, m_pid, ring->trace_id, static_cast<double>(event.start - m_start_time) * 1e-3,
+                              static_cast<double>(event.duration) * 1e-3);
+                append(json);
+            }
+        }
+    }
+
+    if (m_buffer.empty())
+    {
+        return;
+    }
+    std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+    std::fflush(m_file);
+    m_file_size += m_buffer.size();
+    if (m_file_size >= m_max_file_size)
+    {
+        rotate();
+    }
+}
+
+void TraceWriter::run()
+{
+    flush();
+}
+
+void TraceWriter::threadRelease()
+{
+    flush();
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_KEYBOARDJOYPADTRACE_H
+#define YARP_DEV_KEYBOARDJOYPADTRACE_H
+
+#include <KeyboardJoypadStatistics.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <yarp/os/PeriodicThread.h>
+
+struct TraceEvent
+{
+    const char* name; //Static string
+    int64_t start; //LatencyStatistics::now()
+    int64_t duration;
+};
+
+/**
+ * Events of a single thread, written only by that thread and read only by the flushing thread.
+ * When full, the new events are dropped, so that the traced thread never waits.
+ */
+class TraceRing
+{
+public:
+    static constexpr size_t capacity = 4096;
+
+private:
+    std::array<TraceEvent, capacity> m_events;
+    std::atomic<uint64_t> m_written{ 0 };
+    std::atomic<uint64_t> m_read{ 0 };
+    std::atomic<uint64_t> m_dropped{ 0 };
+
+public:
+    const std::thread::id thread;
+    const uint32_t trace_id; //Thread id in the trace
+    std::string name; //Guarded by the mutex of the writer
+
+    TraceRing(std::thread::id thread_id, uint32_t id)
+        : thread(thread_id), trace_id(id)
+    {
+    }
+
+    void push(const TraceEvent& event)
+    {
+        uint64_t written = m_written.load(std::memory_order_relaxed);
+        if (written - m_read.load(std::memory_order_acquire) >= capacity)
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_events[written % capacity] = event;
+        m_written.store(written + 1, std::memory_order_release);
+    }
+
+    // Moves the pending events at the end of events
+    void drain(std::vector<TraceEvent>& events)
+    {
+        uint64_t read = m_read.load(std::memory_order_relaxed);
+        uint64_t written = m_written.load(std::memory_order_acquire);
+        for (; read < written; ++read)
+        {
+            events.push_back(m_events[read % capacity]);
+        }
+        m_read.store(read, std::memory_order_release);
+    }
+
+    uint64_t takeDropped()
+    {
+        return m_dropped.exchange(0, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Streaming writer of the durations of the stages of the device, in the Chrome Trace Event JSON format,
+ * that can be loaded in Perfetto or chrome://tracing.
+ *
+ * The traced threads record complete events in their own ring, without locks after their first event.
+ * A periodic thread moves them to the file. When the file exceeds the maximum size, it is completed and renamed
+ * with the suffix ".1", the older ones are shifted up to the maximum number of files, and a new file is started.
+ */
+class TraceWriter : public yarp::os::PeriodicThread
+{
+    std::atomic<bool> m_enabled{ false };
+    std::atomic<uint64_t> m_generation{ 0 }; //Distinguishes the writers in the cache of the threads
+    std::string m_file_name;
+    size_t m_max_file_size{ 0 };
+    int m_max_files{ 1 };
+    std::FILE* m_file{ nullptr };
+    size_t m_file_size{ 0 };
+    bool m_first_event{ true };
+    int64_t m_start_time{ 0 };
+    int m_pid{ 0 };
+
+    std::mutex m_rings_mutex;
+    std::vector<std::unique_ptr<TraceRing>> m_rings; //Kept until the writer is destroyed, since threads might still use them
+    size_t m_named_rings{ 0 }; //Rings whose name has been written in the current file
+    bool m_names_changed{ false };
+    std::vector<TraceEvent> m_events; //Accessed only when flushing
+    std::string m_buffer; //Accessed only when flushing
+    uint64_t m_dropped_events{ 0 };
+
+    TraceRing* threadRing();
+    bool openFile();
+    void closeFile();
+    void rotate();
+    void append(const char* json);
+    void flush();
+
+public:
+    TraceWriter();
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    ~TraceWriter() override;
+
+    bool open(const std::string& file_name, size_t max_file_size, int max_files);
+
+    // Writes the remaining events and completes the file
+    void close();
+
+    bool enabled() const
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    // Records an event of the calling thread
+    void record(const char* name, int64_t start, int64_t end);
+
+    // Names the calling thread in the trace
+    void nameThread(const std::string& name);
+
+protected:
+    void run() override;
+    void threadRelease() override;
+};
+
+/**
+ * Records the duration of a scope. It does nothing if the writer is null or not enabled.
+ */
+class TraceScope
+{
+    TraceWriter* m_writer;
+    const char* m_name;
+    int64_t m_start;
+
+public:
+    TraceScope(TraceWriter* writer, const char* name)
+        : m_writer(writer && writer->enabled() ? writer : nullptr), m_name(name), m_start(m_writer ? LatencyStatistics::now() : 0)
+    {
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    ~TraceScope()
+    {
+        if (m_writer)
+        {
+            m_writer->record(m_name, m_start, LatencyStatistics::now());
+        }
+    }
+};
+
+#endif // YARP_DEV_KEYBOARDJOYPADTRACE_H
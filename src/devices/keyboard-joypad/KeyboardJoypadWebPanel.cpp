@@ -0,0 +1,1104 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+#include <yarp/os/LogStream.h>
+
+#include <KeyboardJoypadWebPanel.h>
+#include <KeyboardJoypadLogComponent.h>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static constexpr size_t maxClients = 16;
+static constexpr size_t maxRequestSize = 8192;
+static constexpr size_t maxMessageSize = 4096; //Hundreds of events, much more than a page sends at once
+static constexpr size_t maxBufferedEvents = 4096;
+static constexpr size_t maxPendingOutput = 1 << 20; //A page not reading the state for this long is disconnected
+
+// Codes of the KeyboardEvent in the browser, besides the letters, the digits and the function keys
+struct WebKeyCode
+{
+    const char* code;
+    ImGuiKey key;
+};
+
+static const WebKeyCode webKeyCodes[] = {
+    { "Space", ImGuiKey_Space },
+    { "Enter", ImGuiKey_Enter },
+    { "Escape", ImGuiKey_Escape },
+    { "Backspace", ImGuiKey_Backspace },
+    { "Delete", ImGuiKey_Delete },
+    { "Tab", ImGuiKey_Tab },
+    { "ArrowLeft", ImGuiKey_LeftArrow },
+    { "ArrowRight", ImGuiKey_RightArrow },
+    { "ArrowUp", ImGuiKey_UpArrow },
+    { "ArrowDown", ImGuiKey_DownArrow },
+    { "Insert", ImGuiKey_Insert },
+    { "Home", ImGuiKey_Home },
+    { "End", ImGuiKey_End },
+    { "PageUp", ImGuiKey_PageUp },
+    { "PageDown", ImGuiKey_PageDown },
+    { "ShiftLeft", ImGuiKey_LeftShift },
+    { "ShiftRight", ImGuiKey_RightShift },
+    { "ControlLeft", ImGuiKey_LeftCtrl },
+    { "ControlRight", ImGuiKey_RightCtrl },
+    { "AltLeft", ImGuiKey_LeftAlt },
+    { "AltRight", ImGuiKey_RightAlt },
+    { "MetaLeft", ImGuiKey_LeftSuper },
+    { "MetaRight", ImGuiKey_RightSuper },
+    { "ContextMenu", ImGuiKey_Menu },
+    { "Quote", ImGuiKey_Apostrophe },
+    { "Comma", ImGuiKey_Comma },
+    { "Minus", ImGuiKey_Minus },
+    { "Period", ImGuiKey_Period },
+    { "Slash", ImGuiKey_Slash },
+    { "Semicolon", ImGuiKey_Semicolon },
+    { "Equal", ImGuiKey_Equal },
+    { "BracketLeft", ImGuiKey_LeftBracket },
+    { "Backslash", ImGuiKey_Backslash },
+    { "BracketRight", ImGuiKey_RightBracket },
+    { "Backquote", ImGuiKey_GraveAccent },
+    { "CapsLock", ImGuiKey_CapsLock },
+    { "ScrollLock", ImGuiKey_ScrollLock },
+    { "NumLock", ImGuiKey_NumLock },
+    { "PrintScreen", ImGuiKey_PrintScreen },
+    { "Pause", ImGuiKey_Pause },
+    { "NumpadDecimal", ImGuiKey_KeypadDecimal },
+    { "NumpadDivide", ImGuiKey_KeypadDivide },
+    { "NumpadMultiply", ImGuiKey_KeypadMultiply },
+    { "NumpadSubtract", ImGuiKey_KeypadSubtract },
+    { "NumpadAdd", ImGuiKey_KeypadAdd },
+    { "NumpadEnter", ImGuiKey_KeypadEnter },
+    { "NumpadEqual", ImGuiKey_KeypadEqual },
+};
+
+static void appendJsonString(std::string& json, std::string_view text)
+{
+    json.push_back('"');
+    for (char c : text)
+    {
+        switch (c)
+        {
+        case '"':
+            json += "\\\"";
+            break;
+        case '\\':
+            json += "\\\\";
+            break;
+        case '<': //The JSON is embedded in a script element, that would be closed by "</script>"
+            json += "\\u003c";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+                json += escaped;
+            }
+            else
+            {
+                json.push_back(c);
+            }
+            break;
+        }
+    }
+    json.push_back('"');
+}
+
+static void appendKeyCode(std::string& json, std::string_view code, ImGuiKey key)
+{
+    if (json.back() != '{')
+    {
+        json.push_back(',');
+    }
+    appendJsonString(json, code);
+    json += ":" + std::to_string(static_cast<int>(key));
+}
+
+// Description of the tables and of the keyboard codes used by the page
+static std::string layoutJson(const std::vector<WebPanelTable>& tables)
+{
+    std::string json = "{\"tables\":[";
+    for (size_t t = 0; t < tables.size(); ++t)
+    {
+        json += t == 0 ? "{\"name\":" : ",{\"name\":";
+        appendJsonString(json, tables[t].name);
+        json += ",\"columns\":" + std::to_string(std::max(tables[t].columns, 1)) + ",\"rows\":[";
+        for (size_t r = 0; r < tables[t].rows.size(); ++r)
+        {
+            json += r == 0 ? "[" : ",[";
+            for (size_t b = 0; b < tables[t].rows[r].size(); ++b)
+            {
+                const WebPanelButton& button = tables[t].rows[r][b];
+                json += b == 0 ? "{\"label\":" : ",{\"label\":";
+                appendJsonString(json, button.label);
+                json += ",\"button\":" + std::to_string(button.button) + ",\"col\":" + std::to_string(button.col) + "}";
+            }
+            json += "]";
+        }
+        json += "]}";
+    }
+
+    json += "],\"keys\":{";
+    for (int i = 0; i < 26; ++i)
+    {
+        appendKeyCode(json, std::string("Key") + static_cast<char>('A' + i), static_cast<ImGuiKey>(ImGuiKey_A + i));
+    }
+    for (int i = 0; i < 10; ++i)
+    {
+        appendKeyCode(json, "Digit" + std::to_string(i), static_cast<ImGuiKey>(ImGuiKey_0 + i));
+        appendKeyCode(json, "Numpad" + std::to_string(i), static_cast<ImGuiKey>(ImGuiKey_Keypad0 + i));
+    }
+    for (int i = 0; i < 12; ++i)
+    {
+        appendKeyCode(json, "F" + std::to_string(i + 1), static_cast<ImGuiKey>(ImGuiKey_F1 + i));
+#if IMGUI_VERSION_NUM >= 19000 // The keys from F13 to F24 are available since ImGui 1.90
+        appendKeyCode(json, "F" + std::to_string(i + 13), static_cast<ImGuiKey>(ImGuiKey_F13 + i));
+#endif
+    }
+    for (const WebKeyCode& key_code : webKeyCodes)
+    {
+        appendKeyCode(json, key_code.code, key_code.key);
+    }
+    json += "}}";
+    return json;
+}
+
+static const char webPanelPage[] = R"html(<!DOCTYPE html>
+<html>
+<head>
+<meta charset="utf-8">
+<meta name="viewport" content="width=device-width, initial-scale=1, user-scalable=no">
+<title>Keyboard Joypad</title>
+<style>
+body { margin: 0; padding: 12px; background: #1b1b1f; color: #ddd; font-family: sans-serif; user-select: none; -webkit-user-select: none; }
+#status { font-size: 14px; margin-bottom: 8px; }
+.table { display: inline-block; vertical-align: top; margin: 0 24px 16px 0; }
+.table h2 { font-size: 16px; margin: 0 0 6px; }
+.grid { display: grid; gap: 6px; }
+.button { min-width: 72px; min-height: 72px; padding: 4px; box-sizing: border-box; display: flex; align-items: center;
+          justify-content: center; text-align: center; background: #294a7a; border-radius: 6px; touch-action: none; cursor: pointer; }
+.button.active { background: #b38047; }
+.button.pressed { outline: 2px solid #eee; }
+</style>
+</head>
+<body>
+<div id="status">Connecting...</div>
+<div id="panel"></div>
+<script>
+"use strict";
+const layout = /*LAYOUT*/;
+const KEY = 1, BUTTON = 2, STATE = 1;
+const status = document.getElementById("status");
+const cells = [];
+const pressedKeys = new Set();
+let socket = null;
+
+function send(type, down, index) {
+  if (socket && socket.readyState === WebSocket.OPEN) {
+    socket.send(new Uint8Array([type, down ? 1 : 0, index & 255, index >> 8]));
+  }
+}
+
+for (const table of layout.tables) {
+  const container = document.createElement("div");
+  container.className = "table";
+  const title = document.createElement("h2");
+  title.textContent = table.name;
+  container.appendChild(title);
+  const grid = document.createElement("div");
+  grid.className = "grid";
+  grid.style.gridTemplateColumns = "repeat(" + table.columns + ", auto)";
+  table.rows.forEach((row, r) => {
+    for (const button of row) {
+      const cell = document.createElement("div");
+      cell.className = "button";
+      cell.textContent = button.label;
+      cell.style.gridRow = r + 1;
+      cell.style.gridColumn = button.col + 1;
+      const release = () => {
+        if (cell.classList.contains("pressed")) {
+          cell.classList.remove("pressed");
+          send(BUTTON, false, button.button);
+        }
+      };
+      cell.addEventListener("pointerdown", (event) => {
+        cell.setPointerCapture(event.pointerId);
+        cell.classList.add("pressed");
+        send(BUTTON, true, button.button);
+        event.preventDefault();
+      });
+      cell.addEventListener("pointerup", release);
+      cell.addEventListener("pointercancel", release);
+      cells[button.button] = cell;
+      grid.appendChild(cell);
+    }
+  });
+  container.appendChild(grid);
+  document.getElementById("panel").appendChild(container);
+}
+
+function onKey(event, down) {
+  const key = layout.keys[event.code];
+  if (key === undefined) {
+    return;
+  }
+  event.preventDefault();
+  if (event.repeat || down === pressedKeys.has(key)) {
+    return;
+  }
+  if (down) {
+    pressedKeys.add(key);
+  } else {
+    pressedKeys.delete(key);
+  }
+  send(KEY, down, key);
+}
+window.addEventListener("keydown", (event) => onKey(event, true));
+window.addEventListener("keyup", (event) => onKey(event, false));
+window.addEventListener("blur", () => {
+  for (const key of pressedKeys) {
+    send(KEY, false, key);
+  }
+  pressedKeys.clear();
+});
+
+function connect() {
+  socket = new WebSocket((location.protocol === "https:" ? "wss://" : "ws://") + location.host + "/ws");
+  socket.binaryType = "arraybuffer";
+  socket.onopen = () => { status.textContent = "Connected"; };
+  socket.onmessage = (event) => {
+    const data = new Uint8Array(event.data);
+    if (data[0] !== STATE) {
+      return;
+    }
+    for (let i = 1; i < data.length; ++i) {
+      if (cells[i - 1]) {
+        cells[i - 1].classList.toggle("active", data[i] !== 0);
+      }
+    }
+  };
+  socket.onclose = () => {
+    // The device releases the inputs of a closed connection
+    status.textContent = "Disconnected, reconnecting...";
+    pressedKeys.clear();
+    for (const cell of cells) {
+      if (cell) {
+        cell.classList.remove("pressed");
+      }
+    }
+    setTimeout(connect, 1000);
+  };
+}
+connect();
+</script>
+</body>
+</html>
+)html";
+
+static uint32_t rotateLeft(uint32_t value, int bits)
+{
+    return (value << bits) | (value >> (32 - bits));
+}
+
+// Needed only for the WebSocket handshake
+static std::array<unsigned char, 20> sha1(std::string_view message)
+{
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+    std::string data(message);
+    uint64_t bit_length = static_cast<uint64_t>(message.size()) * 8;
+    data.push_back(static_cast<char>(0x80));
+    while (data.size() % 64 != 56)
+    {
+        data.push_back('\0');
+    }
+    for (int i = 7; i >= 0; --i)
+    {
+        data.push_back(static_cast<char>((bit_length >> (8 * i)) & 0xFF));
+    }
+
+    for (size_t chunk = 0; chunk < data.size(); chunk += 64)
+    {
+        uint32_t w[80];
+        for (size_t i = 0; i < 16; ++i)
+        {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data() + chunk + 4 * i);
+            w[i] = (uint32_t{ bytes[0] } << 24) | (uint32_t{ bytes[1] } << 16) | (uint32_t{ bytes[2] } << 8) | uint32_t{ bytes[3] };
+        }
+        for (size_t i = 16; i < 80; ++i)
+        {
+            w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (size_t i = 0; i < 80; ++i)
+        {
+            uint32_t f, k;
+            if (i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t temp = rotateLeft(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotateLeft(b, 30);
+            b = a;
+            a = temp;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    std::array<unsigned char, 20> digest;
+    for (size_t i = 0; i < 5; ++i)
+    {
+        digest[4 * i] = static_cast<unsigned char>(h[i] >> 24);
+        digest[4 * i + 1] = static_cast<unsigned char>(h[i] >> 16);
+        digest[4 * i + 2] = static_cast<unsigned char>(h[i] >> 8);
+        digest[4 * i + 3] = static_cast<unsigned char>(h[i]);
+    }
+    return digest;
+}
+
+static std::string base64(const unsigned char* data, size_t size)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string encoded;
+    for (size_t i = 0; i < size; i += 3)
+    {
+        uint32_t group = uint32_t{ data[i] } << 16;
+        if (i + 1 < size)
+        {
+            group |= uint32_t{ data[i + 1] } << 8;
+        }
+        if (i + 2 < size)
+        {
+            group |= uint32_t{ data[i + 2] };
+        }
+        encoded.push_back(alphabet[(group >> 18) & 0x3F]);
+        encoded.push_back(alphabet[(group >> 12) & 0x3F]);
+        encoded.push_back(i + 1 < size ? alphabet[(group >> 6) & 0x3F] : '=');
+        encoded.push_back(i + 2 < size ? alphabet[group & 0x3F] : '=');
+    }
+    return encoded;
+}
+
+// Value of Sec-WebSocket-Accept for the Sec-WebSocket-Key of the request (RFC 6455)
+static std::string webSocketAccept(std::string_view key)
+{
+    std::array<unsigned char, 20> digest = sha1(std::string(key) + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+    return base64(digest.data(), digest.size());
+}
+
+static void appendWebSocketFrame(std::string& output, uint8_t opcode, const unsigned char* payload, size_t size)
+{
+    output.push_back(static_cast<char>(0x80 | opcode)); //The messages are never fragmented
+    if (size < 126)
+    {
+        output.push_back(static_cast<char>(size));
+    }
+    else if (size < 65536)
+    {
+        output.push_back(static_cast<char>(126));
+        output.push_back(static_cast<char>(size >> 8));
+        output.push_back(static_cast<char>(size & 0xFF));
+    }
+    else
+    {
+        output.push_back(static_cast<char>(127));
+        for (int i = 7; i >= 0; --i)
+        {
+            output.push_back(static_cast<char>((static_cast<uint64_t>(size) >> (8 * i)) & 0xFF));
+        }
+    }
+    output.append(reinterpret_cast<const char*>(payload), size);
+}
+
+static std::string httpResponse(std::string_view status, std::string_view content_type, std::string_view body)
+{
+    std::string response = "HTTP/1.1 ";
+    response += status;
+    response += "\r\nContent-Type: ";
+    response += content_type;
+    response += "\r\nContent-Length: " + std::to_string(body.size());
+    response += "\r\nCache-Control: no-store\r\nConnection: close\r\n\r\n";
+    response += body;
+    return response;
+}
+
+static std::string toLower(std::string_view text)
+{
+    std::string lower(text);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return lower;
+}
+
+static std::string_view trim(std::string_view text)
+{
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+    {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+    {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+struct WebPanelServer::Client
+{
+    int fd{ -1 };
+    std::string input;
+    std::string output;
+    bool websocket{ false };
+    bool close_after_write{ false };
+    bool closed{ false };
+    uint64_t sent_highlighted_version{ 0 };
+    std::vector<WebPanelEvent> held; //Keys and buttons pressed by the page, and not released yet
+};
+
+WebPanelServer::WebPanelServer() = default;
+
+WebPanelServer::~WebPanelServer()
+{
+    close();
+}
+
+bool WebPanelServer::isOpen() const
+{
+    return m_running;
+}
+
+bool WebPanelServer::hasClients() const
+{
+    return m_number_of_websockets.load(std::memory_order_relaxed) > 0;
+}
+
+void WebPanelServer::takeEvents(std::vector<WebPanelEvent>& events)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    events.insert(events.end(), m_events.begin(), m_events.end());
+    m_events.clear();
+}
+
+uint64_t WebPanelServer::droppedEvents()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dropped_events;
+}
+
+void WebPanelServer::publishHighlighted(const std::vector<uint8_t>& highlighted)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (highlighted == m_highlighted)
+        {
+            return;
+        }
+        m_highlighted = highlighted;
+        m_highlighted_version++;
+    }
+    wake();
+}
+
+void WebPanelServer::handleEvents(Client& client, const unsigned char* payload, size_t size)
+{
+    if (size % 4 != 0)
+    {
+        yCWarningThrottle(KEYBOARDJOYPAD, 5.0) << "The web panel received a message of" << size << "bytes, not made of 4 bytes events. It is ignored.";
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < size; i += 4)
+    {
+        WebPanelEvent event{ static_cast<WebPanelEventType>(payload[i]), payload[i + 1] != 0,
+                             static_cast<uint16_t>(payload[i + 2] | (payload[i + 3] << 8)) };
+        bool valid = (event.type == WebPanelEventType::KEY && event.index >= ImGuiKey_NamedKey_BEGIN && event.index < ImGuiKey_NamedKey_END)
+                     || (event.type == WebPanelEventType::BUTTON && event.index < m_number_of_buttons);
+        if (!valid)
+        {
+            continue;
+        }
+
+        auto held = std::find_if(client.held.begin(), client.held.end(),
+                                 [&event](const WebPanelEvent& e) { return e.type == event.type && e.index == event.index; });
+        if (event.down && held == client.held.end())
+        {
+            client.held.push_back(event);
+        }
+        else if (!event.down && held != client.held.end())
+        {
+            client.held.erase(held);
+        }
+
+        if (m_events.size() >= maxBufferedEvents)
+        {
+            m_dropped_events++;
+            continue;
+        }
+        m_events.push_back(event);
+    }
+}
+
+void WebPanelServer::releaseHeldInputs(Client& client)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (WebPanelEvent event : client.held)
+    {
+        // Queued also when the buffer is full, since they are never to be lost
+        event.down = false;
+        m_events.push_back(event);
+    }
+    client.held.clear();
+}
+
+#ifndef _WIN32
+
+#ifdef MSG_NOSIGNAL
+static constexpr int sendFlags = MSG_NOSIGNAL;
+#else
+static constexpr int sendFlags = 0; //SO_NOSIGPIPE is set on the sockets instead
+#endif
+
+static bool setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool WebPanelServer::open(const std::string& address, int port, const std::vector<WebPanelTable>& tables, size_t number_of_buttons)
+{
+    close();
+
+    if (number_of_buttons > 65536)
+    {
+        yCError(KEYBOARDJOYPAD) << "The web panel supports at most 65536 buttons.";
+        return false;
+    }
+
+    sockaddr_in socket_address{};
+    socket_address.sin_family = AF_INET;
+    socket_address.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, address.c_str(), &socket_address.sin_addr) != 1)
+    {
+        yCError(KEYBOARDJOYPAD) << "The web panel address" << address << "is not a valid IPv4 address.";
+        return false;
+    }
+
+    m_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (m_listen_fd < 0)
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to create the socket of the web panel:" << std::strerror(errno);
+        return false;
+    }
+    int enable = 1;
+    setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    if (bind(m_listen_fd, reinterpret_cast<sockaddr*>(&socket_address), sizeof(socket_address)) != 0
+        || listen(m_listen_fd, static_cast<int>(maxClients)) != 0 || !setNonBlocking(m_listen_fd))
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to listen on" << address << ":" << port << "for the web panel:" << std::strerror(errno);
+        ::close(m_listen_fd);
+        m_listen_fd = -1;
+        return false;
+    }
+
+    if (pipe(m_wake_pipe) != 0 || !setNonBlocking(m_wake_pipe[0]) || !setNonBlocking(m_wake_pipe[1]))
+    {
+        yCError(KEYBOARDJOYPAD) << "Failed to create the wake up pipe of the web panel:" << std::strerror(errno);
+        close();
+        return false;
+    }
+
+    std::string page = webPanelPage;
+    std::string_view placeholder = "/*LAYOUT*/";
+    page.replace(page.find(placeholder), placeholder.size(), layoutJson(tables));
+    m_page_response = httpResponse("200 OK", "text/html; charset=utf-8", page);
+    m_number_of_buttons = static_cast<uint32_t>(number_of_buttons);
+    m_highlighted.clear();
+    m_highlighted_version = 0;
+    m_dropped_events = 0;
+
+    m_running = true;
+    m_thread = std::thread(&WebPanelServer::run, this);
+
+    yCInfo(KEYBOARDJOYPAD) << "Serving the web panel at http://" + address + ":" + std::to_string(this->port());
+    return true;
+}
+
+void WebPanelServer::close()
+{
+    if (m_thread.joinable())
+    {
+        m_running = false;
+        wake();
+        m_thread.join();
+    }
+    m_running = false;
+    if (m_listen_fd >= 0)
+    {
+        ::close(m_listen_fd);
+        m_listen_fd = -1;
+    }
+    for (int& fd : m_wake_pipe)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_events.clear();
+}
+
+int WebPanelServer::port() const
+{
+    sockaddr_in socket_address{};
+    socklen_t length = sizeof(socket_address);
+    if (m_listen_fd < 0 || getsockname(m_listen_fd, reinterpret_cast<sockaddr*>(&socket_address), &length) != 0)
+    {
+        return -1;
+    }
+    return ntohs(socket_address.sin_port);
+}
+
+void WebPanelServer::wake()
+{
+    if (m_wake_pipe[1] >= 0)
+    {
+        char byte = 0;
+        [[maybe_unused]] ssize_t written = write(m_wake_pipe[1], &byte, 1); //If the pipe is full, the thread is already awake
+    }
+}
+
+void WebPanelServer::acceptClients()
+{
+    while (true)
+    {
+        int fd = accept(m_listen_fd, nullptr, nullptr);
+        if (fd < 0)
+        {
+            return;
+        }
+        if (m_clients.size() >= maxClients || !setNonBlocking(fd))
+        {
+            yCWarningThrottle(KEYBOARDJOYPAD, 5.0) << "The web panel refused a connection, since it has already" << maxClients << "connections.";
+            ::close(fd);
+            continue;
+        }
+        // The events are a few bytes, and they should not wait to be coalesced
+        int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &enable, sizeof(enable));
+#endif
+        auto client = std::make_unique<Client>();
+        client->fd = fd;
+        m_clients.push_back(std::move(client));
+    }
+}
+
+bool WebPanelServer::readFromClient(Client& client)
+{
+    char buffer[4096];
+    while (true)
+    {
+        ssize_t received = recv(client.fd, buffer, sizeof(buffer), 0);
+        if (received == 0)
+        {
+            return false;
+        }
+        if (received < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            return false;
+        }
+        if (!client.close_after_write)
+        {
+            client.input.append(buffer, static_cast<size_t>(received));
+        }
+        if (client.input.size() > maxRequestSize + maxMessageSize)
+        {
+            return false;
+        }
+    }
+
+    if (!client.websocket && !handleHttpRequest(client))
+    {
+        return false;
+    }
+    return !client.websocket || handleWebSocketFrames(client);
+}
+
+bool WebPanelServer::handleHttpRequest(Client& client)
+{
+    size_t end = client.input.find("\r\n\r\n");
+    if (end == std::string::npos)
+    {
+        return client.input.size() <= maxRequestSize;
+    }
+    std::string request = client.input.substr(0, end + 2);
+    client.input.erase(0, end + 4);
+
+    std::string_view lines(request);
+    size_t line_end = lines.find("\r\n");
+    std::string_view request_line = lines.substr(0, line_end);
+    lines.remove_prefix(line_end + 2);
+
+    std::string_view method = request_line.substr(0, request_line.find(' '));
+    std::string_view path = request_line.substr(std::min(request_line.size(), method.size() + 1));
+    path = path.substr(0, path.find(' '));
+
+    std::string host, origin, upgrade, key;
+    while (!lines.empty())
+    {
+        line_end = lines.find("\r\n");
+        std::string_view line = lines.substr(0, line_end);
+        lines.remove_prefix(std::min(lines.size(), line_end + 2));
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos)
+        {
+            continue;
+        }
+        std::string name = toLower(trim(line.substr(0, colon)));
+        std::string_view value = trim(line.substr(colon + 1));
+        if (name == "host")
+        {
+            host = value;
+        }
+        else if (name == "origin")
+        {
+            origin = value;
+        }
+        else if (name == "upgrade")
+        {
+            upgrade = toLower(value);
+        }
+        else if (name == "sec-websocket-key")
+        {
+            key = value;
+        }
+    }
+
+    client.close_after_write = true;
+    if (method != "GET")
+    {
+        client.output += httpResponse("405 Method Not Allowed", "text/plain", "Method not allowed\n");
+    }
+    else if (path == "/" || path == "/index.html")
+    {
+        client.output += m_page_response;
+    }
+    else if (path != "/ws")
+    {
+        client.output += httpResponse("404 Not Found", "text/plain", "Not found\n");
+    }
+    else if (upgrade != "websocket" || key.empty())
+    {
+        client.output += httpResponse("400 Bad Request", "text/plain", "Expected a WebSocket upgrade\n");
+    }
+    else if (!origin.empty() && origin != "http://" + host && origin != "https://" + host)
+    {
+        // The pages of other sites, open in the browser of the operator, could otherwise drive the device
+        yCWarning(KEYBOARDJOYPAD) << "The web panel refused a WebSocket from the origin" << origin;
+        client.output += httpResponse("403 Forbidden", "text/plain", "Forbidden\n");
+    }
+    else
+    {
+        client.output += "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: "
+                         + webSocketAccept(key) + "\r\n\r\n";
+        client.close_after_write = false;
+        client.websocket = true;
+        m_number_of_websockets++;
+    }
+    if (client.close_after_write)
+    {
+        client.input.clear();
+    }
+    return true;
+}
+
+bool WebPanelServer::handleWebSocketFrames(Client& client)
+{
+    size_t offset = 0;
+    while (!client.close_after_write)
+    {
+        size_t available = client.input.size() - offset;
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(client.input.data()) + offset;
+        if (available < 2)
+        {
+            break;
+        }
+        bool fin = data[0] & 0x80;
+        uint8_t opcode = data[0] & 0x0F;
+        bool masked = data[1] & 0x80;
+        size_t length = data[1] & 0x7F;
+        size_t header = 2;
+        if (length == 127) //64 bits length, never within maxMessageSize
+        {
+            return false;
+        }
+        if (length == 126)
+        {
+            if (available < 4)
+            {
+                break;
+            }
+            length = (size_t{ data[2] } << 8) | size_t{ data[3] };
+            header = 4;
+        }
+        if (!masked || length > maxMessageSize) //The pages always mask their frames (RFC 6455)
+        {
+            return false;
+        }
+        if (available < header + 4 + length)
+        {
+            break;
+        }
+
+        const unsigned char* mask = data + header;
+        unsigned char* payload = reinterpret_cast<unsigned char*>(client.input.data()) + offset + header + 4;
+        for (size_t i = 0; i < length; ++i)
+        {
+            payload[i] ^= mask[i % 4];
+        }
+        offset += header + 4 + length;
+
+        switch (opcode)
+        {
+        case 0x2: //Binary
+            if (!fin)
+            {
+                return false;
+            }
+            handleEvents(client, payload, length);
+            break;
+        case 0x8: //Close, answered with the same status code
+            appendWebSocketFrame(client.output, 0x8, payload, std::min<size_t>(length, 2));
+            client.close_after_write = true;
+            break;
+        case 0x9: //Ping
+            if (length > 125)
+            {
+                return false;
+            }
+            appendWebSocketFrame(client.output, 0xA, payload, length);
+            break;
+        case 0xA: //Pong
+            break;
+        default: //Text and continuation frames are not used by the page
+            return false;
+        }
+    }
+    client.input.erase(0, client.close_after_write ? client.input.size() : offset);
+    return true;
+}
+
+bool WebPanelServer::writeToClient(Client& client)
+{
+    size_t sent_bytes = 0;
+    while (sent_bytes < client.output.size())
+    {
+        ssize_t sent = send(client.fd, client.output.data() + sent_bytes, client.output.size() - sent_bytes, sendFlags);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            return false;
+        }
+        sent_bytes += static_cast<size_t>(sent);
+    }
+    client.output.erase(0, sent_bytes);
+    return client.output.size() <= maxPendingOutput;
+}
+
+void WebPanelServer::run()
+{
+    std::vector<pollfd> fds;
+    std::vector<unsigned char> state_payload;
+    std::string state_message;
+    uint64_t highlighted_version = 0;
+
+    while (m_running)
+    {
+        fds.clear();
+        fds.push_back({ m_wake_pipe[0], POLLIN, 0 });
+        fds.push_back({ m_listen_fd, POLLIN, 0 });
+        for (const auto& client : m_clients)
+        {
+            fds.push_back({ client->fd, static_cast<short>(POLLIN | (client->output.empty() ? 0 : POLLOUT)), 0 });
+        }
+        if (poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            yCError(KEYBOARDJOYPAD) << "The web panel stopped, since poll failed:" << std::strerror(errno);
+            break;
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            char buffer[64];
+            while (read(m_wake_pipe[0], buffer, sizeof(buffer)) > 0)
+            {
+            }
+        }
+
+        // The clients accepted now are polled from the next iteration
+        size_t polled_clients = m_clients.size();
+        if (fds[1].revents & POLLIN)
+        {
+            acceptClients();
+        }
+        for (size_t i = 0; i < polled_clients; ++i)
+        {
+            if ((fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR)) && !readFromClient(*m_clients[i]))
+            {
+                m_clients[i]->closed = true;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_highlighted_version != highlighted_version)
+            {
+                state_payload.assign(1, WebPanelStateMessage);
+                state_payload.insert(state_payload.end(), m_highlighted.begin(), m_highlighted.end());
+                highlighted_version = m_highlighted_version;
+                state_message.clear();
+                appendWebSocketFrame(state_message, 0x2, state_payload.data(), state_payload.size());
+            }
+        }
+        // The frame is built once, and sent to each page that did not receive it yet
+        for (auto& client : m_clients)
+        {
+            if (highlighted_version != 0 && client->websocket && !client->close_after_write
+                && client->sent_highlighted_version != highlighted_version)
+            {
+                client->output += state_message;
+                client->sent_highlighted_version = highlighted_version;
+            }
+        }
+
+        for (auto& client : m_clients)
+        {
+            if (client->closed)
+            {
+                continue;
+            }
+            if (!client->output.empty() && !writeToClient(*client))
+            {
+                client->closed = true;
+            }
+            else if (client->output.empty() && client->close_after_write)
+            {
+                client->closed = true;
+            }
+        }
+
+        for (auto& client : m_clients)
+        {
+            if (client->closed)
+            {
+                releaseHeldInputs(*client);
+                if (client->websocket)
+                {
+                    m_number_of_websockets--;
+                }
+                ::close(client->fd);
+            }
+        }
+        m_clients.erase(std::remove_if(m_clients.begin(), m_clients.end(), [](const auto& client) { return client->closed; }),
+                        m_clients.end());
+    }
+
+    for (auto& client : m_clients)
+    {
+        releaseHeldInputs(*client);
+        ::close(client->fd);
+    }
+    m_clients.clear();
+    m_number_of_websockets = 0;
+}
+
+#else
+
+bool WebPanelServer::open(const std::string&, int, const std::vector<WebPanelTable>&, size_t)
+{
+    yCError(KEYBOARDJOYPAD) << "The web panel is available only on POSIX systems.";
+    return false;
+}
+
+void WebPanelServer::close()
+{
+}
+
+int WebPanelServer::port() const
+{
+    return -1;
+}
+
+void WebPanelServer::wake()
+{
+}
+
+#endif // _WIN32
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_KEYBOARDJOYPADWEBPANEL_H
+#define YARP_DEV_KEYBOARDJOYPADWEBPANEL_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Web panel protocol.
+ *
+ * The page served at "/" mirrors the sticks and the buttons of the device, and opens a WebSocket at "/ws".
+ * All the messages are binary frames:
+ * - from the page, a sequence of 4 bytes events: the type, 1 if pressed and 0 if released, and the index as
+ *   16 bits little endian. With WebPanelEventType::KEY the index is the ImGuiKey, with WebPanelEventType::BUTTON
+ *   it is the index of the button in the mapping table.
+ * - from the device, the type WebPanelStateMessage followed by a byte per button, 1 if it is highlighted.
+ */
+enum class WebPanelEventType : uint8_t
+{
+    KEY = 1,
+    BUTTON = 2,
+};
+
+constexpr uint8_t WebPanelStateMessage = 1;
+
+struct WebPanelEvent
+{
+    WebPanelEventType type;
+    bool down;
+    uint16_t index;
+};
+
+struct WebPanelButton
+{
+    std::string label;
+    uint32_t button; //Index in the mapping table
+    int col;
+};
+
+// A table of buttons, as shown in the GUI
+struct WebPanelTable
+{
+    std::string name;
+    int columns;
+    std::vector<std::vector<WebPanelButton>> rows;
+};
+
+/**
+ * Embedded HTTP and WebSocket server of the web panel, running on its own thread.
+ *
+ * The events received from the pages are buffered, and taken by the thread sampling the inputs. When a page
+ * disconnects, the release of the keys and of the buttons it was keeping pressed is queued, so that a lost
+ * connection does not leave an output active. There is no authentication: the server should be bound to a
+ * trusted network.
+ */
+class WebPanelServer
+{
+    struct Client;
+
+    int m_listen_fd{ -1 };
+    int m_wake_pipe[2]{ -1, -1 };
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+    std::string m_page_response; //Complete HTTP response with the page
+    uint32_t m_number_of_buttons{ 0 };
+    std::vector<std::unique_ptr<Client>> m_clients; //Accessed only by the server thread
+    std::atomic<size_t> m_number_of_websockets{ 0 };
+
+    std::mutex m_mutex;
+    std::vector<WebPanelEvent> m_events; //Guarded by m_mutex
+    std::vector<uint8_t> m_highlighted; //Guarded by m_mutex
+    uint64_t m_highlighted_version{ 0 }; //Guarded by m_mutex
+    uint64_t m_dropped_events{ 0 }; //Guarded by m_mutex
+
+    void run();
+    void wake();
+    void acceptClients();
+    bool readFromClient(Client& client);
+    bool handleHttpRequest(Client& client);
+    bool handleWebSocketFrames(Client& client);
+    void handleEvents(Client& client, const unsigned char* payload, size_t size);
+    void releaseHeldInputs(Client& client);
+    bool writeToClient(Client& client);
+
+public:
+    WebPanelServer();
+    WebPanelServer(const WebPanelServer&) = delete;
+    WebPanelServer& operator=(const WebPanelServer&) = delete;
+
+    ~WebPanelServer();
+
+    // Starts serving the page with the given tables. Port 0 binds an ephemeral port.
+    bool open(const std::string& address, int port, const std::vector<WebPanelTable>& tables, size_t number_of_buttons);
+
+    // Disconnects the pages and stops the thread
+    void close();
+
+    bool isOpen() const;
+
+    // The port the server is listening on
+    int port() const;
+
+    // Whether at least a page is connected through the WebSocket
+    bool hasClients() const;
+
+    // Moves the events received since the last call at the end of events
+    void takeEvents(std::vector<WebPanelEvent>& events);
+
+    // Sends the highlighted buttons to the pages, if they changed since the last call
+    void publishHighlighted(const std::vector<uint8_t>& highlighted);
+
+    // Number of events dropped since the buffer was full, i.e. not taken for a long time
+    uint64_t droppedEvents();
+};
+
+#endif // YARP_DEV_KEYBOARDJOYPADWEBPANEL_H
@@ -0,0 +1,789 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+// The device implementation is included directly, so that the benchmarks can access ButtonState and the Impl class
+#include <KeyboardJoypad.cpp>
+
+#include <yarp/os/Network.h>
+#include <yarp/os/Property.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+
+// Heap allocations are counted only while enabled, to check that the steady-state update does not allocate
+static std::atomic<bool> countAllocations{ false };
+static std::atomic<size_t> numberOfAllocations{ 0 };
+
+void* operator new(size_t size)
+{
+    if (countAllocations.load(std::memory_order_relaxed))
+    {
+        numberOfAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* pointer = std::malloc(size ? size : 1);
+    if (!pointer)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+// ImGui allocates with malloc by default, bypassing operator new, hence its allocations are counted separately
+static void* imGuiAllocate(size_t size, void*)
+{
+    if (countAllocations.load(std::memory_order_relaxed))
+    {
+        numberOfAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    return std::malloc(size);
+}
+
+static void imGuiFree(void* pointer, void*)
+{
+    std::free(pointer);
+}
+
+struct LayoutSize
+{
+    const char* name;
+    size_t buttons;
+    int joypad_axes;
+    int joypad_buttons;
+};
+
+// From the default configuration, with only the 4 axes, up to hundreds of buttons read from many joypads,
+// emulated with a single wide virtual joypad
+static const std::vector<LayoutSize> layoutSizes = {
+    { .name = "default", .buttons = 0, .joypad_axes = 4, .joypad_buttons = 16 },
+    { .name = "32 buttons", .buttons = 32, .joypad_axes = 8, .joypad_buttons = 32 },
+    { .name = "256 buttons", .buttons = 256, .joypad_axes = 32, .joypad_buttons = 128 },
+    { .name = "1024 buttons", .buttons = 1024, .joypad_axes = 128, .joypad_buttons = 512 },
+};
+
+static const std::vector<size_t> readerThreads = { 1, 2, 4, 8, 16 };
+
+static double minimumBenchmarkDuration = 0.5; //seconds
+
+// The 99th percentile of the getters latency while rendering can exceed the idle one by this factor plus this offset,
+// to absorb the scheduling noise of the additional GUI thread, but not a wait on the device mutex during a frame
+static constexpr double contentionToleranceFactor = 2.0;
+static constexpr double contentionToleranceOffset = 5e-6; //seconds
+
+class KeyboardJoypadBenchmarks
+{
+public:
+    struct OffscreenOptions
+    {
+        std::string context_api = "egl";
+        std::string golden; //PPM file
+        std::string failed_frame; //Where the frame is written if it does not match the golden one
+        bool write_golden = false;
+        bool per_frame = false;
+        double tolerance = 0.005; //Fraction of the pixels
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static yarp::dev::KeyboardJoypad::Impl& impl(yarp::dev::KeyboardJoypad& device)
+    {
+        return *device.m_pimpl;
+    }
+
+    // Runs the function in batches until the minimum duration is reached, and returns the average time per call
+    static double measure(const std::function<void()>& function)
+    {
+        for (size_t i = 0; i < 10; ++i) //Warm up
+        {
+            function();
+        }
+
+        size_t iterations = 0;
+        size_t batch = 1;
+        Clock::time_point start = Clock::now();
+        double elapsed = 0;
+        while (elapsed < minimumBenchmarkDuration)
+        {
+            for (size_t i = 0; i < batch; ++i)
+            {
+                function();
+            }
+            iterations += batch;
+            batch *= 2;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        return elapsed / static_cast<double>(iterations);
+    }
+
+    static void report(const std::string& benchmark, const std::string& layout, double seconds_per_operation)
+    {
+        std::printf("%-32s %-14s %12.1f ns/op\n", benchmark.c_str(), layout.c_str(), seconds_per_operation * 1e9);
+    }
+
+    static std::string buttonsConfiguration(size_t number_of_buttons, int joypad_buttons)
+    {
+        // Mix of single keys, joypad buttons and multiple keys, with the different button types
+        static const char* keys[] = { "A", "B", "C", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N", "O", "P",
+                                      "Q", "R", "T", "U", "V", "X", "Y", "Z", "0", "1", "2", "3", "4", "5" };
+        constexpr size_t number_of_keys = sizeof(keys) / sizeof(keys[0]);
+
+        std::string buttons = "(buttons (";
+        for (size_t i = 0; i < number_of_buttons; ++i)
+        {
+            std::string key = keys[i % number_of_keys];
+            std::string joypad_button = "J" + std::to_string(i % static_cast<size_t>(std::max(joypad_buttons, 1)));
+            switch (i % 3)
+            {
+            case 0:
+                buttons += "\"" + key + "\" ";
+                break;
+            case 1:
+                buttons += "\"" + joypad_button + "\" ";
+                break;
+            default:
+                buttons += "\"" + key + "-" + joypad_button + ":Button " + std::to_string(i) + "\" ";
+                break;
+            }
+        }
+        buttons += "))";
+        return buttons;
+    }
+
+    static bool openDevice(yarp::dev::KeyboardJoypad& device, const LayoutSize& layout, bool single_threaded)
+    {
+        yarp::os::Property cfg;
+        cfg.fromString("(headless) (input_backend programmatic) (input_period 0.001) (gui_period 0.001)"
+                       " (virtual_joypad_axes " + std::to_string(layout.joypad_axes) + ")"
+                       " (virtual_joypad_buttons " + std::to_string(layout.joypad_buttons) + ")"
+                       " (no_gui_thread " + (single_threaded ? "1" : "0") + ")"
+                       " " + buttonsConfiguration(layout.buttons, layout.joypad_buttons));
+        return device.open(cfg);
+    }
+
+    // Null renderer: the frames are built by ImGui, but never drawn
+    static void createImGuiContext()
+    {
+        ImGui::CreateContext();
+        ImGuiIO& io = ImGui::GetIO();
+        io.IniFilename = nullptr;
+        io.DisplaySize = ImVec2(1920, 1080);
+        io.DeltaTime = 1.0f / 60.0f;
+        unsigned char* pixels;
+        int width, height;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    }
+
+    static void syntheticInputs(yarp::dev::KeyboardJoypad& device, const LayoutSize& layout, size_t step)
+    {
+        device.setKey("A", step % 2 == 0);
+        device.setKey("W", step % 4 < 2);
+        device.setJoypadAxis(static_cast<unsigned int>(step % static_cast<size_t>(layout.joypad_axes)),
+                             static_cast<float>(step % 200) / 100.0f - 1.0f);
+        device.setJoypadButton(static_cast<unsigned int>(step % static_cast<size_t>(layout.joypad_buttons)), step % 3 == 0);
+    }
+
+    static void benchmarkLayout(const LayoutSize& layout)
+    {
+        yarp::dev::KeyboardJoypad device;
+        if (!openDevice(device, layout, true))
+        {
+            std::fprintf(stderr, "Failed to open the device with the layout \"%s\".\n", layout.name);
+            std::exit(EXIT_FAILURE);
+        }
+        yarp::dev::KeyboardJoypad::Impl& device_impl = impl(device);
+        {
+            std::lock_guard<std::mutex> lock(device_impl.mutex);
+            device_impl.initialize();
+        }
+        // Set before creating the context, so that all its memory goes through the counting functions
+        ImGui::SetAllocatorFunctions(imGuiAllocate, imGuiFree);
+        createImGuiContext();
+
+        size_t step = 0;
+
+        report("Impl::sampleInputs", layout.name, measure([&]()
+        {
+            syntheticInputs(device, layout, step++);
+            device_impl.sampleInputs();
+        }));
+
+        ButtonState& button = device_impl.buttons.rows.empty() ? device_impl.ctrl_button : device_impl.buttons.rows.front().front();
+        constexpr int buttons_per_frame = 100;
+        double button_time = measure([&]()
+        {
+            ImGui::NewFrame();
+            ImGui::Begin("ButtonState::render");
+            for (int i = 0; i < buttons_per_frame; ++i)
+            {
+                ImGui::PushID(i);
+                button.render(device_impl.mapping, device_impl.button_active_color, device_impl.button_inactive_color, ImVec2(100, 100));
+                ImGui::PopID();
+            }
+            ImGui::End();
+            ImGui::Render();
+        });
+        report("ButtonState::render", layout.name, button_time / buttons_per_frame);
+
+        if (!device_impl.buttons.rows.empty())
+        {
+            report("Impl::renderButtonsTable", layout.name, measure([&]()
+            {
+                ImGui::NewFrame();
+                device_impl.prepareWindow(ImVec2(0, 0), device_impl.buttons.name);
+                device_impl.renderButtonsTable(device_impl.buttons);
+                ImGui::End();
+                ImGui::Render();
+            }));
+
+            // Only the rows in a 800 pixels high view are submitted
+            report("Impl::renderButtonsTable (scrolling)", layout.name, measure([&]()
+            {
+                ImGui::NewFrame();
+                device_impl.prepareWindow(ImVec2(0, 0), device_impl.buttons.name);
+                device_impl.renderButtonsTable(device_impl.buttons, 800.0f);
+                ImGui::End();
+                ImGui::Render();
+            }));
+        }
+
+        // Same as Impl::update(), with the null renderer in place of the OpenGL one
+        report("Impl::update", layout.name, measure([&]()
+        {
+            syntheticInputs(device, layout, step++);
+            std::lock_guard<std::mutex> lock(device_impl.mutex);
+            device_impl.sampleInputs();
+            device_impl.buildFrame();
+        }));
+
+        ImGui::DestroyContext();
+        device.close();
+    }
+
+    static void benchmarkGetters(const LayoutSize& layout)
+    {
+        yarp::dev::KeyboardJoypad device;
+        if (!openDevice(device, layout, false))
+        {
+            std::fprintf(stderr, "Failed to open the device with the layout \"%s\".\n", layout.name);
+            std::exit(EXIT_FAILURE);
+        }
+
+        unsigned int axes = 0, buttons = 0, sticks = 0;
+        device.getAxisCount(axes);
+        device.getButtonCount(buttons);
+        device.getStickCount(sticks);
+
+        for (size_t number_of_threads : readerThreads)
+        {
+            std::atomic<bool> stop{ false };
+            std::atomic<size_t> total_reads{ 0 };
+            std::vector<std::thread> threads;
+            for (size_t t = 0; t < number_of_threads; ++t)
+            {
+                threads.emplace_back([&, t]()
+                {
+                    yarp::sig::Vector stick;
+                    size_t reads = 0;
+                    double axis_value;
+                    float button_value;
+                    for (size_t i = t; !stop.load(std::memory_order_relaxed); ++i)
+                    {
+                        device.getAxis(static_cast<unsigned int>(i % std::max(axes, 1u)), axis_value);
+                        if (buttons)
+                        {
+                            device.getButton(static_cast<unsigned int>(i % buttons), button_value);
+                        }
+                        device.getStick(static_cast<unsigned int>(i % std::max(sticks, 1u)), stick, yarp::dev::IJoypadController::JypCtrlcoord_CARTESIAN);
+                        reads += buttons ? 3 : 2;
+                    }
+                    total_reads += reads;
+                });
+            }
+
+            // The inputs keep changing while reading, as on the robot
+            Clock::time_point start = Clock::now();
+            size_t step = 0;
+            while (std::chrono::duration<double>(Clock::now() - start).count() < minimumBenchmarkDuration)
+            {
+                syntheticInputs(device, layout, step++);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            stop = true;
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+            double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+            report("getters, " + std::to_string(number_of_threads) + " readers", layout.name,
+                   elapsed * static_cast<double>(number_of_threads) / static_cast<double>(total_reads));
+        }
+
+        device.close();
+    }
+
+    // Latency of each getter call while a thread keeps building GUI frames holding the device mutex, as the GUI thread
+    // does, compared with the one without the frames. The getters read the outputs snapshot, hence the latency is
+    // expected to stay flat, and the benchmark fails if the 99th percentile exceeds the tolerance with respect to the
+    // idle one. Each reader records in its own histogram, to avoid adding contention on the counters.
+    static int benchmarkContention(const LayoutSize& layout)
+    {
+        yarp::dev::KeyboardJoypad device;
+        if (!openDevice(device, layout, false))
+        {
+            std::fprintf(stderr, "Failed to open the device with the layout \"%s\".\n", layout.name);
+            return EXIT_FAILURE;
+        }
+        yarp::dev::KeyboardJoypad::Impl& device_impl = impl(device);
+
+        unsigned int axes = 0, buttons = 0, sticks = 0;
+        device.getAxisCount(axes);
+        device.getButtonCount(buttons);
+        device.getStickCount(sticks);
+
+        int result = EXIT_SUCCESS;
+        std::vector<double> idle_p99(readerThreads.size(), 0.0);
+        for (bool rendering : { false, true })
+        {
+            for (size_t r = 0; r < readerThreads.size(); ++r)
+            {
+                size_t number_of_threads = readerThreads[r];
+                std::atomic<bool> stop{ false };
+                std::vector<std::unique_ptr<LatencyHistogram>> histograms;
+                std::vector<std::thread> threads;
+                for (size_t t = 0; t < number_of_threads; ++t)
+                {
+                    histograms.push_back(std::make_unique<LatencyHistogram>());
+                }
+                for (size_t t = 0; t < number_of_threads; ++t)
+                {
+                    threads.emplace_back([&, t]()
+                    {
+                        LatencyHistogram& histogram = *histograms[t];
+                        yarp::sig::Vector stick;
+                        double axis_value;
+                        float button_value;
+                        for (size_t i = t; !stop.load(std::memory_order_relaxed); ++i)
+                        {
+                            int64_t start = LatencyStatistics::now();
+                            device.getAxis(static_cast<unsigned int>(i % std::max(axes, 1u)), axis_value);
+                            int64_t end = LatencyStatistics::now();
+                            histogram.record(end - start);
+                            if (buttons)
+                            {
+                                start = end;
+                                device.getButton(static_cast<unsigned int>(i % buttons), button_value);
+                                end = LatencyStatistics::now();
+                                histogram.record(end - start);
+                            }
+                            start = end;
+                            device.getStick(static_cast<unsigned int>(i % std::max(sticks, 1u)), stick, yarp::dev::IJoypadController::JypCtrlcoord_CARTESIAN);
+                            histogram.record(LatencyStatistics::now() - start);
+                        }
+                    });
+                }
+
+                // The frames are built without pauses, with the null renderer, while the GUI thread keeps sampling the inputs
+                std::atomic<size_t> frames{ 0 };
+                std::thread gui;
+                if (rendering)
+                {
+                    gui = std::thread([&]()
+                    {
+                        createImGuiContext();
+                        while (!stop.load(std::memory_order_relaxed))
+                        {
+                            std::lock_guard<std::mutex> lock(device_impl.mutex);
+                            device_impl.buildFrame();
+                            frames++;
+                        }
+                        ImGui::DestroyContext();
+                    });
+                }
+
+                Clock::time_point start = Clock::now();
+                size_t step = 0;
+                while (std::chrono::duration<double>(Clock::now() - start).count() < minimumBenchmarkDuration)
+                {
+                    syntheticInputs(device, layout, step++);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                stop = true;
+                for (auto& thread : threads)
+                {
+                    thread.join();
+                }
+                if (gui.joinable())
+                {
+                    gui.join();
+                }
+                double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+                LatencyHistogram total;
+                for (const auto& histogram : histograms)
+                {
+                    total.add(*histogram);
+                }
+                LatencyHistogram::Summary summary = total.summary(false);
+                std::string benchmark = std::string(rendering ? "getters rendering, " : "getters idle, ") + std::to_string(number_of_threads) + " readers";
+                std::printf("%-32s %-14s p50 %8.1f ns  p99 %8.1f ns  max %10.1f ns  (%.0f frames/s)\n", benchmark.c_str(), layout.name,
+                            summary.p50 * 1e9, summary.p99 * 1e9, summary.max * 1e9, static_cast<double>(frames) / elapsed);
+
+                if (!rendering)
+                {
+                    idle_p99[r] = summary.p99;
+                    continue;
+                }
+                double tolerance = contentionToleranceFactor * idle_p99[r] + contentionToleranceOffset;
+                if (summary.p99 > tolerance)
+                {
+                    std::fprintf(stderr, "The getters p99 while rendering (%.1f ns) exceeds the tolerance (%.1f ns) with %zu readers "
+                                 "and the layout \"%s\".\n", summary.p99 * 1e9, tolerance * 1e9, number_of_threads, layout.name);
+                    result = EXIT_FAILURE;
+                }
+            }
+        }
+
+        device.close();
+        return result;
+    }
+
+    // Runs the update on the largest layout, and fails if any allocation happens after the first frames
+    static int checkAllocations(size_t number_of_frames)
+    {
+        const LayoutSize& layout = layoutSizes.back();
+        yarp::dev::KeyboardJoypad device;
+        if (!openDevice(device, layout, true))
+        {
+            std::fprintf(stderr, "Failed to open the device with the layout \"%s\".\n", layout.name);
+            return EXIT_FAILURE;
+        }
+        yarp::dev::KeyboardJoypad::Impl& device_impl = impl(device);
+        {
+            std::lock_guard<std::mutex> lock(device_impl.mutex);
+            device_impl.initialize();
+        }
+        // Set before creating the context, so that all its memory goes through the counting functions
+        ImGui::SetAllocatorFunctions(imGuiAllocate, imGuiFree);
+        createImGuiContext();
+
+        auto update = [&](size_t step, bool count)
+        {
+            // The inputs are injected outside the counted region, since setKey converts the key name
+            syntheticInputs(device, layout, step);
+            std::lock_guard<std::mutex> lock(device_impl.mutex);
+            countAllocations = count;
+            device_impl.sampleInputs();
+            device_impl.buildFrame();
+            countAllocations = false;
+        };
+
+        // The first frames fill the reused buffers and the ImGui internal storage
+        constexpr size_t warm_up_frames = 100;
+        for (size_t i = 0; i < warm_up_frames; ++i)
+        {
+            update(i, false);
+        }
+
+        numberOfAllocations = 0;
+        for (size_t i = 0; i < number_of_frames; ++i)
+        {
+            update(warm_up_frames + i, true);
+        }
+        size_t allocations = numberOfAllocations;
+
+        ImGui::DestroyContext();
+        device.close();
+
+        if (allocations != 0)
+        {
+            std::fprintf(stderr, "%zu heap allocations in %zu frames with the layout \"%s\".\n", allocations, number_of_frames, layout.name);
+            return EXIT_FAILURE;
+        }
+        std::printf("No heap allocations in %zu frames with the layout \"%s\".\n", number_of_frames, layout.name);
+        return EXIT_SUCCESS;
+    }
+
+    // Binary PPM, dropping the alpha channel
+    static bool writePpm(const std::string& file_name, const std::vector<unsigned char>& rgba, int width, int height)
+    {
+        std::FILE* file = std::fopen(file_name.c_str(), "wb");
+        if (!file)
+        {
+            return false;
+        }
+        std::fprintf(file, "P6\n%d %d\n255\n", width, height);
+        for (size_t i = 0; i + 3 < rgba.size(); i += 4)
+        {
+            std::fwrite(&rgba[i], 1, 3, file);
+        }
+        return std::fclose(file) == 0;
+    }
+
+    static bool readPpm(const std::string& file_name, std::vector<unsigned char>& rgb, int& width, int& height)
+    {
+        std::FILE* file = std::fopen(file_name.c_str(), "rb");
+        if (!file)
+        {
+            return false;
+        }
+        int max_value = 0;
+        bool ok = std::fscanf(file, "P6 %d %d %d", &width, &height, &max_value) == 3 && max_value == 255
+                  && width > 0 && height > 0 && std::fgetc(file) != EOF;
+        if (ok)
+        {
+            rgb.resize(static_cast<size_t>(width) * static_cast<size_t>(height) * 3);
+            ok = std::fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+        }
+        std::fclose(file);
+        return ok;
+    }
+
+    // Fraction of the pixels with at least a channel differing more than a small threshold, to ignore the rounding
+    // differences between the rasterizers. It is 1 if the sizes are different.
+    static double differentPixels(const std::vector<unsigned char>& rgba, const std::vector<unsigned char>& rgb)
+    {
+        constexpr int threshold = 8;
+        size_t pixels = rgb.size() / 3;
+        if (rgba.size() != pixels * 4 || pixels == 0)
+        {
+            return 1.0;
+        }
+        size_t different = 0;
+        for (size_t i = 0; i < pixels; ++i)
+        {
+            for (size_t c = 0; c < 3; ++c)
+            {
+                if (std::abs(static_cast<int>(rgba[4 * i + c]) - static_cast<int>(rgb[3 * i + c])) > threshold)
+                {
+                    ++different;
+                    break;
+                }
+            }
+        }
+        return static_cast<double>(different) / static_cast<double>(pixels);
+    }
+
+    // Draws the GUI with the OpenGL renderer in an offscreen framebuffer, reporting the per-frame timings.
+    // The last frame is compared with the golden image, or written to it. The timings and the frame rate shown
+    // in the GUI change at every run, hence a small fraction of different pixels is tolerated.
+    static int renderOffscreen(size_t number_of_frames, const OffscreenOptions& options)
+    {
+        const LayoutSize& layout = layoutSizes[1];
+        yarp::dev::KeyboardJoypad device;
+        yarp::os::Property cfg;
+        cfg.fromString("(offscreen) (offscreen_context_api " + options.context_api + ")"
+                       " (no_gui_thread 1) (input_period 0.001) (gui_period 0.001)"
+                       " (window_width 1280) (window_height 720) "
+                       + buttonsConfiguration(layout.buttons, layout.joypad_buttons));
+        if (!device.open(cfg))
+        {
+            std::fprintf(stderr, "Failed to open the device for the offscreen rendering.\n");
+            return EXIT_FAILURE;
+        }
+        yarp::dev::KeyboardJoypad::Impl& device_impl = impl(device);
+        {
+            std::lock_guard<std::mutex> lock(device_impl.mutex);
+            if (!device_impl.initialize())
+            {
+                std::fprintf(stderr, "Failed to initialize the offscreen rendering.\n");
+                device.close();
+                return EXIT_FAILURE;
+            }
+            // The saved positions of the windows would change the frames
+            ImGui::GetIO().IniFilename = nullptr;
+        }
+
+        double build_time = 0, imgui_render_time = 0, draw_time = 0;
+        double max_build_time = 0, max_imgui_render_time = 0, max_draw_time = 0;
+        for (size_t i = 0; i < number_of_frames; ++i)
+        {
+            // Only keys, the null platform of GLFW has no joypads
+            device.setKey("A", i % 2 == 0);
+            device.setKey("W", i % 4 < 2);
+            std::lock_guard<std::mutex> lock(device_impl.mutex);
+            device_impl.sampleInputs();
+            device_impl.render();
+            build_time += device_impl.frame_build_time;
+            imgui_render_time += device_impl.frame_imgui_render_time;
+            draw_time += device_impl.frame_draw_time;
+            max_build_time = std::max(max_build_time, device_impl.frame_build_time);
+            max_imgui_render_time = std::max(max_imgui_render_time, device_impl.frame_imgui_render_time);
+            max_draw_time = std::max(max_draw_time, device_impl.frame_draw_time);
+            if (options.per_frame)
+            {
+                std::printf("frame %6zu build %8.3f ms  ImGui::Render %8.3f ms  RenderDrawData %8.3f ms\n", i,
+                            device_impl.frame_build_time * 1e3, device_impl.frame_imgui_render_time * 1e3,
+                            device_impl.frame_draw_time * 1e3);
+            }
+        }
+        double frames = static_cast<double>(std::max<size_t>(number_of_frames, 1));
+        std::printf("%-32s %-14s %9.3f ms/frame (max %.3f)\n", "offscreen build", layout.name, build_time / frames * 1e3, max_build_time * 1e3);
+        std::printf("%-32s %-14s %9.3f ms/frame (max %.3f)\n", "offscreen ImGui::Render", layout.name, imgui_render_time / frames * 1e3, max_imgui_render_time * 1e3);
+        std::printf("%-32s %-14s %9.3f ms/frame (max %.3f)\n", "offscreen RenderDrawData", layout.name, draw_time / frames * 1e3, max_draw_time * 1e3);
+
+        std::vector<unsigned char> frame;
+        int width = 0, height = 0;
+        bool read = false;
+        {
+            std::lock_guard<std::mutex> lock(device_impl.mutex);
+            read = device_impl.readOffscreenFrame(frame, width, height);
+        }
+        device.close();
+        if (!read)
+        {
+            std::fprintf(stderr, "Failed to read the offscreen frame.\n");
+            return EXIT_FAILURE;
+        }
+
+        if (options.golden.empty())
+        {
+            return EXIT_SUCCESS;
+        }
+        if (options.write_golden)
+        {
+            if (!writePpm(options.golden, frame, width, height))
+            {
+                std::fprintf(stderr, "Failed to write the golden frame %s.\n", options.golden.c_str());
+                return EXIT_FAILURE;
+            }
+            std::printf("Written the golden frame %s (%dx%d).\n", options.golden.c_str(), width, height);
+            return EXIT_SUCCESS;
+        }
+
+        std::vector<unsigned char> golden;
+        int golden_width = 0, golden_height = 0;
+        if (!readPpm(options.golden, golden, golden_width, golden_height))
+        {
+            std::fprintf(stderr, "Failed to read the golden frame %s.\n", options.golden.c_str());
+            return EXIT_FAILURE;
+        }
+        if (golden_width != width || golden_height != height)
+        {
+            std::fprintf(stderr, "The frame is %dx%d, while the golden frame is %dx%d.\n", width, height, golden_width, golden_height);
+            return EXIT_FAILURE;
+        }
+        double different = differentPixels(frame, golden);
+        if (different > options.tolerance)
+        {
+            std::fprintf(stderr, "%.2f%% of the pixels differ from the golden frame %s (tolerance %.2f%%).\n",
+                         different * 100.0, options.golden.c_str(), options.tolerance * 100.0);
+            if (!options.failed_frame.empty())
+            {
+                writePpm(options.failed_frame, frame, width, height);
+            }
+            return EXIT_FAILURE;
+        }
+        std::printf("%.2f%% of the pixels differ from the golden frame %s.\n", different * 100.0, options.golden.c_str());
+        return EXIT_SUCCESS;
+    }
+
+public:
+    static int run(size_t allocation_check_frames, size_t offscreen_frames, const OffscreenOptions& offscreen_options, bool contention)
+    {
+        if (contention)
+        {
+            int result = EXIT_SUCCESS;
+            for (const auto& layout : layoutSizes)
+            {
+                if (benchmarkContention(layout) != EXIT_SUCCESS)
+                {
+                    result = EXIT_FAILURE;
+                }
+            }
+            return result;
+        }
+        if (allocation_check_frames > 0)
+        {
+            return checkAllocations(allocation_check_frames);
+        }
+        if (offscreen_frames > 0)
+        {
+            return renderOffscreen(offscreen_frames, offscreen_options);
+        }
+        for (const auto& layout : layoutSizes)
+        {
+            benchmarkLayout(layout);
+        }
+        for (const auto& layout : layoutSizes)
+        {
+            benchmarkGetters(layout);
+        }
+        return EXIT_SUCCESS;
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    size_t allocation_check_frames = 0;
+    size_t offscreen_frames = 0;
+    bool contention = false;
+    KeyboardJoypadBenchmarks::OffscreenOptions offscreen_options;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--check-allocations") == 0 && i + 1 < argc)
+        {
+            allocation_check_frames = static_cast<size_t>(std::atol(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--offscreen") == 0 && i + 1 < argc)
+        {
+            offscreen_frames = static_cast<size_t>(std::atol(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--context-api") == 0 && i + 1 < argc)
+        {
+            offscreen_options.context_api = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--golden") == 0 && i + 1 < argc)
+        {
+            offscreen_options.golden = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--golden-tolerance") == 0 && i + 1 < argc)
+        {
+            offscreen_options.tolerance = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--failed-frame") == 0 && i + 1 < argc)
+        {
+            offscreen_options.failed_frame = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--write-golden") == 0)
+        {
+            offscreen_options.write_golden = true;
+        }
+        else if (std::strcmp(argv[i], "--per-frame") == 0)
+        {
+            offscreen_options.per_frame = true;
+        }
+        else if (std::strcmp(argv[i], "--contention") == 0)
+        {
+            contention = true;
+        }
+        else
+        {
+            minimumBenchmarkDuration = std::atof(argv[i]);
+        }
+    }
+
+    yarp::os::Network yarp;
+    return KeyboardJoypadBenchmarks::run(allocation_check_frames, offscreen_frames, offscreen_options, contention);
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#include <KeyboardJoypadAxisPipeline.h>
+
+#include <KeyboardJoypadTest.h>
+
+#include <cmath>
+
+// Feeds a constant axis value for the given duration, sampled at 100 Hz, and returns the last conditioned value
+static float condition(JoypadAxesConditioning& conditioning, float value, float deadzone, double duration)
+{
+    std::vector<float> input(1, value);
+    std::vector<float> output;
+    for (double t = 0.0; t <= duration; t += 0.01)
+    {
+        conditioning.apply(input, deadzone, t, output);
+    }
+    return output[0];
+}
+
+// A stick resting off center is centered also without a deadzone
+static void testCenteringWithoutDeadzone()
+{
+    JoypadAxesConditioning conditioning;
+    conditioning.configure(false, 0.1, 0.1f, {});
+    KEYBOARD_JOYPAD_CHECK(std::abs(condition(conditioning, 0.05f, 0.0f, 2.0)) < 1e-3f);
+}
+
+// An axis moved beyond the centering window is not considered at rest
+static void testNoCenteringOutsideWindow()
+{
+    JoypadAxesConditioning conditioning;
+    conditioning.configure(false, 0.1, 0.1f, {});
+    KEYBOARD_JOYPAD_CHECK(condition(conditioning, 0.5f, 0.0f, 2.0) == 0.5f);
+}
+
+int main()
+{
+    testCenteringWithoutDeadzone();
+    testNoCenteringOutsideWindow();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#include <KeyboardJoypadMapping.h>
+
+#include <KeyboardJoypadTest.h>
+
+// A stick button and a regular button of the buttons table, with Ctrl as hold button, as compiled by the device
+struct HoldMapping
+{
+    MappingTable mapping;
+    KeyboardState keyboard;
+    std::vector<float> joypad_axis_values;
+    std::vector<bool> joypad_button_values;
+    std::vector<double> axes_values = std::vector<double>(1, 0.0);
+    std::vector<double> buttons_values = std::vector<double>(1, 0.0);
+
+    HoldMapping()
+    {
+        uint32_t w = mapping.addButton(ButtonType::REGULAR, false);
+        mapping.addKey(w, ImGuiKey_W);
+        mapping.addOutput(w, MappingOutput::AXES, 0, 1);
+
+        uint32_t ctrl = mapping.addButton(ButtonType::REGULAR, false);
+        mapping.addKey(ctrl, ImGuiKey_LeftCtrl);
+        mapping.setHoldButton(ctrl);
+
+        uint32_t a = mapping.addButton(ButtonType::REGULAR, true);
+        mapping.addKey(a, ImGuiKey_A);
+        mapping.addOutput(a, MappingOutput::BUTTONS, 0, 1);
+    }
+
+    void sample()
+    {
+        keyboard.applyQueuedEvents();
+        mapping.evaluate(keyboard, 0.1f, joypad_axis_values, joypad_button_values, axes_values, buttons_values);
+        keyboard.clearEdges();
+    }
+
+    void key(ImGuiKey key, bool down)
+    {
+        keyboard.setKeyDown(key, down);
+        sample();
+    }
+};
+
+// The sticks are not affected by the hold button, hence they return to zero when released
+static void testStickIgnoresHold()
+{
+    HoldMapping test;
+    test.key(ImGuiKey_LeftCtrl, true);
+    test.key(ImGuiKey_W, true);
+    KEYBOARD_JOYPAD_CHECK(test.axes_values[0] == 1.0);
+    test.key(ImGuiKey_W, false);
+    KEYBOARD_JOYPAD_CHECK(test.axes_values[0] == 0.0);
+    test.key(ImGuiKey_LeftCtrl, false);
+    KEYBOARD_JOYPAD_CHECK(test.axes_values[0] == 0.0);
+}
+
+// A button of the buttons table pressed while holding Ctrl stays active until pressed again
+static void testButtonToggledWithHold()
+{
+    HoldMapping test;
+    test.key(ImGuiKey_LeftCtrl, true);
+    test.key(ImGuiKey_A, true);
+    test.key(ImGuiKey_A, false);
+    KEYBOARD_JOYPAD_CHECK(test.buttons_values[0] == 1.0);
+    test.key(ImGuiKey_A, true);
+    test.key(ImGuiKey_A, false);
+    KEYBOARD_JOYPAD_CHECK(test.buttons_values[0] == 0.0);
+}
+
+int main()
+{
+    testStickIgnoresHold();
+    testButtonToggledWithHold();
+    return EXIT_SUCCESS;
+}
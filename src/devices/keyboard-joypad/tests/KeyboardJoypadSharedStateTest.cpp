@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#include <KeyboardJoypadSharedState.h>
+#include <KeyboardJoypadSharedStateWriter.h>
+
+#include <KeyboardJoypadTest.h>
+
+#include <functional>
+#include <string>
+
+static const std::string segment_name = "/keyboard_joypad_shared_state_test_" + std::to_string(getpid());
+
+// A segment with two axes, one button and a stick with two values, mapped writable to corrupt its header
+struct CorruptedSegment
+{
+    SharedStateWriter writer;
+    void* memory{ nullptr };
+    size_t size{ 0 };
+
+    CorruptedSegment()
+    {
+        KEYBOARD_JOYPAD_CHECK(writer.open(segment_name, 4, 2, 1, { { 0.0, 0.0 } }));
+        int fd = shm_open(segment_name.c_str(), O_RDWR, 0);
+        KEYBOARD_JOYPAD_CHECK(fd >= 0);
+        struct stat info;
+        KEYBOARD_JOYPAD_CHECK(fstat(fd, &info) == 0);
+        size = static_cast<size_t>(info.st_size);
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        KEYBOARD_JOYPAD_CHECK(memory != MAP_FAILED);
+    }
+
+    ~CorruptedSegment()
+    {
+        munmap(memory, size);
+    }
+
+    SharedStateHeader& header()
+    {
+        return *static_cast<SharedStateHeader*>(memory);
+    }
+};
+
+static bool openCorrupted(const std::function<void(SharedStateHeader&)>& corrupt)
+{
+    CorruptedSegment segment;
+    corrupt(segment.header());
+    SharedStateReader reader;
+    return reader.open(segment_name);
+}
+
+static void testValidHeader()
+{
+    KEYBOARD_JOYPAD_CHECK(openCorrupted([](SharedStateHeader&) {}));
+}
+
+static void testSlotTooSmall()
+{
+    KEYBOARD_JOYPAD_CHECK(!openCorrupted([](SharedStateHeader& header) { header.slot_size = sizeof(SharedStateSlot); }));
+}
+
+static void testStickValuesOutsideSlot()
+{
+    KEYBOARD_JOYPAD_CHECK(!openCorrupted([](SharedStateHeader& header) { header.sticks_offsets[1] = 1000; }));
+}
+
+static void testDecreasingSticksOffsets()
+{
+    KEYBOARD_JOYPAD_CHECK(!openCorrupted([](SharedStateHeader& header) {
+        header.number_of_sticks = 2;
+        header.sticks_offsets[2] = 1;
+    }));
+}
+
+static void testSlotsOutsideMapping()
+{
+    KEYBOARD_JOYPAD_CHECK(!openCorrupted([](SharedStateHeader& header) { header.capacity = 5; }));
+}
+
+// The product of capacity and slot size wraps around to a small value
+static void testOverflowingSize()
+{
+    KEYBOARD_JOYPAD_CHECK(!openCorrupted([](SharedStateHeader& header) {
+        header.capacity = 4;
+        header.slot_size = (UINT64_MAX / 4 + 1) / SharedStateAlignment * SharedStateAlignment;
+    }));
+}
+
+int main()
+{
+    testValidHeader();
+    testSlotTooSmall();
+    testStickValuesOutsideSlot();
+    testDecreasingSticksOffsets();
+    testSlotsOutsideMapping();
+    testOverflowingSize();
+    return EXIT_SUCCESS;
+}
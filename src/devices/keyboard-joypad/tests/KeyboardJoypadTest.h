@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+ * All rights reserved.
+ *
+ * This software may be modified and distributed under the terms of the
+ * BSD-2-Clause license. See the accompanying LICENSE file for details.
+ */
+
+#ifndef YARP_DEV_KEYBOARDJOYPADTEST_H
+#define YARP_DEV_KEYBOARDJOYPADTEST_H
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal checks for the tests, without external dependencies. A failed check ends the test with an error.
+#define KEYBOARD_JOYPAD_CHECK(condition)                                                         \
+    do                                                                                           \
+    {                                                                                            \
+        if (!(condition))                                                                        \
+        {                                                                                        \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);   \
+            std::exit(EXIT_FAILURE);                                                             \
+        }                                                                                        \
+    } while (false)
+
+#endif // YARP_DEV_KEYBOARDJOYPADTEST_H
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+# Copyright (C) 2024 Istituto Italiano di Tecnologia (IIT)
+# All rights reserved.
+#
+# This software may be modified and distributed under the terms of the
+# BSD-2-Clause license. See the accompanying LICENSE file for details.
+
+"""
+Checks the web panel of a running keyboard-joypad device, using only the Python standard library.
+
+Usage: web_panel_check.py [--host HOST] [--port PORT] [--button INDEX]
+
+The device has to be running with web_panel_port set, and with at least INDEX + 1 buttons. The button is
+pressed and released during the check, hence the device should not drive anything. The check covers:
+- the page served at "/";
+- the WebSocket handshake at "/ws", and the refusal of the connections from other origins;
+- a button pressed by a page, seen as highlighted by another page;
+- the answer to a ping;
+- the release of the held button when the page pressing it disconnects;
+- the closing of the connection after a frame with a 64 bits length.
+"""
+
+import argparse
+import base64
+import hashlib
+import os
+import socket
+import sys
+import time
+
+WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+EVENT_BUTTON = 2
+STATE_MESSAGE = 1
+TIMEOUT = 2.0
+
+
+class Failure(Exception):
+    pass
+
+
+def check(condition, message):
+    if not condition:
+        raise Failure(message)
+    print("OK:", message)
+
+
+def http_request(host, port, path, headers=""):
+    connection = socket.create_connection((host, port), timeout=TIMEOUT)
+    connection.sendall(f"GET {path} HTTP/1.1\r\nHost: {host}:{port}\r\n{headers}\r\n".encode())
+    return connection
+
+
+def read_until_closed(connection):
+    data = b""
+    while True:
+        chunk = connection.recv(65536)
+        if not chunk:
+            return data
+        data += chunk
+
+
+def status_line(response):
+    return response.split(b"\r\n", 1)[0].decode(errors="replace")
+
+
+def masked_frame(opcode, payload):
+    assert len(payload) < 126
+    mask = os.urandom(4)
+    return bytes([0x80 | opcode, 0x80 | len(payload)]) + mask + bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+
+
+class WebSocket:
+    def __init__(self, host, port):
+        key = base64.b64encode(os.urandom(16)).decode()
+        self.connection = http_request(host, port, "/ws",
+                                       "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                                       f"Sec-WebSocket-Key: {key}\r\nSec-WebSocket-Version: 13\r\n"
+                                       f"Origin: http://{host}:{port}\r\n")
+        self.buffer = b""
+        while b"\r\n\r\n" not in self.buffer:
+            chunk = self.connection.recv(4096)
+            if not chunk:
+                raise Failure("the connection was closed during the handshake")
+            self.buffer += chunk
+        response, self.buffer = self.buffer.split(b"\r\n\r\n", 1)
+        accept = base64.b64encode(hashlib.sha1((key + WEBSOCKET_GUID).encode()).digest())
+        check(status_line(response).startswith("HTTP/1.1 101"), "WebSocket handshake accepted")
+        check(b"Sec-WebSocket-Accept: " + accept in response, "Sec-WebSocket-Accept computed correctly")
+
+    def send(self, opcode, payload):
+        self.connection.sendall(masked_frame(opcode, payload))
+
+    def send_button(self, index, down):
+        self.send(0x2, bytes([EVENT_BUTTON, 1 if down else 0, index & 0xFF, index >> 8]))
+
+    def receive(self):
+        # Returns (opcode, payload) of the next frame, or None if the connection is closed
+        while True:
+            if len(self.buffer) >= 2:
+                length = self.buffer[1] & 0x7F
+                header = 2
+                if length == 126 and len(self.buffer) >= 4:
+                    length = int.from_bytes(self.buffer[2:4], "big")
+                    header = 4
+                if length != 126 and len(self.buffer) >= header + length:
+                    opcode = self.buffer[0] & 0x0F
+                    payload = self.buffer[header:header + length]
+                    self.buffer = self.buffer[header + length:]
+                    return opcode, payload
+            chunk = self.connection.recv(65536)
+            if not chunk:
+                return None
+            self.buffer += chunk
+
+    def wait_highlighted(self, button, highlighted):
+        deadline = time.monotonic() + TIMEOUT
+        while time.monotonic() < deadline:
+            frame = self.receive()
+            if frame is None:
+                raise Failure("the connection was closed while waiting for the state")
+            opcode, payload = frame
+            if opcode == 0x2 and payload[:1] == bytes([STATE_MESSAGE]) and len(payload) > button + 1 \
+                    and payload[button + 1] == (1 if highlighted else 0):
+                return True
+        return False
+
+    def close(self):
+        self.connection.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Checks the web panel of a running keyboard-joypad device.")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, required=True)
+    parser.add_argument("--button", type=int, default=0, help="index of the button pressed during the check")
+    args = parser.parse_args()
+
+    try:
+        page = read_until_closed(http_request(args.host, args.port, "/"))
+        check(status_line(page).startswith("HTTP/1.1 200"), "page served at /")
+        check(b"<html" in page.lower(), "the page is HTML")
+
+        foreign = http_request(args.host, args.port, "/ws",
+                               "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                               "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n"
+                               "Origin: http://other.example\r\n")
+        check(status_line(read_until_closed(foreign)).startswith("HTTP/1.1 403"), "connection from another origin refused")
+
+        observer = WebSocket(args.host, args.port)
+        pressing = WebSocket(args.host, args.port)
+
+        pressing.send_button(args.button, True)
+        check(observer.wait_highlighted(args.button, True), "button pressed by a page highlighted on the other")
+
+        pressing.send(0x9, b"ping")
+        frame = pressing.receive()
+        while frame is not None and frame[0] != 0xA:
+            frame = pressing.receive()
+        check(frame is not None and frame[1] == b"ping", "ping answered with the same payload")
+
+        pressing.close()
+        check(observer.wait_highlighted(args.button, False), "button released when the page pressing it disconnected")
+
+        # A frame declaring a 64 bits length, followed by more bytes than a valid frame would need
+        observer.connection.sendall(bytes([0x82, 0x80 | 127]) + (8).to_bytes(8, "big") + os.urandom(4) + bytes(8))
+        frame = observer.receive()
+        while frame is not None and frame[0] != 0x8:
+            frame = observer.receive()
+        check(frame is None, "connection closed after a frame with a 64 bits length")
+        observer.close()
+    except (OSError, Failure) as error:
+        print("FAILED:", error)
+        return 1
+
+    print("All the checks passed.")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())